@@ -0,0 +1,30 @@
+#shader vertex
+#version 330 core
+#extension GL_ARB_shader_draw_parameters : require
+
+layout(location = 0) in vec4 position;
+
+out vec4 v_Color;
+
+uniform mat4 u_VP;
+//Two texels per draw: transform (xy = offset, zw = scale) and color
+uniform samplerBuffer u_DrawData;
+
+void main()
+{
+   vec4 transform = texelFetch(u_DrawData, gl_DrawIDARB * 2);
+   v_Color = texelFetch(u_DrawData, gl_DrawIDARB * 2 + 1);
+   gl_Position = u_VP * vec4(position.xy * transform.zw + transform.xy, 0.0, 1.0);
+};
+
+#shader fragment
+#version 330 core
+
+layout(location = 0) out vec4 color;
+
+in vec4 v_Color;
+
+void main()
+{
+	color = v_Color;
+};
\ No newline at end of file
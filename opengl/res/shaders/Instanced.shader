@@ -0,0 +1,36 @@
+#shader vertex
+#version 330 core
+
+layout(location = 0) in vec4 position;
+layout(location = 1) in vec2 texCoord;
+//Per instance
+layout(location = 2) in mat4 model;
+layout(location = 6) in vec4 tint;
+
+out vec2 v_TexCoord;
+out vec4 v_Tint;
+
+uniform mat4 u_VP;
+
+void main()
+{
+   gl_Position = u_VP * model * position;
+   v_TexCoord = texCoord;
+   v_Tint = tint;
+};
+
+#shader fragment
+#version 330 core
+
+layout(location = 0) out vec4 color;
+
+in vec2 v_TexCoord;
+in vec4 v_Tint;
+
+uniform sampler2D u_Texture;
+
+void main()
+{
+	vec4 texColor = texture(u_Texture, v_TexCoord);
+	color = texColor * v_Tint;
+};
\ No newline at end of file
@@ -0,0 +1,25 @@
+#shader vertex
+#version 330 core
+
+layout(location = 0) in vec4 position;
+
+uniform mat4 u_VP;
+//xy = offset, zw = scale
+uniform vec4 u_Transform;
+
+void main()
+{
+   gl_Position = u_VP * vec4(position.xy * u_Transform.zw + u_Transform.xy, 0.0, 1.0);
+};
+
+#shader fragment
+#version 330 core
+
+layout(location = 0) out vec4 color;
+
+uniform vec4 u_Color;
+
+void main()
+{
+	color = u_Color;
+};
\ No newline at end of file
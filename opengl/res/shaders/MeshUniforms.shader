@@ -0,0 +1,28 @@
+#shader vertex
+#version 330 core
+
+layout(location = 0) in vec4 position;
+
+uniform mat4 u_ViewProjection;
+//xy = offset, zw = scale
+uniform vec4 u_Transform;
+
+void main()
+{
+   gl_Position = u_ViewProjection * vec4(position.xy * u_Transform.zw + u_Transform.xy, 0.0, 1.0);
+};
+
+#shader fragment
+#version 330 core
+
+layout(location = 0) out vec4 color;
+
+uniform vec4 u_Time;
+uniform vec4 u_Color;
+//x = pulse speed
+uniform vec4 u_Params;
+
+void main()
+{
+	color = u_Color * (0.75 + 0.25 * sin(u_Time.x * u_Params.x));
+};
\ No newline at end of file
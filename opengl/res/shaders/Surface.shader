@@ -0,0 +1,53 @@
+#shader vertex
+#version 330 core
+
+#pragma variant _ TEXTURED
+#pragma variant _ TINTED
+#pragma variant FLAT PULSE WAVE
+
+#include "include/FrameData.glsl"
+
+layout(location = 0) in vec4 position;
+
+//xy = offset, zw = scale
+uniform vec4 u_Transform;
+
+out vec2 v_TexCoord;
+
+void main()
+{
+   v_TexCoord = position.xy + 0.5;
+   gl_Position = u_ViewProjection * vec4(position.xy * u_Transform.zw + u_Transform.xy, 0.0, 1.0);
+};
+
+#shader fragment
+#version 330 core
+
+#include "include/FrameData.glsl"
+
+layout(location = 0) out vec4 color;
+
+in vec2 v_TexCoord;
+
+uniform vec4 u_Color;
+#ifdef TEXTURED
+uniform sampler2D u_Texture;
+#endif
+
+void main()
+{
+	vec4 c = u_Color;
+#ifdef TEXTURED
+	c *= texture(u_Texture, v_TexCoord);
+#endif
+#ifdef PULSE
+	c.rgb *= 0.75 + 0.25 * sin(u_Time.x * 4.0);
+#endif
+#ifdef WAVE
+	c.rgb *= 0.75 + 0.25 * sin(u_Time.x * 4.0 + v_TexCoord.x * 10.0);
+#endif
+#ifdef TINTED
+	c.rgb = mix(c.rgb, vec3(1.0, 0.8, 0.6), 0.3);
+#endif
+	color = c;
+};
\ No newline at end of file
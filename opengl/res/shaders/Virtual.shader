@@ -0,0 +1,35 @@
+#shader vertex
+#version 330 core
+
+#pragma variant _ FEEDBACK
+
+layout(location = 0) in vec4 position;
+layout(location = 1) in vec2 texCoord;
+
+out vec2 v_TexCoord;
+
+uniform mat4 u_MVP;
+
+void main()
+{
+   gl_Position = u_MVP * position;
+   v_TexCoord = texCoord;
+};
+
+#shader fragment
+#version 330 core
+
+#include "include/VirtualTexture.glsl"
+
+layout(location = 0) out vec4 color;
+
+in vec2 v_TexCoord;
+
+void main()
+{
+#ifdef FEEDBACK
+	color = VirtualFeedback(v_TexCoord);
+#else
+	color = SampleVirtual(v_TexCoord);
+#endif
+};
\ No newline at end of file
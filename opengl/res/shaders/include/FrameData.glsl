@@ -0,0 +1,5 @@
+//Shared per-frame block, written once by Renderer::SetFrameUniforms
+layout(std140) uniform FrameData {
+    mat4 u_ViewProjection;
+    vec4 u_Time;
+};
\ No newline at end of file
@@ -0,0 +1,34 @@
+//Virtual texture lookup, set up by VirtualTexture::Bind. Every page table texel holds the atlas
+//tile (rg) and the level (b) of the finest resident tile covering it.
+uniform sampler2D u_PageTable;
+uniform sampler2D u_TileAtlas;
+//x = level 0 size in texels, y = level 0 tiles per side, z = coarsest level, w = lod bias
+uniform vec4 u_VirtualInfo;
+//x = tile size, y = border, z = tile size with borders, w = atlas size
+uniform vec4 u_AtlasInfo;
+
+float VirtualLevel(vec2 uv)
+{
+	vec2 texels = uv * u_VirtualInfo.x;
+	vec2 dx = dFdx(texels), dy = dFdy(texels);
+	float lod = 0.5 * log2(max(dot(dx, dx), dot(dy, dy))) + u_VirtualInfo.w;
+	return clamp(floor(lod), 0.0, u_VirtualInfo.z);
+}
+
+vec4 SampleVirtual(vec2 uv)
+{
+	float level = VirtualLevel(uv);
+	uv = clamp(uv, 0.0, 0.99999);
+	vec3 page = floor(textureLod(u_PageTable, uv, level).rgb * 255.0 + 0.5);
+	vec2 inTile = fract(uv * (u_VirtualInfo.y / exp2(page.b)));
+	vec2 texel = page.rg * u_AtlasInfo.z + u_AtlasInfo.y + inTile * u_AtlasInfo.x;
+	return textureLod(u_TileAtlas, texel / u_AtlasInfo.w, 0.0);
+}
+
+//What the FEEDBACK pass writes: tile in rg, level in b, a = 1 for covered pixels
+vec4 VirtualFeedback(vec2 uv)
+{
+	float level = VirtualLevel(uv);
+	vec2 tile = floor(clamp(uv, 0.0, 0.99999) * (u_VirtualInfo.y / exp2(level)));
+	return vec4(tile, level, 255.0) / 255.0;
+}
\ No newline at end of file
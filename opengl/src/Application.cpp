@@ -1,6 +1,9 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <iostream>
+#include <string>
+#include <chrono>
+#include <cstdlib>
 
 #include "vendor/imgui/imgui.h"
 #include "vendor/imgui/example/imgui_impl_glfw.h"
@@ -14,19 +17,58 @@
 #include "Shader.h"
 #include "Debug.h"
 #include "Texture.h"
+#include "TextureManager.h"
+#include "Benchmark.h"
+#include "GLState.h"
+#include "RenderThread.h"
+#include "Timer.h"
+#include "ShaderArchive.h"
+#include "ShaderCooker.h"
+#include "TextureAtlas.h"
+#include "TextureFile.h"
+#include "VirtualTexture.h"
 
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 
-int main(void)
+int main(int argc, char** argv)
 {
     GLFWwindow* window;
 
+    //opengl --bench <name> [frames]
+    bool benchmark = argc >= 3 && std::string(argv[1]) == "--bench";
+    //opengl --cook-shaders [directory] [archive]
+    bool cook = argc >= 2 && std::string(argv[1]) == "--cook-shaders";
+
+    //opengl --cook-atlas <directory> <atlas>, no window needed
+    if (argc >= 4 && std::string(argv[1]) == "--cook-atlas")
+        return CookAtlas(argv[2], argv[3]);
+    //opengl --compress-texture <image> <dds> [format] [srgb], no window needed either
+    if (argc >= 4 && std::string(argv[1]) == "--compress-texture")
+        return CompressTextureFile(argv[2], argv[3], argc >= 5 ? argv[4] : "bc7", argc >= 6 && std::string(argv[5]) == "srgb");
+    //opengl --cook-virtual <image> <vtex> [tile size]
+    if (argc >= 4 && std::string(argv[1]) == "--cook-virtual") {
+        int tileSize = 128;
+        if (argc >= 5) {
+            char* end = nullptr;
+            long value = strtol(argv[4], &end, 10);
+            if (end == argv[4] || *end != '\0' || value < MinVirtualTileSize || value > MaxVirtualTileSize) {
+                std::cout << "[virtual] bad tile size " << argv[4] << ", expected a power of two from "
+                    << MinVirtualTileSize << " to " << MaxVirtualTileSize << std::endl;
+                return 1;
+            }
+            tileSize = (int)value;
+        }
+        return CookVirtualTextureFile(argv[2], argv[3], tileSize);
+    }
+
     if (!glfwInit()) return -1;
 
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    if (benchmark || cook)
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
 
     window = glfwCreateWindow(640, 480, "Hello World", NULL, NULL);
     if (!window)
@@ -44,6 +86,22 @@ int main(void)
 
     std::cout << glGetString(GL_VERSION) << std::endl;
 
+    if (cook) {
+        int result = CookShaders(argc >= 3 ? argv[2] : "res/shaders", argc >= 4 ? argv[3] : ShaderArchive::DefaultPath);
+        glfwTerminate();
+        return result;
+    }
+
+    //Cooked shaders if there are any, otherwise everything is read from res/shaders
+    ShaderArchive::Get().Open(ShaderArchive::DefaultPath);
+
+    if (benchmark) {
+        glfwSwapInterval(0);
+        int result = RunBenchmark(window, argv[2], argc >= 4 ? std::atoi(argv[3]) : 100);
+        glfwTerminate();
+        return result;
+    }
+
     //
     float positions[] = {
         0.0f,0.0f,0.0f,0.0f, //0 
@@ -68,8 +126,8 @@ int main(void)
 
 
     //Enable Blend
-    GLCall(glEnable(GL_BLEND));
-    GLCall(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+    GLState::Get().SetBlend(true);
+    GLState::Get().SetBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     //VertexArray 
     VertexArray vao;
@@ -82,9 +140,12 @@ int main(void)
     layout.Push<float>(2);
     vao.AddBuffer(vbo, layout);
 
-	//Texture 
-	Texture texture("res/textures/ChernoLogo.png");
-	texture.Bind();
+	//Texture, decoded in the background and drawn with the placeholder until it is uploaded
+	//The 1024 logo is drawn at 480x270, so it gets a filtered mip chain
+	TextureOptions textureOptions;
+	textureOptions.Mipmaps = true;
+	textureOptions.Filter = MipFilter::Kaiser;
+	TextureHandle texture = TextureManager::Get().Load("res/textures/ChernoLogo.png", textureOptions);
 
     //Shader
     Shader shader;
@@ -110,19 +171,50 @@ int main(void)
 
     const char* glsl_version = "#version 330";
     ImGui_ImplOpenGL3_Init(glsl_version);
+    //Creates the font texture, ImGui::NewFrame on the main thread needs the atlas built
+    ImGui_ImplOpenGL3_NewFrame();
 
-    /* Loop until the user closes the window */
-    while (!glfwWindowShouldClose(window)){
-        glfwPollEvents();
+    //From here on the GL context belongs to the render thread
+    RenderThread renderThread(window, [&](FramePacket& packet) {
+        GLState::Get().ResetStats();
+        Shader::ResetUniformStats();
 
         renderer.Clear();
         //shader.SetUniform4f("u_Color", r, 0.3f, 0.8f, 1.0f);
+        texture->Bind();
+        shader.Bind();
+        shader.SetUniformMat4f("u_MVP", packet.MVP);
         renderer.Draw(vao, ibo, shader);
 
+        ImGui_ImplOpenGL3_RenderDrawData(&packet.DrawData);
+        renderer.EndFrame();
+
+        packet.GLStats = GLState::Get().GetStats();
+        packet.Uniforms = Shader::GetUniformStats();
+        packet.Textures = TextureManager::Get().GetStats();
+    });
+    glfwMakeContextCurrent(nullptr);
+    renderThread.Start();
+
+    double frameMs = 0.0, mainCpuMs = 0.0;
+
+    /* Loop until the user closes the window */
+    while (!glfwWindowShouldClose(window)){
+        auto frameStart = std::chrono::high_resolution_clock::now();
+        double cpuStart = ThreadCpuTimeMs();
+
+        glfwPollEvents();
+
+        //Stats of the frame that was last drawn from this packet
+        FramePacket& packet = renderThread.GetWritePacket();
+        const GLStateStats glStats = packet.GLStats;
+        const UniformStats uniformStats = packet.Uniforms;
+        const TextureManagerStats textureStats = packet.Textures;
+        const double renderCpuMs = packet.RenderCpuMs;
+
         //
         view = glm::translate(view, tra);
         mvp = proj * view;
-        shader.SetUniformMat4f("u_MVP",mvp);
 
         if (r > 1.0f) {
             increment = -0.05f;
@@ -134,7 +226,6 @@ int main(void)
 
 
         // Start the Dear ImGui frame
-        ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
 
@@ -162,6 +253,15 @@ int main(void)
             ImGui::Text("counter = %d", counter);
 
             ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+            ImGui::Text("GL state calls: %u issued, %u skipped", glStats.Issued, glStats.Skipped);
+            ImGui::Text("Uniform writes: %u issued, %u skipped", uniformStats.Issued, uniformStats.Skipped);
+            ImGui::Text("Frame %.2f ms, main CPU %.2f ms, render CPU %.2f ms", frameMs, mainCpuMs, renderCpuMs);
+            ImGui::Text("Overlap %.2f ms", mainCpuMs + renderCpuMs - frameMs);
+            ImGui::Text("Textures: %u, %.1f / %.1f MB resident", textureStats.Textures,
+                textureStats.ResidentBytes / (1024.0 * 1024.0), textureStats.Budget / (1024.0 * 1024.0));
+            ImGui::Text("Texture requests: %u, %u path hits, %u content hits", textureStats.Requests, textureStats.PathHits, textureStats.ContentHits);
+            ImGui::Text("Evicted: %u textures, %u levels dropped (%.1f MB), %u reloads (%u failed)", textureStats.Evicted,
+                textureStats.DroppedLevels, textureStats.DroppedBytes / (1024.0 * 1024.0), textureStats.Reloads, textureStats.FailedReloads);
             ImGui::End();
         }
 
@@ -182,11 +282,16 @@ int main(void)
         //glViewport(0, 0, display_w, display_h);
         //glClearColor(clear_color.x * clear_color.w, clear_color.y * clear_color.w, clear_color.z * clear_color.w, clear_color.w);
         
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        packet.MVP = mvp;
+        packet.SetDrawData(ImGui::GetDrawData());
+        mainCpuMs = ThreadCpuTimeMs() - cpuStart;
+        renderThread.Submit();
 
-        glfwSwapBuffers(window);
+        frameMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - frameStart).count();
     }
 
+    renderThread.Stop();
+
     ImGui_ImplGlfw_Shutdown();
     ImGui_ImplOpenGL3_Shutdown();
     ImGui::DestroyContext();
@@ -0,0 +1,1756 @@
+#include "Benchmark.h"
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Renderer.h"
+#include "RenderQueue.h"
+#include "GLState.h"
+#include "IndirectBuffer.h"
+#include "TextureBuffer.h"
+#include "CommandList.h"
+#include "JobSystem.h"
+#include "FrustumCuller.h"
+#include "OcclusionCuller.h"
+#include "VertexBuffer.h"
+#include "VertexBufferLayout.h"
+#include "UniformBuffer.h"
+#include "ProgramBinaryCache.h"
+#include "ShaderVariants.h"
+#include "TextureLoader.h"
+#include "TextureAtlas.h"
+#include "TextureArray.h"
+#include "MipGenerator.h"
+#include "BlockCompressor.h"
+#include "TextureFile.h"
+#include "TextureManager.h"
+#include "VirtualTexture.h"
+#include "Debug.h"
+#include "vendor/stb_image/stb_image.h"
+
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+namespace {
+
+    using Clock = std::chrono::high_resolution_clock;
+
+    double ElapsedMs(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    //Per-frame samples of one benchmark run
+    struct FrameReport {
+        const char* Label;
+        double TotalMs = 0.0;
+        unsigned long long DrawCalls = 0;
+        int Frames = 0;
+
+        FrameReport(const char* label) : Label(label) {}
+
+        void Add(double ms, unsigned int drawCalls)
+        {
+            TotalMs += ms;
+            DrawCalls += drawCalls;
+            Frames++;
+        }
+
+        void Print() const
+        {
+            if (Frames == 0)
+                return;
+            std::cout << "[" << Label << "] " << Frames << " frames, "
+                << DrawCalls / Frames << " draw calls/frame, "
+                << TotalMs / Frames << " ms CPU/frame" << std::endl;
+        }
+    };
+
+    glm::mat4 ScreenProjection()
+    {
+        return glm::ortho<float>(0.0f, 960.0f, 0.0f, 540.0f, -1.0f, 1.0f);
+    }
+
+    //Small solid color textures, enough of them to overflow the batch texture slots
+    std::vector<std::unique_ptr<Texture>> CreateColorTextures(int count)
+    {
+        std::vector<std::unique_ptr<Texture>> textures;
+        textures.push_back(std::make_unique<Texture>("res/textures/ChernoLogo.png"));
+        for (int i = 1; i < count; i++) {
+            unsigned int pixels[4 * 4];
+            unsigned int color = 0xff000000 | (i * 0x2f1d3b);
+            for (unsigned int& p : pixels)
+                p = color;
+            textures.push_back(std::make_unique<Texture>(4, 4, pixels));
+        }
+        return textures;
+    }
+
+    //100k textured quads, once with one Renderer::Draw per quad and once through the batch
+    void BatchQuads(GLFWwindow* window, int frames)
+    {
+        const int quadCount = 100000;
+        const int columns = 400;
+        const glm::vec2 quadSize = { 960.0f / columns, 540.0f / (quadCount / columns) };
+
+        auto textures = CreateColorTextures(24);
+        glm::mat4 proj = ScreenProjection();
+        Renderer renderer;
+
+        {
+            float positions[] = {
+                0.0f, 0.0f, 0.0f, 0.0f,
+                quadSize.x, 0.0f, 1.0f, 0.0f,
+                quadSize.x, quadSize.y, 1.0f, 1.0f,
+                0.0f, quadSize.y, 0.0f, 1.0f
+            };
+            unsigned int indices[] = { 0,1,2,2,3,0 };
+
+            VertexArray vao;
+            VertexBuffer vbo(positions, sizeof(positions));
+            IndexBuffer ibo(indices, 6);
+            VertexBufferLayout layout;
+            layout.Push<float>(2);
+            layout.Push<float>(2);
+            vao.AddBuffer(vbo, layout);
+
+            Shader shader;
+            shader.CreateShader("res/shaders/Basic.shader");
+            shader.Bind();
+            shader.SetUniform1i("u_Texture", 0);
+
+            FrameReport report("unbatched");
+            for (int frame = 0; frame < frames; frame++) {
+                renderer.ResetStats();
+                renderer.Clear();
+
+                auto start = Clock::now();
+                for (int i = 0; i < quadCount; i++) {
+                    glm::vec3 position((i % columns) * quadSize.x, (i / columns) * quadSize.y, 0.0f);
+                    textures[(i / 1000) % textures.size()]->Bind();
+                    shader.Bind();
+                    shader.SetUniformMat4f("u_MVP", proj * glm::translate(glm::mat4(1.0f), position));
+                    renderer.Draw(vao, ibo, shader);
+                }
+                report.Add(ElapsedMs(start), renderer.GetStats().DrawCalls);
+
+                glfwSwapBuffers(window);
+                glfwPollEvents();
+            }
+            report.Print();
+        }
+
+        {
+            Shader shader;
+            shader.CreateShader("res/shaders/Batch.shader");
+            shader.Bind();
+            shader.SetUniformMat4f("u_MVP", proj);
+
+            //Whole frame in one stream region, so flushes never wait on a frame in flight
+            renderer.ReserveBatchQuads(quadCount);
+            unsigned int overflows = 0;
+
+            FrameReport report("batched");
+            for (int frame = 0; frame < frames; frame++) {
+                renderer.ResetStats();
+                renderer.Clear();
+
+                auto start = Clock::now();
+                renderer.BeginBatch(shader);
+                for (int i = 0; i < quadCount; i++) {
+                    glm::vec2 position((i % columns) * quadSize.x, (i / columns) * quadSize.y);
+                    renderer.DrawQuad(position, quadSize, *textures[(i / 1000) % textures.size()]);
+                }
+                renderer.EndBatch();
+                report.Add(ElapsedMs(start), renderer.GetStats().DrawCalls);
+                overflows += renderer.GetStats().StreamOverflows;
+
+                renderer.EndFrame();
+                glfwSwapBuffers(window);
+                glfwPollEvents();
+            }
+            report.Print();
+
+            const StreamBufferStats& stream = renderer.GetBatchStream()->GetStats();
+            std::cout << "[batched] stream buffer " << (renderer.GetBatchStream()->IsPersistent() ? "persistent" : "fallback")
+                << ": " << stream.BytesAllocated / (1024 * 1024) << " MB in " << stream.Allocations << " allocations, "
+                << stream.FenceWaits << " fence waits (" << stream.FenceWaitMs << " ms), "
+                << overflows << " overflows, " << renderer.GetBatchStream()->GetFrameSize() / (1024 * 1024) << " MB region" << std::endl;
+        }
+    }
+
+    //The textured quad drawn 1M times in one call, transform and tint per instance
+    void InstancedQuads(GLFWwindow* window, int frames)
+    {
+        const int columns = 1000;
+        const int instanceCount = columns * 1000;
+        const glm::vec2 quadSize = { 960.0f / columns, 540.0f / (instanceCount / columns) };
+
+        struct InstanceData {
+            glm::mat4 Model;
+            glm::vec4 Tint;
+        };
+
+        std::vector<InstanceData> instances(instanceCount);
+        for (int i = 0; i < instanceCount; i++) {
+            glm::vec3 position((i % columns) * quadSize.x, (i / columns) * quadSize.y, 0.0f);
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), position);
+            instances[i].Model = glm::scale(model, glm::vec3(quadSize, 1.0f));
+            instances[i].Tint = glm::vec4((i % columns) / (float)columns, (i / columns) / 1000.0f, 0.5f, 1.0f);
+        }
+
+        float positions[] = {
+            0.0f, 0.0f, 0.0f, 0.0f,
+            1.0f, 0.0f, 1.0f, 0.0f,
+            1.0f, 1.0f, 1.0f, 1.0f,
+            0.0f, 1.0f, 0.0f, 1.0f
+        };
+        unsigned int indices[] = { 0,1,2,2,3,0 };
+
+        VertexArray vao;
+        VertexBuffer vbo(positions, sizeof(positions));
+        VertexBuffer instanceVbo(instances.data(), (unsigned int)(instances.size() * sizeof(InstanceData)));
+        IndexBuffer ibo(indices, 6);
+
+        VertexBufferLayout layout;
+        layout.Push<float>(2);
+        layout.Push<float>(2);
+        vao.AddBuffer(vbo, layout);
+
+        VertexBufferLayout instanceLayout;
+        for (int column = 0; column < 4; column++)
+            instanceLayout.Push<float>(4, 1);
+        instanceLayout.Push<float>(4, 1);
+        vao.AddBuffer(instanceVbo, instanceLayout);
+
+        Texture texture("res/textures/ChernoLogo.png");
+        texture.Bind();
+
+        Shader shader;
+        shader.CreateShader("res/shaders/Instanced.shader");
+        shader.Bind();
+        shader.SetUniform1i("u_Texture", 0);
+        shader.SetUniformMat4f("u_VP", ScreenProjection());
+
+        Renderer renderer;
+        FrameReport report("instanced");
+        FrameReport gpuReport("instanced+finish");
+        for (int frame = 0; frame < frames; frame++) {
+            renderer.ResetStats();
+            renderer.Clear();
+
+            auto start = Clock::now();
+            renderer.DrawInstanced(vao, ibo, shader, instanceCount);
+            report.Add(ElapsedMs(start), renderer.GetStats().DrawCalls);
+            glFinish();
+            gpuReport.Add(ElapsedMs(start), renderer.GetStats().DrawCalls);
+
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+        }
+        report.Print();
+        gpuReport.Print();
+    }
+
+    //Draws interleaved over 3 programs, 8 textures and 4 VAOs, immediate vs. through the sorted RenderQueue
+    void SortedQueue(GLFWwindow* window, int frames)
+    {
+        const int drawCount = 20000;
+        const int vaoCount = 4;
+        const int programCount = 3;
+
+        float positions[] = {
+            0.0f, 0.0f, 0.0f, 0.0f,
+            8.0f, 0.0f, 1.0f, 0.0f,
+            8.0f, 8.0f, 1.0f, 1.0f,
+            0.0f, 8.0f, 0.0f, 1.0f
+        };
+        unsigned int indices[] = { 0,1,2,2,3,0 };
+
+        std::vector<std::unique_ptr<VertexArray>> vaos;
+        std::vector<std::unique_ptr<VertexBuffer>> vbos;
+        for (int i = 0; i < vaoCount; i++) {
+            vaos.push_back(std::make_unique<VertexArray>());
+            vbos.push_back(std::make_unique<VertexBuffer>(positions, (unsigned int)sizeof(positions)));
+            VertexBufferLayout layout;
+            layout.Push<float>(2);
+            layout.Push<float>(2);
+            vaos.back()->AddBuffer(*vbos.back(), layout);
+        }
+        IndexBuffer ibo(indices, 6);
+        for (auto& vao : vaos) {
+            vao->Bind();
+            ibo.Bind();
+        }
+
+        std::vector<std::unique_ptr<Shader>> shaders;
+        for (int i = 0; i < programCount; i++) {
+            shaders.push_back(std::make_unique<Shader>());
+            shaders.back()->CreateShader("res/shaders/Basic.shader");
+            shaders.back()->Bind();
+            shaders.back()->SetUniform1i("u_Texture", 0);
+        }
+        auto textures = CreateColorTextures(8);
+
+        struct Draw {
+            int VAO, Program, Texture;
+            glm::mat4 MVP;
+            float Depth;
+            bool Transparent;
+        };
+        std::vector<Draw> draws(drawCount);
+        unsigned int seed = 12345;
+        auto next = [&seed]() { seed = seed * 1664525u + 1013904223u; return seed >> 8; };
+        glm::mat4 proj = ScreenProjection();
+        for (Draw& draw : draws) {
+            draw.VAO = next() % vaoCount;
+            draw.Program = next() % programCount;
+            draw.Texture = next() % textures.size();
+            draw.MVP = proj * glm::translate(glm::mat4(1.0f), glm::vec3(next() % 952, next() % 532, 0.0f));
+            draw.Depth = (next() % 1000) / 1000.0f;
+            draw.Transparent = next() % 5 == 0;
+        }
+
+        Renderer renderer;
+        RenderQueue queue;
+        FrameReport immediate("immediate");
+        FrameReport sorted("queue");
+        GLStateStats immediateState, sortedState;
+        for (int frame = 0; frame < frames; frame++) {
+            renderer.ResetStats();
+            renderer.Clear();
+            GLState::Get().ResetStats();
+            auto start = Clock::now();
+            for (const Draw& draw : draws) {
+                textures[draw.Texture]->Bind();
+                shaders[draw.Program]->Bind();
+                shaders[draw.Program]->SetUniformMat4f("u_MVP", draw.MVP);
+                renderer.Draw(*vaos[draw.VAO], ibo, *shaders[draw.Program]);
+            }
+            immediate.Add(ElapsedMs(start), renderer.GetStats().DrawCalls);
+            immediateState = GLState::Get().GetStats();
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+
+            renderer.ResetStats();
+            renderer.Clear();
+            GLState::Get().ResetStats();
+            start = Clock::now();
+            for (const Draw& draw : draws) {
+                queue.Submit(draw.Transparent ? RenderPass::Transparent : RenderPass::Opaque,
+                    *vaos[draw.VAO], ibo, *shaders[draw.Program], textures[draw.Texture].get(), draw.MVP, draw.Depth);
+            }
+            queue.Execute(renderer);
+            sorted.Add(ElapsedMs(start), renderer.GetStats().DrawCalls);
+            sortedState = GLState::Get().GetStats();
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+        }
+        immediate.Print();
+        sorted.Print();
+
+        const RenderQueueStats& stats = queue.GetStats();
+        std::cout << "[queue] " << stats.Packets << " packets, switches eliminated: "
+            << stats.ProgramSwitchesSaved() << " program (" << stats.ProgramSwitches[0] << " -> " << stats.ProgramSwitches[1] << "), "
+            << stats.TextureSwitchesSaved() << " texture (" << stats.TextureSwitches[0] << " -> " << stats.TextureSwitches[1] << "), "
+            << stats.VAOSwitchesSaved() << " vao (" << stats.VAOSwitches[0] << " -> " << stats.VAOSwitches[1] << ")" << std::endl;
+        std::cout << "[gl state] immediate: " << immediateState.Issued << " issued, " << immediateState.Skipped << " skipped; "
+            << "queue: " << sortedState.Issued << " issued, " << sortedState.Skipped << " skipped" << std::endl;
+    }
+
+    //10k small meshes: one Renderer::Draw per mesh vs. one glMultiDrawElementsIndirect
+    void MultiDrawIndirect(GLFWwindow* window, int frames)
+    {
+        if (!Renderer::SupportsMultiDrawIndirect()) {
+            std::cout << "[indirect] needs ARB_multi_draw_indirect and ARB_shader_draw_parameters" << std::endl;
+            return;
+        }
+
+        const int meshCount = 10000;
+
+        //Three shapes in one vertex/index buffer, centered on the origin with unit size
+        std::vector<float> vertices = {
+            -0.5f, -0.5f,  0.5f, -0.5f,  0.5f, 0.5f,  -0.5f, 0.5f,  //quad
+            -0.5f, -0.5f,  0.5f, -0.5f,  0.0f, 0.5f,                //triangle
+            0.0f, 0.0f                                              //hexagon center
+        };
+        std::vector<unsigned int> indices = { 0,1,2,2,3,0, 0,1,2 };
+        for (int i = 0; i < 6; i++) {
+            float angle = i * 3.14159265f / 3.0f;
+            vertices.push_back(0.5f * cosf(angle));
+            vertices.push_back(0.5f * sinf(angle));
+            indices.insert(indices.end(), { 0u, 1u + i, 1u + (i + 1) % 6 });
+        }
+
+        struct Shape {
+            unsigned int FirstVertex, VertexCount, FirstIndex, IndexCount;
+        };
+        const Shape shapes[] = { { 0, 4, 0, 6 }, { 4, 3, 6, 3 }, { 7, 7, 9, 18 } };
+
+        std::vector<glm::vec4> drawData(meshCount * 2);
+        std::vector<DrawElementsIndirectCommand> commands(meshCount);
+        for (int i = 0; i < meshCount; i++) {
+            const Shape& shape = shapes[i % 3];
+            commands[i] = { shape.IndexCount, 1, shape.FirstIndex, (int)shape.FirstVertex, 0 };
+            drawData[i * 2 + 0] = glm::vec4(4.0f + (i % 125) * 7.6f, 4.0f + (i / 125) * 6.7f, 6.0f, 6.0f);
+            drawData[i * 2 + 1] = glm::vec4((i % 7) / 7.0f, (i % 11) / 11.0f, (i % 13) / 13.0f, 1.0f);
+        }
+
+        glm::mat4 proj = ScreenProjection();
+        Renderer renderer;
+
+        {
+            //One VAO per mesh, the way separately loaded meshes end up today
+            std::vector<std::unique_ptr<VertexArray>> vaos;
+            std::vector<std::unique_ptr<VertexBuffer>> vbos;
+            std::vector<std::unique_ptr<IndexBuffer>> ibos;
+            for (int i = 0; i < meshCount; i++) {
+                const Shape& shape = shapes[i % 3];
+                vaos.push_back(std::make_unique<VertexArray>());
+                vbos.push_back(std::make_unique<VertexBuffer>(&vertices[shape.FirstVertex * 2], shape.VertexCount * 2 * (unsigned int)sizeof(float)));
+                VertexBufferLayout layout;
+                layout.Push<float>(2);
+                vaos.back()->AddBuffer(*vbos.back(), layout);
+                ibos.push_back(std::make_unique<IndexBuffer>(&indices[shape.FirstIndex], shape.IndexCount));
+            }
+
+            Shader shader;
+            shader.CreateShader("res/shaders/Mesh.shader");
+            shader.Bind();
+            shader.SetUniformMat4f("u_VP", proj);
+
+            FrameReport report("per-mesh");
+            for (int frame = 0; frame < frames; frame++) {
+                renderer.ResetStats();
+                renderer.Clear();
+
+                auto start = Clock::now();
+                for (int i = 0; i < meshCount; i++) {
+                    const glm::vec4& transform = drawData[i * 2 + 0];
+                    const glm::vec4& color = drawData[i * 2 + 1];
+                    shader.Bind();
+                    shader.SetUniform4f("u_Transform", transform.x, transform.y, transform.z, transform.w);
+                    shader.SetUniform4f("u_Color", color.r, color.g, color.b, color.a);
+                    renderer.Draw(*vaos[i], *ibos[i], shader);
+                }
+                report.Add(ElapsedMs(start), renderer.GetStats().DrawCalls);
+
+                glfwSwapBuffers(window);
+                glfwPollEvents();
+            }
+            report.Print();
+        }
+
+        {
+            VertexArray vao;
+            VertexBuffer vbo(vertices.data(), (unsigned int)(vertices.size() * sizeof(float)));
+            VertexBufferLayout layout;
+            layout.Push<float>(2);
+            vao.AddBuffer(vbo, layout);
+            IndexBuffer ibo(indices.data(), (unsigned int)indices.size());
+            IndirectBuffer indirect(commands.data(), (unsigned int)commands.size());
+            TextureBuffer drawBuffer(drawData.data(), (unsigned int)(drawData.size() * sizeof(glm::vec4)));
+            drawBuffer.Bind(0);
+
+            Shader shader;
+            shader.CreateShader("res/shaders/Indirect.shader");
+            shader.Bind();
+            shader.SetUniformMat4f("u_VP", proj);
+            shader.SetUniform1i("u_DrawData", 0);
+
+            FrameReport report("indirect");
+            for (int frame = 0; frame < frames; frame++) {
+                renderer.ResetStats();
+                renderer.Clear();
+
+                auto start = Clock::now();
+                renderer.MultiDrawIndirect(vao, ibo, indirect, shader);
+                report.Add(ElapsedMs(start), renderer.GetStats().DrawCalls);
+
+                glfwSwapBuffers(window);
+                glfwPollEvents();
+            }
+            report.Print();
+        }
+    }
+
+    //100k draws recorded into per-thread CommandLists with 1..N threads, then merged and replayed
+    void CommandLists(GLFWwindow* window, int frames)
+    {
+        const unsigned int objectCount = 100000;
+        const unsigned int maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+        float positions[] = {
+            -2.0f, -2.0f, 0.0f, 0.0f,
+            2.0f, -2.0f, 1.0f, 0.0f,
+            2.0f, 2.0f, 1.0f, 1.0f,
+            -2.0f, 2.0f, 0.0f, 1.0f
+        };
+        unsigned int indices[] = { 0,1,2,2,3,0 };
+
+        VertexArray vao;
+        VertexBuffer vbo(positions, sizeof(positions));
+        IndexBuffer ibo(indices, 6);
+        VertexBufferLayout layout;
+        layout.Push<float>(2);
+        layout.Push<float>(2);
+        vao.AddBuffer(vbo, layout);
+
+        std::vector<std::unique_ptr<Shader>> shaders;
+        for (int i = 0; i < 2; i++) {
+            shaders.push_back(std::make_unique<Shader>());
+            shaders.back()->CreateShader("res/shaders/Basic.shader");
+        }
+        auto textures = CreateColorTextures(4);
+        glm::mat4 proj = ScreenProjection();
+
+        Renderer renderer;
+        RenderQueue queue;
+
+        for (unsigned int threads = 1; threads <= maxThreads; threads++) {
+            JobSystem jobs(threads - 1);
+            std::vector<std::unique_ptr<CommandList>> lists;
+            std::vector<CommandList*> listPtrs;
+            for (unsigned int i = 0; i < threads; i++) {
+                lists.push_back(std::make_unique<CommandList>());
+                listPtrs.push_back(lists.back().get());
+            }
+            const unsigned int chunk = (objectCount + threads - 1) / threads;
+
+            double recordMs = 0.0, replayMs = 0.0;
+            uint64_t hash = 14695981039346656037ull;
+            for (int frame = 0; frame < frames; frame++) {
+                auto start = Clock::now();
+                jobs.ParallelFor(objectCount, chunk, [&](unsigned int begin, unsigned int end) {
+                    CommandList& list = *lists[begin / chunk];
+                    list.Reset();
+                    for (unsigned int i = begin; i < end; i++) {
+                        float angle = i * 0.01f + frame * 0.02f;
+                        glm::vec3 position((i % 400) * 2.4f, (i / 400) * 2.16f, 0.0f);
+                        glm::mat4 model = glm::rotate(glm::translate(glm::mat4(1.0f), position), angle, glm::vec3(0.0f, 0.0f, 1.0f));
+
+                        Shader& shader = *shaders[(i / 7) % shaders.size()];
+                        list.Draw((i % 10) ? RenderPass::Opaque : RenderPass::Transparent, vao, ibo, shader,
+                            textures[(i / 3) % textures.size()].get(), (i % 1000) / 1000.0f);
+                        list.SetUniform1i("u_Texture", 0);
+                        list.SetUniformMat4f("u_MVP", proj * model);
+                    }
+                });
+                recordMs += ElapsedMs(start);
+
+                //Same input for every thread count means the same merged and sorted order
+                if (frame == 0) {
+                    for (CommandList* list : listPtrs) {
+                        for (const DrawCommand& command : list->GetCommands()) {
+                            hash = (hash ^ command.Key) * 1099511628211ull;
+                            for (const UniformCommand* uniform = command.Uniforms; uniform; uniform = uniform->Next)
+                                hash = (hash ^ (uint64_t)uniform->Type) * 1099511628211ull;
+                        }
+                    }
+                }
+
+                renderer.Clear();
+                start = Clock::now();
+                queue.Execute(renderer, listPtrs.data(), (unsigned int)listPtrs.size());
+                replayMs += ElapsedMs(start);
+
+                glfwSwapBuffers(window);
+                glfwPollEvents();
+            }
+
+            std::cout << "[commandlists] " << threads << " thread(s): record " << recordMs / frames
+                << " ms/frame, replay " << replayMs / frames << " ms/frame, " << queue.GetStats().Packets
+                << " draws, " << queue.GetStats().ProgramSwitchesSaved() << " program / " << queue.GetStats().TextureSwitchesSaved()
+                << " texture switches saved, order hash " << std::hex << hash << std::dec << std::endl;
+        }
+    }
+
+    //1M AABBs and spheres against a perspective frustum, CPU only
+    void FrustumCulling(GLFWwindow* window, int frames)
+    {
+        const unsigned int objectCount = 1000000;
+
+        FrustumCuller culler;
+        unsigned int seed = 4242;
+        auto next = [&seed]() { seed = seed * 1664525u + 1013904223u; return (seed >> 8) / 16777216.0f * 1000.0f - 500.0f; };
+        for (unsigned int i = 0; i < objectCount; i++) {
+            glm::vec3 center(next(), next(), next());
+            if (i & 1)
+                culler.AddSphere(center, 5.0f);
+            else
+                culler.AddAABB(center - glm::vec3(3.0f), center + glm::vec3(4.0f));
+        }
+
+        glm::mat4 proj = glm::perspective(glm::radians(60.0f), 960.0f / 540.0f, 0.1f, 600.0f);
+        std::vector<unsigned int> visible;
+
+        const struct { const char* Name; CullPath Path; } paths[] = {
+            { "scalar", CullPath::Scalar }, { "sse", CullPath::SSE }, { "avx2", CullPath::AVX2 }
+        };
+        for (const auto& path : paths) {
+            if (path.Path > FrustumCuller::GetBestPath())
+                continue;
+            double totalMs = 0.0;
+            for (int frame = 0; frame < frames; frame++) {
+                glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(cosf(frame * 0.05f), 0.2f, sinf(frame * 0.05f)), glm::vec3(0.0f, 1.0f, 0.0f));
+                auto start = Clock::now();
+                culler.Cull(Frustum::FromMatrix(proj * view), visible, path.Path);
+                totalMs += ElapsedMs(start);
+            }
+            std::cout << "[culling] " << path.Name << ": " << totalMs / frames << " ms for " << objectCount
+                << " objects, " << visible.size() << " visible" << std::endl;
+        }
+
+        JobSystem& jobs = JobSystem::Get();
+        double totalMs = 0.0;
+        for (int frame = 0; frame < frames; frame++) {
+            glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(cosf(frame * 0.05f), 0.2f, sinf(frame * 0.05f)), glm::vec3(0.0f, 1.0f, 0.0f));
+            auto start = Clock::now();
+            culler.CullParallel(Frustum::FromMatrix(proj * view), visible, jobs);
+            totalMs += ElapsedMs(start);
+        }
+        std::cout << "[culling] parallel (" << jobs.GetWorkerCount() + 1 << " threads): " << totalMs / frames
+            << " ms, " << visible.size() << " visible" << std::endl;
+    }
+
+    //50 programs that all need the camera and time: plain uniforms re-upload them into every
+    //program, the FrameData block is written once and shared through its binding point
+    void UniformBlocks(GLFWwindow* window, int frames)
+    {
+        const int programCount = 50;
+
+        float vertices[] = { -0.5f, -0.5f,  0.5f, -0.5f,  0.5f, 0.5f,  -0.5f, 0.5f };
+        unsigned int indices[] = { 0, 1, 2, 2, 3, 0 };
+        VertexArray vao;
+        VertexBuffer vbo(vertices, sizeof(vertices));
+        VertexBufferLayout layout;
+        layout.Push<float>(2);
+        vao.AddBuffer(vbo, layout);
+        IndexBuffer ibo(indices, 6);
+
+        std::vector<glm::vec4> transforms(programCount), colors(programCount), params(programCount);
+        for (int i = 0; i < programCount; i++) {
+            transforms[i] = glm::vec4(60.0f + (i % 10) * 90.0f, 60.0f + (i / 10) * 90.0f, 80.0f, 80.0f);
+            colors[i] = glm::vec4((i % 7) / 7.0f, (i % 11) / 11.0f, (i % 13) / 13.0f, 1.0f);
+            params[i] = glm::vec4(1.0f + i * 0.1f, 0.0f, 0.0f, 0.0f);
+        }
+
+        glm::mat4 proj = ScreenProjection();
+        Renderer renderer;
+
+        {
+            std::vector<std::unique_ptr<Shader>> shaders;
+            for (int i = 0; i < programCount; i++) {
+                shaders.push_back(std::make_unique<Shader>());
+                shaders.back()->CreateShader("res/shaders/MeshUniforms.shader");
+                //Materials don't change, set once
+                shaders.back()->Bind();
+                shaders.back()->SetUniform4f("u_Color", colors[i].r, colors[i].g, colors[i].b, colors[i].a);
+                shaders.back()->SetUniform4f("u_Params", params[i].x, params[i].y, params[i].z, params[i].w);
+                shaders.back()->UploadUniforms();
+            }
+
+            //Counted where the glUniform* calls are made, equal values are skipped there
+            FrameReport report("uniforms");
+            unsigned long long uploads = 0;
+            for (int frame = 0; frame < frames; frame++) {
+                renderer.ResetStats();
+                renderer.Clear();
+
+                Shader::ResetUniformStats();
+                auto start = Clock::now();
+                float time = frame / 60.0f;
+                for (int i = 0; i < programCount; i++) {
+                    Shader& shader = *shaders[i];
+                    shader.Bind();
+                    shader.SetUniformMat4f("u_ViewProjection", proj);
+                    shader.SetUniform4f("u_Time", time, 1.0f / 60.0f, 0.0f, 0.0f);
+                    shader.SetUniform4f("u_Transform", transforms[i].x, transforms[i].y, transforms[i].z, transforms[i].w);
+                    renderer.Draw(vao, ibo, shader);
+                }
+                report.Add(ElapsedMs(start), renderer.GetStats().DrawCalls);
+                uploads += Shader::GetUniformStats().Issued;
+
+                glfwSwapBuffers(window);
+                glfwPollEvents();
+            }
+            report.Print();
+            std::cout << "[uniforms] " << uploads / frames << " uniform uploads/frame" << std::endl;
+        }
+
+        {
+            std::vector<std::unique_ptr<Shader>> shaders;
+            for (int i = 0; i < programCount; i++) {
+                shaders.push_back(std::make_unique<Shader>());
+                shaders.back()->CreateShader("res/shaders/MeshBlocks.shader");
+            }
+
+            const UniformBlockLayout* materialBlock = shaders[0]->GetUniformBlock("MaterialData");
+            if (!materialBlock) {
+                std::cout << "[blocks] skipped, MeshBlocks.shader has no MaterialData block" << std::endl;
+                return;
+            }
+
+            //One range per material, written once
+            UniformBuffer materials(*materialBlock, programCount);
+            for (int i = 0; i < programCount; i++) {
+                materials.Set("u_Color", colors[i], i);
+                materials.Set("u_Params", params[i], i);
+            }
+            materials.Upload();
+
+            FrameReport report("blocks");
+            unsigned long long uploads = 0;
+            for (int frame = 0; frame < frames; frame++) {
+                renderer.ResetStats();
+                renderer.Clear();
+
+                Shader::ResetUniformStats();
+                UniformBuffer::ResetStats();
+                auto start = Clock::now();
+                renderer.SetFrameUniforms(proj, frame / 60.0f, 1.0f / 60.0f);
+                for (int i = 0; i < programCount; i++) {
+                    Shader& shader = *shaders[i];
+                    shader.Bind();
+                    materials.BindRange(UniformBinding::Material, i);
+                    shader.SetUniform4f("u_Transform", transforms[i].x, transforms[i].y, transforms[i].z, transforms[i].w);
+                    renderer.Draw(vao, ibo, shader);
+                }
+                report.Add(ElapsedMs(start), renderer.GetStats().DrawCalls);
+                uploads += Shader::GetUniformStats().Issued + UniformBuffer::GetStats().Uploads;
+
+                glfwSwapBuffers(window);
+                glfwPollEvents();
+            }
+            report.Print();
+            std::cout << "[blocks] " << uploads / frames << " uniform uploads/frame, " << programCount
+                << " material range binds/frame" << std::endl;
+        }
+    }
+
+    //Cost of one uniform write per way of naming the uniform. "string cache" is what
+    //GetUniformLocation used to do: build a std::string, miss the (never filled) cache, ask GL.
+    void UniformLookup(GLFWwindow* window, int frames)
+    {
+        const int iterations = frames * 1000;
+
+        Shader shader;
+        shader.CreateShader("res/shaders/MeshUniforms.shader");
+        shader.Bind();
+        unsigned int program = shader.GetRendererID();
+
+        auto report = [iterations](const char* label, double ms) {
+            std::cout << "[uniformlookup] " << label << ": " << ms * 1000000.0 / iterations << " ns/write" << std::endl;
+        };
+
+        {
+            std::unordered_map<std::string, int> cache;
+            auto start = Clock::now();
+            for (int i = 0; i < iterations; i++) {
+                const char* name = "u_Color";
+                int location;
+                if (cache.find(name) != cache.end())
+                    location = cache[name];
+                else
+                    location = glGetUniformLocation(program, name);
+                glUniform4f(location, 1.0f, 0.5f, 0.25f, (float)i);
+            }
+            glFinish();
+            report("string cache", ElapsedMs(start));
+        }
+        {
+            auto start = Clock::now();
+            for (int i = 0; i < iterations; i++) {
+                shader.SetUniform4f("u_Color", 1.0f, 0.5f, 0.25f, (float)i);
+                shader.UploadUniforms();
+            }
+            glFinish();
+            report("name", ElapsedMs(start));
+        }
+        {
+            static constexpr UniformID colorID("u_Color");
+            auto start = Clock::now();
+            for (int i = 0; i < iterations; i++) {
+                shader.SetUniform4f(colorID, 1.0f, 0.5f, 0.25f, (float)i);
+                shader.UploadUniforms();
+            }
+            glFinish();
+            report("hashed name", ElapsedMs(start));
+        }
+        {
+            UniformHandle color = shader.GetUniformHandle("u_Color");
+            auto start = Clock::now();
+            for (int i = 0; i < iterations; i++) {
+                shader.SetUniform4f(color, 1.0f, 0.5f, 0.25f, (float)i);
+                shader.UploadUniforms();
+            }
+            glFinish();
+            report("handle", ElapsedMs(start));
+        }
+        {
+            int location = glGetUniformLocation(program, "u_Color");
+            auto start = Clock::now();
+            for (int i = 0; i < iterations; i++)
+                glUniform4f(location, 1.0f, 0.5f, 0.25f, (float)i);
+            glFinish();
+            report("raw glUniform4f", ElapsedMs(start));
+        }
+        {
+            //Same value every time, the shadow copy catches it before GL
+            UniformHandle color = shader.GetUniformHandle("u_Color");
+            Shader::ResetUniformStats();
+            auto start = Clock::now();
+            for (int i = 0; i < iterations; i++) {
+                shader.SetUniform4f(color, 1.0f, 0.5f, 0.25f, 1.0f);
+                shader.UploadUniforms();
+            }
+            glFinish();
+            report("handle, unchanged", ElapsedMs(start));
+            const UniformStats& stats = Shader::GetUniformStats();
+            std::cout << "[uniformlookup] " << stats.Writes << " writes, " << stats.Issued << " issued, "
+                << stats.Skipped << " skipped" << std::endl;
+        }
+    }
+
+    //Startup cost of the shader library: from source without the cache, first run with an empty
+    //cache (compile + store), and a warm run that only loads binaries
+    void ShaderCache(GLFWwindow* window, int frames)
+    {
+        const char* library[] = {
+            "res/shaders/Basic.shader", "res/shaders/Batch.shader", "res/shaders/Instanced.shader",
+            "res/shaders/Mesh.shader", "res/shaders/MeshBlocks.shader", "res/shaders/MeshUniforms.shader"
+        };
+        const int shaderCount = sizeof(library) / sizeof(library[0]);
+
+        ProgramBinaryCache& cache = ProgramBinaryCache::Get();
+        if (!cache.IsAvailable()) {
+            std::cout << "[shadercache] needs GL 4.1 or ARB_get_program_binary" << std::endl;
+            return;
+        }
+
+        auto loadLibrary = [&](const char* label) {
+            cache.ResetStats();
+            std::vector<std::unique_ptr<Shader>> shaders;
+            auto start = Clock::now();
+            for (const char* path : library) {
+                shaders.push_back(std::make_unique<Shader>());
+                shaders.back()->CreateShader(path);
+            }
+            glFinish();
+            double ms = ElapsedMs(start);
+
+            const ProgramBinaryCacheStats& stats = cache.GetStats();
+            std::cout << "[shadercache] " << label << ": " << ms << " ms for " << shaderCount << " programs ("
+                << stats.Hits << " hits, " << stats.Misses << " misses, " << stats.Rejected << " rejected, "
+                << stats.Stores << " stored)" << std::endl;
+
+            std::vector<uint64_t> keys;
+            for (const auto& shader : shaders)
+                keys.push_back(shader->GetCacheKey());
+            return keys;
+        };
+
+        cache.SetEnabled(false);
+        std::vector<uint64_t> keys = loadLibrary("source");
+        cache.SetEnabled(true);
+
+        for (uint64_t key : keys)
+            cache.Remove(key);
+        loadLibrary("cold");
+        loadLibrary("warm");
+    }
+
+    //200 distinct programs: blocking builds against submitting everything and polling once per frame.
+    //The binary cache is off, otherwise the second run would measure it instead.
+    void AsyncShaders(GLFWwindow* window, int frames)
+    {
+        const int shaderCount = 200;
+
+        auto makeSource = [](int index) {
+            ShaderProgramSource source;
+            source.VertexSource =
+                "#version 330 core\n"
+                "layout(location = 0) in vec4 position;\n"
+                "uniform mat4 u_MVP;\n"
+                "void main() { gl_Position = u_MVP * position; }\n";
+            //Different constants so no driver side cache can share work between them
+            source.FragmentSource =
+                "#version 330 core\n"
+                "layout(location = 0) out vec4 color;\n"
+                "uniform vec4 u_Color;\n"
+                "void main() {\n"
+                "    vec4 c = u_Color;\n"
+                "    for (int i = 0; i < 8; i++)\n"
+                "        c = fract(c * " + std::to_string(1.0 + index * 0.001) + " + vec4(0.1, 0.2, 0.3, 0.4));\n"
+                "    color = c;\n"
+                "}\n";
+            return source;
+        };
+
+        ProgramBinaryCache::Get().SetEnabled(false);
+        Shader::GetPlaceholder();
+        bool parallel = GLEW_KHR_parallel_shader_compile || GLEW_ARB_parallel_shader_compile;
+        std::cout << "[asyncshaders] parallel shader compile " << (parallel ? "available" : "not available") << std::endl;
+
+        {
+            std::vector<std::unique_ptr<Shader>> shaders;
+            auto start = Clock::now();
+            for (int i = 0; i < shaderCount; i++) {
+                shaders.push_back(std::make_unique<Shader>());
+                shaders.back()->CreateShaderFromSource(makeSource(i));
+            }
+            std::cout << "[asyncshaders] blocking: " << ElapsedMs(start) << " ms main thread stall" << std::endl;
+        }
+
+        {
+            std::vector<std::unique_ptr<Shader>> shaders;
+            auto start = Clock::now();
+            for (int i = shaderCount; i < shaderCount * 2; i++) {
+                shaders.push_back(std::make_unique<Shader>());
+                shaders.back()->CreateShaderFromSource(makeSource(i), true);
+            }
+            double submitMs = ElapsedMs(start);
+
+            //Keep presenting frames like a loading screen would, polling costs count as stall
+            double pollMs = 0.0;
+            int frame = 0;
+            unsigned int building = shaderCount;
+            while (building > 0) {
+                auto pollStart = Clock::now();
+                building = Shader::PollBuilds();
+                pollMs += ElapsedMs(pollStart);
+
+                glfwSwapBuffers(window);
+                glfwPollEvents();
+                frame++;
+            }
+            double totalMs = ElapsedMs(start);
+
+            int ready = 0;
+            for (const auto& shader : shaders)
+                ready += shader->IsReady();
+            std::cout << "[asyncshaders] async: " << submitMs << " ms submit + " << pollMs << " ms polling over "
+                << frame << " frames, all " << ready << " ready after " << totalMs << " ms" << std::endl;
+        }
+
+        ProgramBinaryCache::Get().SetEnabled(true);
+    }
+
+    //Surface.shader has 12 permutations, the scene only draws 3 of them. Eager compiles all of
+    //them before the first frame, lazy only builds what the draws ask for.
+    void Permutations(GLFWwindow* window, int frames)
+    {
+        const int objectCount = 60;
+
+        float vertices[] = { -0.5f, -0.5f,  0.5f, -0.5f,  0.5f, 0.5f,  -0.5f, 0.5f };
+        unsigned int indices[] = { 0, 1, 2, 2, 3, 0 };
+        VertexArray vao;
+        VertexBuffer vbo(vertices, sizeof(vertices));
+        VertexBufferLayout layout;
+        layout.Push<float>(2);
+        vao.AddBuffer(vbo, layout);
+        IndexBuffer ibo(indices, 6);
+
+        const std::vector<std::string> used[] = { { "FLAT" }, { "PULSE", "TINTED" }, { "WAVE" } };
+
+        ProgramBinaryCache::Get().SetEnabled(false);
+        Renderer renderer;
+        glm::mat4 proj = ScreenProjection();
+
+        for (bool eager : { true, false }) {
+            auto start = Clock::now();
+            ShaderVariants variants("res/shaders/Surface.shader");
+            if (!variants.IsValid()) {
+                std::cout << "[variants] skipped, Surface.shader failed to load" << std::endl;
+                return;
+            }
+            if (eager) {
+                for (uint64_t key = 0; key < variants.GetPermutationCount(); key++)
+                    variants.Get(key);
+            }
+            glFinish();
+            double startupMs = ElapsedMs(start);
+
+            FrameReport report(eager ? "eager" : "lazy");
+            double firstFrameMs = 0.0;
+            for (int frame = 0; frame < frames; frame++) {
+                renderer.ResetStats();
+                renderer.Clear();
+
+                auto frameStart = Clock::now();
+                renderer.SetFrameUniforms(proj, frame / 60.0f, 1.0f / 60.0f);
+                for (int i = 0; i < objectCount; i++) {
+                    Shader& shader = variants.Get(used[i % 3]);
+                    shader.SetUniform4f("u_Transform", 60.0f + (i % 10) * 90.0f, 60.0f + (i / 10) * 80.0f, 70.0f, 70.0f);
+                    shader.SetUniform4f("u_Color", (i % 7) / 7.0f, (i % 11) / 11.0f, (i % 13) / 13.0f, 1.0f);
+                    renderer.Draw(vao, ibo, shader);
+                }
+                if (frame == 0) {
+                    glFinish();
+                    firstFrameMs = ElapsedMs(frameStart);
+                }
+                report.Add(ElapsedMs(frameStart), renderer.GetStats().DrawCalls);
+
+                glfwSwapBuffers(window);
+                glfwPollEvents();
+            }
+            report.Print();
+            std::cout << "[" << (eager ? "eager" : "lazy") << "] startup " << startupMs << " ms, first frame " << firstFrameMs
+                << " ms, " << variants.GetCompiledCount() << " of " << variants.GetPermutationCount() << " permutations compiled" << std::endl;
+        }
+
+        ProgramBinaryCache::Get().SetEnabled(true);
+    }
+
+    //Uncompressed 32 bit TGA, stb_image reads it without any decoding work worth mentioning,
+    //so the numbers below are file IO plus the GL upload
+    void WriteTestTexture(const std::string& path, int size, int seed)
+    {
+        unsigned char header[18] = {};
+        header[2] = 2; //uncompressed true color
+        header[12] = size & 0xff; header[13] = size >> 8;
+        header[14] = size & 0xff; header[15] = size >> 8;
+        header[16] = 32;
+        header[17] = 8; //alpha bits
+
+        std::vector<unsigned char> pixels(size * size * 4);
+        for (int y = 0; y < size; y++) {
+            for (int x = 0; x < size; x++) {
+                unsigned char* p = &pixels[(y * size + x) * 4];
+                p[0] = (unsigned char)(x + seed * 7);
+                p[1] = (unsigned char)(y + seed * 13);
+                p[2] = (unsigned char)((x ^ y) + seed);
+                p[3] = 255;
+            }
+        }
+
+        FILE* file = fopen(path.c_str(), "wb");
+        if (!file)
+            return;
+        fwrite(header, 1, sizeof(header), file);
+        fwrite(pixels.data(), 1, pixels.size(), file);
+        fclose(file);
+    }
+
+    //500 textures shown on a grid while they load: created one by one on the GL thread against
+    //TextureLoader with its per-frame budget. The hitch is the longest frame until all are in.
+    void TextureLoading(GLFWwindow* window, int frames)
+    {
+        const int textureCount = 500;
+        const int textureSize = 256;
+        const int columns = 25;
+        const glm::vec2 quadSize = { 960.0f / columns, 540.0f / (textureCount / columns) };
+
+        std::vector<std::string> paths;
+        for (int i = 0; i < textureCount; i++) {
+            paths.push_back("texbench_" + std::to_string(i) + ".tga");
+            WriteTestTexture(paths.back(), textureSize, i);
+        }
+
+        Renderer renderer;
+        Shader shader;
+        shader.CreateShader("res/shaders/Batch.shader");
+        shader.Bind();
+        shader.SetUniformMat4f("u_MVP", ScreenProjection());
+
+        auto drawGrid = [&](const std::vector<std::shared_ptr<Texture>>& textures) {
+            renderer.BeginBatch(shader);
+            for (int i = 0; i < (int)textures.size(); i++) {
+                glm::vec2 position((i % columns) * quadSize.x, (i / columns) * quadSize.y);
+                renderer.DrawQuad(position, quadSize, *textures[i]);
+            }
+            renderer.EndBatch();
+        };
+
+        {
+            std::vector<std::shared_ptr<Texture>> textures;
+            auto start = Clock::now();
+            for (const std::string& path : paths)
+                textures.push_back(std::make_shared<Texture>(path));
+            renderer.Clear();
+            drawGrid(textures);
+            renderer.EndFrame();
+            glFinish();
+            std::cout << "[textureloading] blocking: " << ElapsedMs(start) << " ms in one frame" << std::endl;
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+        }
+
+        {
+            TextureLoader& loader = TextureLoader::Get();
+            loader.ResetStats();
+
+            std::vector<std::shared_ptr<Texture>> textures;
+            auto start = Clock::now();
+            double hitchMs = 0.0;
+            int frame = 0;
+            unsigned int loading = textureCount;
+            while (loading > 0) {
+                auto frameStart = Clock::now();
+                if (frame == 0) {
+                    for (const std::string& path : paths)
+                        textures.push_back(loader.Load(path));
+                }
+                renderer.Clear();
+                drawGrid(textures);
+                //EndFrame runs the uploads, this is what a frame of a loading level costs
+                renderer.EndFrame();
+                loading = loader.GetPendingCount();
+                glFinish();
+                hitchMs = std::max(hitchMs, ElapsedMs(frameStart));
+
+                glfwSwapBuffers(window);
+                glfwPollEvents();
+                frame++;
+            }
+            double totalMs = ElapsedMs(start);
+
+            int ready = 0;
+            for (const auto& texture : textures)
+                ready += texture->IsReady();
+            const TextureLoaderStats& stats = loader.GetStats();
+            std::cout << "[textureloading] async: " << ready << " ready after " << totalMs << " ms over " << frame
+                << " frames, worst frame " << hitchMs << " ms, budget " << loader.GetFrameBudget() / 1024 << " KB/frame" << std::endl;
+            std::cout << "[textureloading] " << stats.Uploads << " uploads, " << stats.BytesUploaded / (1024 * 1024) << " MB, "
+                << stats.UploadMs << " ms upload on the GL thread, " << stats.DecodeMs << " ms decode on workers" << std::endl;
+        }
+
+        for (const std::string& path : paths)
+            remove(path.c_str());
+    }
+
+    //400 small sprites drawn 20k times a frame in random order: one texture each against one
+    //atlas. The batch flushes whenever it runs out of texture slots, the atlas never does.
+    void AtlasSprites(GLFWwindow* window, int frames)
+    {
+        const int spriteCount = 400;
+        const int quadCount = 20000;
+
+        unsigned int seed = 777;
+        auto next = [&seed]() { seed = seed * 1664525u + 1013904223u; return seed >> 8; };
+
+        std::vector<std::unique_ptr<Texture>> textures;
+        TextureAtlas atlas;
+        for (int i = 0; i < spriteCount; i++) {
+            int width = 16 + next() % 49, height = 16 + next() % 49;
+            unsigned int color = 0xff000000 | (next() & 0xffffff);
+            std::vector<unsigned int> pixels(width * height);
+            for (int y = 0; y < height; y++)
+                for (int x = 0; x < width; x++)
+                    pixels[y * width + x] = (x == 0 || y == 0 || x == width - 1 || y == height - 1) ? 0xffffffff : color;
+            textures.push_back(std::make_unique<Texture>(width, height, pixels.data()));
+            atlas.AddImage("sprite" + std::to_string(i), width, height, pixels.data());
+        }
+
+        auto start = Clock::now();
+        atlas.Build();
+        double buildMs = ElapsedMs(start);
+        const AtlasStats& atlasStats = atlas.GetStats();
+        std::cout << "[atlas] " << atlasStats.Sprites << " sprites on " << atlasStats.Pages << " pages, "
+            << atlasStats.Efficiency() << "% packed, built in " << buildMs << " ms" << std::endl;
+
+        struct Sprite {
+            glm::vec2 Position;
+            unsigned int Index;
+        };
+        std::vector<Sprite> sprites(quadCount);
+        for (Sprite& sprite : sprites)
+            sprite = { glm::vec2(next() % 930, next() % 510), next() % spriteCount };
+
+        Shader shader;
+        shader.CreateShader("res/shaders/Batch.shader");
+        shader.Bind();
+        shader.SetUniformMat4f("u_MVP", ScreenProjection());
+        Renderer renderer;
+
+        unsigned int binds[2] = {};
+        for (bool useAtlas : { false, true }) {
+            FrameReport report(useAtlas ? "atlas" : "textures");
+            for (int frame = 0; frame < frames; frame++) {
+                renderer.ResetStats();
+                renderer.Clear();
+
+                auto frameStart = Clock::now();
+                renderer.BeginBatch(shader);
+                for (const Sprite& sprite : sprites) {
+                    if (useAtlas) {
+                        const AtlasRegion& region = atlas.GetRegion(sprite.Index);
+                        renderer.DrawQuad(sprite.Position, glm::vec2(region.Width, region.Height), atlas.GetPage(region.Page), region.UVMin, region.UVMax);
+                    }
+                    else {
+                        const Texture& texture = *textures[sprite.Index];
+                        renderer.DrawQuad(sprite.Position, glm::vec2(texture.GetWidth(), texture.GetHeigh()), texture);
+                    }
+                }
+                renderer.EndBatch();
+                renderer.EndFrame();
+                report.Add(ElapsedMs(frameStart), renderer.GetStats().DrawCalls);
+                binds[useAtlas] = renderer.GetStats().TextureBinds;
+
+                glfwSwapBuffers(window);
+                glfwPollEvents();
+            }
+            report.Print();
+        }
+        std::cout << "[atlas] texture binds/frame " << binds[0] << " -> " << binds[1] << ", "
+            << binds[0] - binds[1] << " saved" << std::endl;
+    }
+
+    //256 same-size sprites drawn 20k times a frame in random order: one texture per sprite, bound
+    //to the 16 units of the batch, against one array with a layer per sprite
+    void ArraySprites(GLFWwindow* window, int frames)
+    {
+        const int spriteCount = 256;
+        const int spriteSize = 64;
+        const int quadCount = 20000;
+
+        unsigned int seed = 4242;
+        auto next = [&seed]() { seed = seed * 1664525u + 1013904223u; return seed >> 8; };
+
+        std::vector<std::unique_ptr<Texture>> textures;
+        TextureArray array(spriteSize, spriteSize, spriteCount);
+        std::vector<unsigned int> pixels(spriteSize * spriteSize);
+        for (int i = 0; i < spriteCount; i++) {
+            unsigned int color = 0xff000000 | (next() & 0xffffff);
+            for (int y = 0; y < spriteSize; y++)
+                for (int x = 0; x < spriteSize; x++)
+                    pixels[y * spriteSize + x] = (x == 0 || y == 0 || x == spriteSize - 1 || y == spriteSize - 1) ? 0xffffffff : color;
+            textures.push_back(std::make_unique<Texture>(spriteSize, spriteSize, pixels.data()));
+            array.AddLayer(pixels.data());
+        }
+
+        struct Sprite {
+            glm::vec2 Position;
+            unsigned int Index;
+        };
+        std::vector<Sprite> sprites(quadCount);
+        for (Sprite& sprite : sprites)
+            sprite = { glm::vec2(next() % 900, next() % 480), next() % spriteCount };
+
+        Shader unitShader, arrayShader;
+        unitShader.CreateShader("res/shaders/Batch.shader");
+        arrayShader.CreateShader("res/shaders/BatchArray.shader");
+        for (Shader* shader : { &unitShader, &arrayShader }) {
+            shader->Bind();
+            shader->SetUniformMat4f("u_MVP", ScreenProjection());
+        }
+        Renderer renderer;
+
+        const glm::vec2 size(spriteSize, spriteSize);
+        unsigned int binds[2] = {}, draws[2] = {};
+        for (bool useArray : { false, true }) {
+            FrameReport report(useArray ? "array" : "units");
+            for (int frame = 0; frame < frames; frame++) {
+                renderer.ResetStats();
+                renderer.Clear();
+
+                auto frameStart = Clock::now();
+                if (useArray) {
+                    renderer.BeginBatch(arrayShader, array);
+                    for (const Sprite& sprite : sprites)
+                        renderer.DrawQuad(sprite.Position, size, array, sprite.Index);
+                }
+                else {
+                    renderer.BeginBatch(unitShader);
+                    for (const Sprite& sprite : sprites)
+                        renderer.DrawQuad(sprite.Position, size, *textures[sprite.Index]);
+                }
+                renderer.EndBatch();
+                renderer.EndFrame();
+                report.Add(ElapsedMs(frameStart), renderer.GetStats().DrawCalls);
+                binds[useArray] = renderer.GetStats().TextureBinds;
+                draws[useArray] = renderer.GetStats().DrawCalls;
+
+                glfwSwapBuffers(window);
+                glfwPollEvents();
+            }
+            report.Print();
+        }
+        std::cout << "[texturearray] draw calls/frame " << draws[0] << " -> " << draws[1] << ", texture binds/frame "
+            << binds[0] << " -> " << binds[1] << std::endl;
+    }
+
+    //Full chain of a 2048x2048 image for every filter and instruction set, on one thread and on
+    //the job system. Throughput is level 0 pixels per second.
+    void MipGeneration(GLFWwindow* window, int frames)
+    {
+        const int size = 2048;
+        const int runs = std::max(1, std::min(frames, 10));
+
+        std::vector<unsigned char> pixels((size_t)size * size * 4);
+        unsigned int seed = 99;
+        for (size_t i = 0; i < pixels.size(); i += 4) {
+            seed = seed * 1664525u + 1013904223u;
+            int x = (int)(i / 4 % size), y = (int)(i / 4 / size);
+            pixels[i] = (unsigned char)(x ^ y);
+            pixels[i + 1] = (unsigned char)(seed >> 24);
+            pixels[i + 2] = (unsigned char)((x * y) >> 4);
+            pixels[i + 3] = 255;
+        }
+
+        JobSystem serial(0);
+        JobSystem& jobs = JobSystem::Get();
+        std::vector<MipPath> paths = { MipPath::Scalar };
+        if (MipGenerator::GetBestPath() != MipPath::Scalar)
+            paths.push_back(MipPath::SSE);
+        if (MipGenerator::GetBestPath() == MipPath::AVX2)
+            paths.push_back(MipPath::AVX2);
+        const char* pathNames[] = { "scalar", "sse", "avx2" };
+
+        for (MipFilter filter : { MipFilter::Box, MipFilter::Kaiser }) {
+            for (bool srgb : { false, true }) {
+                for (MipPath path : paths) {
+                    MipGenerator generator(filter, srgb, path);
+                    double ms[2];
+                    for (int threaded = 0; threaded < 2; threaded++) {
+                        auto start = Clock::now();
+                        for (int run = 0; run < runs; run++)
+                            generator.Generate(pixels.data(), size, size, threaded ? jobs : serial);
+                        ms[threaded] = ElapsedMs(start) / runs;
+                    }
+                    double megapixels = (double)size * size / 1e6;
+                    std::cout << "[mipmaps] " << (filter == MipFilter::Box ? "box" : "kaiser") << (srgb ? " srgb " : " linear ")
+                        << pathNames[(int)path] << ": " << megapixels / ms[0] * 1000.0 << " MPixels/s on one thread, "
+                        << megapixels / ms[1] * 1000.0 << " MPixels/s on " << jobs.GetWorkerCount() + 1 << " threads" << std::endl;
+                }
+            }
+        }
+
+        //Same chain built by the driver, for reference
+        Texture texture(size, size, pixels.data());
+        texture.Bind();
+        glFinish();
+        auto start = Clock::now();
+        for (int run = 0; run < runs; run++)
+            glGenerateMipmap(GL_TEXTURE_2D);
+        glFinish();
+        std::cout << "[mipmaps] glGenerateMipmap: " << (double)size * size / 1e6 / (ElapsedMs(start) / runs) * 1000.0 << " MPixels/s" << std::endl;
+    }
+
+    //The logo through every block format: encode throughput on one thread and on the pool,
+    //quality, size, and what the upload costs compared to RGBA8
+    void BlockCompression(GLFWwindow* window, int frames)
+    {
+        int width, height, channels;
+        stbi_set_flip_vertically_on_load(1);
+        unsigned char* pixels = stbi_load("res/textures/ChernoLogo.png", &width, &height, &channels, 4);
+        if (!pixels)
+            return;
+
+        auto uploadMs = [](const std::function<void()>& create) {
+            glFinish();
+            auto start = Clock::now();
+            create();
+            glFinish();
+            return ElapsedMs(start);
+        };
+        double rgbaMs = uploadMs([&]() { Texture texture(width, height, pixels); });
+        std::cout << "[compression] RGBA8 " << width << "x" << height << ": " << (size_t)width * height * 4 / 1024 << " KB, upload " << rgbaMs << " ms" << std::endl;
+
+        JobSystem serial(0);
+        for (BlockFormat format : { BlockFormat::BC1, BlockFormat::BC3, BlockFormat::BC4, BlockFormat::BC5, BlockFormat::BC7 }) {
+            BlockCompressor compressor(format);
+            CompressionStats single, threaded;
+            compressor.Compress(pixels, width, height, serial, nullptr, &single);
+            CompressedImage image = compressor.Compress(pixels, width, height, JobSystem::Get(), nullptr, &threaded);
+
+            bool supported = BlockCompressor::IsSupported(format, false);
+            double ms = uploadMs([&]() { Texture texture(image); });
+            std::cout << "[compression] " << BlockCompressor::GetName(format) << ": " << single.MPixelsPerSecond(width, height) << " MPixels/s on one thread, "
+                << threaded.MPixelsPerSecond(width, height) << " on " << JobSystem::Get().GetWorkerCount() + 1 << ", PSNR " << threaded.PSNR << " dB, "
+                << threaded.CompressedBytes / 1024 << " KB (" << threaded.Savings() << "% saved), upload " << ms << " ms"
+                << (supported ? "" : " (not supported, decoded to RGBA8)") << std::endl;
+        }
+        stbi_image_free(pixels);
+    }
+
+    //1 GB of RGBA8 texels (the 4 MB logo 256 times, with mips) created and destroyed: decoding
+    //the PNG and building the chain every time, against a BC7 DDS that is mapped and uploaded as is.
+    //Every texture comes from its own copy of the file, so each open maps pages it has not seen.
+    void ContainerLoading(GLFWwindow* window, int frames)
+    {
+        const int count = 256;
+        const char* png = "res/textures/ChernoLogo.png";
+
+        //Unflipped for the DDS, it stores the top row first
+        int width, height, channels;
+        stbi_set_flip_vertically_on_load(0);
+        unsigned char* pixels = stbi_load(png, &width, &height, &channels, 4);
+        stbi_set_flip_vertically_on_load(1);
+        if (!pixels)
+            return;
+        std::vector<MipLevel> mips = MipGenerator(MipFilter::Box, false).Generate(pixels, width, height, JobSystem::Get());
+        CompressedImage image = BlockCompressor(BlockFormat::BC7).Compress(pixels, width, height, JobSystem::Get(), &mips);
+        image.TopFirst = true;
+        stbi_image_free(pixels);
+
+        std::vector<unsigned char> pngBytes;
+        if (FILE* file = fopen(png, "rb")) {
+            unsigned char buffer[65536];
+            size_t read;
+            while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+                pngBytes.insert(pngBytes.end(), buffer, buffer + read);
+            fclose(file);
+        }
+
+        std::vector<std::string> pngs, ddss;
+        bool written = !pngBytes.empty();
+        for (int i = 0; i < count && written; i++) {
+            pngs.push_back("res/textures/.bench_containers_" + std::to_string(i) + ".png");
+            ddss.push_back("res/textures/.bench_containers_" + std::to_string(i) + ".dds");
+            FILE* copy = fopen(pngs.back().c_str(), "wb");
+            written = copy && fwrite(pngBytes.data(), 1, pngBytes.size(), copy) == pngBytes.size();
+            if (copy)
+                fclose(copy);
+            written = written && WriteDDS(ddss.back(), image);
+        }
+        auto removeFiles = [&]() {
+            for (const std::string& path : pngs)
+                std::remove(path.c_str());
+            for (const std::string& path : ddss)
+                std::remove(path.c_str());
+        };
+        if (!written) {
+            std::cout << "[containers] skipped, could not write the test files" << std::endl;
+            removeFiles();
+            return;
+        }
+
+        TextureOptions options;
+        options.Mipmaps = true;
+        glFinish();
+        auto start = Clock::now();
+        for (const std::string& path : pngs)
+            Texture texture(path, options);
+        glFinish();
+        double pngMs = ElapsedMs(start);
+
+        size_t mapped = 0;
+        start = Clock::now();
+        for (const std::string& path : ddss) {
+            TextureFile file;
+            if (!file.Open(path))
+                break;
+            Texture texture(file);
+            mapped += file.GetFileSize();
+        }
+        glFinish();
+        double ddsMs = ElapsedMs(start);
+        removeFiles();
+
+        double texels = (double)width * height * 4 * count / (1024.0 * 1024.0);
+        std::cout << "[containers] " << count << " x " << width << "x" << height << " (" << texels << " MB of RGBA8 level 0)" << std::endl;
+        std::cout << "[containers] PNG + CPU mips: " << pngMs << " ms, " << pngMs / count << " ms per texture" << std::endl;
+        std::cout << "[containers] mapped BC7 DDS: " << ddsMs << " ms, " << ddsMs / count << " ms per texture, "
+            << mapped / (1024 * 1024) << " MB read (" << pngMs / ddsMs << "x faster)" << std::endl;
+        if (!BlockCompressor::IsSupported(BlockFormat::BC7, false))
+            std::cout << "[containers] BC7 is not supported by this GL, the DDS numbers are not meaningful" << std::endl;
+    }
+
+    //64 mipmapped 512x512 textures (about 85 MB) under a 32 MB budget, drawn 16 at a time from a
+    //window that slides over them: the ones that scroll out lose top levels, the ones that come
+    //back get reloaded. Every path is requested twice plus once through a copy of the file.
+    void TextureResidency(GLFWwindow* window, int frames)
+    {
+        const int textureCount = 64;
+        const int textureSize = 512;
+        const int visible = 16;
+        const glm::vec2 quadSize = { 960.0f / 4, 540.0f / 4 };
+
+        std::vector<std::string> paths;
+        for (int i = 0; i < textureCount; i++) {
+            paths.push_back("texbench_" + std::to_string(i) + ".tga");
+            WriteTestTexture(paths.back(), textureSize, i);
+        }
+        WriteTestTexture("texbench_copy.tga", textureSize, 0);
+
+        TextureManager& manager = TextureManager::Get();
+        size_t budget = manager.GetBudget();
+        manager.SetBudget(32 * 1024 * 1024);
+
+        TextureOptions options;
+        options.Mipmaps = true;
+        std::vector<TextureHandle> textures;
+        for (const std::string& path : paths)
+            textures.push_back(manager.Load(path, options));
+        for (const std::string& path : paths)
+            manager.Load(path, options);
+        TextureHandle duplicate = manager.Load("./texbench_copy.tga", options);
+
+        Renderer renderer;
+        Shader shader;
+        shader.CreateShader("res/shaders/Batch.shader");
+        shader.Bind();
+        shader.SetUniformMat4f("u_MVP", ScreenProjection());
+        while (TextureLoader::Get().GetPendingCount() > 0)
+            renderer.EndFrame();
+        renderer.EndFrame();
+
+        //The copy was hashed by its worker and merged, asking again returns the first texture
+        //while the duplicate stays valid for its handle
+        TextureHandle copy = manager.Load("texbench_copy.tga", options);
+        std::cout << "[residency] " << manager.GetStats().Requests << " requests, " << manager.GetStats().PathHits << " path hits, "
+            << manager.GetStats().ContentHits << " content hits, copy shares the texture: " << (copy == textures[0] ? "yes" : "no") << std::endl;
+
+        double worstMs = 0.0, totalMs = 0.0;
+        size_t peak = 0;
+        for (int frame = 0; frame < frames; frame++) {
+            auto start = Clock::now();
+            int first = (frame / 4) % textureCount;
+            renderer.Clear();
+            renderer.BeginBatch(shader);
+            for (int i = 0; i < visible; i++) {
+                glm::vec2 position((i % 4) * quadSize.x, (i / 4) * quadSize.y);
+                renderer.DrawQuad(position, quadSize, *textures[(first + i) % textureCount]);
+            }
+            renderer.EndBatch();
+            renderer.EndFrame();
+            glFinish();
+            double ms = ElapsedMs(start);
+            worstMs = std::max(worstMs, ms);
+            totalMs += ms;
+            peak = std::max(peak, manager.GetStats().ResidentBytes);
+
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+        }
+
+        const TextureManagerStats& stats = manager.GetStats();
+        std::cout << "[residency] " << frames << " frames, " << totalMs / std::max(frames, 1) << " ms/frame, worst " << worstMs << " ms" << std::endl;
+        std::cout << "[residency] " << stats.ResidentBytes / (1024 * 1024) << " MB resident (peak " << peak / (1024 * 1024) << ") of "
+            << stats.Budget / (1024 * 1024) << " MB, " << stats.Evicted << " textures evicted, " << stats.DroppedLevels << " levels dropped ("
+            << stats.DroppedBytes / (1024 * 1024) << " MB), " << stats.Reloads << " reloads (" << stats.FailedReloads << " failed)" << std::endl;
+
+        textures.clear();
+        copy.reset();
+        manager.SetBudget(budget);
+        for (const std::string& path : paths)
+            remove(path.c_str());
+        remove("texbench_copy.tga");
+    }
+
+    //A 4096x4096 virtual texture (85 MB with mips) through an atlas of 64 tiles (4.7 MB): the
+    //view zooms from the whole texture down to level 0 and pans, the feedback decides what streams in
+    void VirtualTexturing(GLFWwindow* window, int frames)
+    {
+        const int size = 4096;
+        const char* path = "texbench_virtual.vtex";
+        {
+            std::vector<unsigned char> pixels((size_t)size * size * 4);
+            for (int y = 0; y < size; y++) {
+                for (int x = 0; x < size; x++) {
+                    unsigned char* p = &pixels[((size_t)y * size + x) * 4];
+                    bool line = (x % 256) < 4 || (y % 256) < 4;
+                    p[0] = line ? 255 : (unsigned char)(x / 16);
+                    p[1] = line ? 255 : (unsigned char)(y / 16);
+                    p[2] = (unsigned char)((x ^ y) & 0xff);
+                    p[3] = 255;
+                }
+            }
+            auto start = Clock::now();
+            if (!CookVirtualTexture(pixels.data(), size, path))
+                return;
+            std::cout << "[virtual] cooked " << size << "x" << size << " in " << ElapsedMs(start) << " ms" << std::endl;
+        }
+
+        const float side = 540.0f;
+        float positions[] = {
+            0.0f, 0.0f, 0.0f, 0.0f,
+            side, 0.0f, 1.0f, 0.0f,
+            side, side, 1.0f, 1.0f,
+            0.0f, side, 0.0f, 1.0f
+        };
+        unsigned int indices[] = { 0,1,2,2,3,0 };
+        VertexArray vao;
+        VertexBuffer vbo(positions, sizeof(positions));
+        IndexBuffer ibo(indices, 6);
+        VertexBufferLayout layout;
+        layout.Push<float>(2);
+        layout.Push<float>(2);
+        vao.AddBuffer(vbo, layout);
+
+        ShaderVariants variants("res/shaders/Virtual.shader");
+        if (!variants.IsValid()) {
+            std::cout << "[virtual] skipped, Virtual.shader failed to load" << std::endl;
+            std::remove(path);
+            return;
+        }
+        Shader& shader = variants.Get({});
+        Shader& feedbackShader = variants.Get({ "FEEDBACK" });
+
+        {
+            VirtualTexture texture(path, 8);
+            VirtualFeedback feedback(960, 540);
+            Renderer renderer;
+            std::vector<uint32_t> tiles;
+            unsigned int evictions = 0;
+            double worstMs = 0.0, totalMs = 0.0;
+            for (int frame = 0; frame < frames; frame++) {
+                auto start = Clock::now();
+                //From the whole texture on 270 pixels (level 3) to 2 pixels per level 0 texel
+                float t = frame / 120.0f;
+                float zoom = std::exp2(1.5f + 2.5f * std::sin(t));
+                glm::vec2 focus(0.5f + 0.4f * std::cos(t * 0.7f), 0.5f + 0.4f * std::sin(t * 0.9f));
+                glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(480.0f, 270.0f, 0.0f));
+                model = glm::scale(model, glm::vec3(zoom, zoom, 1.0f));
+                model = glm::translate(model, glm::vec3(-focus * side, 0.0f));
+                glm::mat4 mvp = ScreenProjection() * model;
+
+                feedback.Begin();
+                texture.Bind(feedbackShader, 0, 1, feedback.GetLodBias());
+                feedbackShader.SetUniformMat4f("u_MVP", mvp);
+                renderer.Draw(vao, ibo, feedbackShader);
+                feedback.End();
+                feedback.Collect(tiles);
+                texture.Update(tiles);
+                evictions += texture.GetStats().Evictions;
+
+                renderer.Clear();
+                texture.Bind(shader);
+                shader.SetUniformMat4f("u_MVP", mvp);
+                renderer.Draw(vao, ibo, shader);
+                renderer.EndFrame();
+                glFinish();
+                double ms = ElapsedMs(start);
+                worstMs = std::max(worstMs, ms);
+                totalMs += ms;
+
+                glfwSwapBuffers(window);
+                glfwPollEvents();
+            }
+
+            const VirtualTextureStats& stats = texture.GetStats();
+            std::cout << "[virtual] " << frames << " frames, " << totalMs / std::max(frames, 1) << " ms/frame, worst " << worstMs << " ms, feedback "
+                << feedback.GetWidth() << "x" << feedback.GetHeight() << std::endl;
+            std::cout << "[virtual] hit rate " << stats.HitRate() << "%, " << stats.TotalUploads << " tiles uploaded ("
+                << stats.BytesUploaded / (1024 * 1024) << " MB at " << stats.UploadMBPerSecond() << " MB/s), " << evictions << " evictions, "
+                << stats.Resident << " resident" << std::endl;
+        }
+        remove(path);
+    }
+
+    //City blocks: the buildings occlude, small props scattered between and behind them get tested
+    void OcclusionCulling(GLFWwindow* window, int frames)
+    {
+        const int blocks = 24;
+        const unsigned int propCount = 100000;
+
+        const glm::vec3 cubeVertices[] = {
+            { 0.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 1.0f, 1.0f, 0.0f }, { 0.0f, 1.0f, 0.0f },
+            { 0.0f, 0.0f, 1.0f }, { 1.0f, 0.0f, 1.0f }, { 1.0f, 1.0f, 1.0f }, { 0.0f, 1.0f, 1.0f }
+        };
+        const unsigned int cubeIndices[] = {
+            0, 1, 2, 0, 2, 3,  4, 6, 5, 4, 7, 6,  0, 4, 5, 0, 5, 1,
+            3, 2, 6, 3, 6, 7,  0, 3, 7, 0, 7, 4,  1, 5, 6, 1, 6, 2
+        };
+
+        unsigned int seed = 1337;
+        auto next = [&seed]() { seed = seed * 1664525u + 1013904223u; return (seed >> 8) / 16777216.0f; };
+
+        OcclusionCuller culler;
+        for (int z = 0; z < blocks; z++) {
+            for (int x = 0; x < blocks; x++) {
+                glm::vec3 position(x * 40.0f - blocks * 20.0f + 5.0f, 0.0f, z * 40.0f - blocks * 20.0f + 5.0f);
+                glm::vec3 size(30.0f, 20.0f + next() * 60.0f, 30.0f);
+                culler.AddOccluder(cubeVertices, cubeIndices, 36, glm::scale(glm::translate(glm::mat4(1.0f), position), size));
+            }
+        }
+
+        std::vector<glm::vec3> mins(propCount), maxs(propCount);
+        for (unsigned int i = 0; i < propCount; i++) {
+            mins[i] = glm::vec3((next() - 0.5f) * blocks * 40.0f, 0.0f, (next() - 0.5f) * blocks * 40.0f);
+            maxs[i] = mins[i] + glm::vec3(1.0f, 1.0f + next() * 3.0f, 1.0f);
+        }
+
+        glm::mat4 proj = glm::perspective(glm::radians(60.0f), 960.0f / 540.0f, 0.5f, 1000.0f);
+        auto viewProj = [&proj](int frame) {
+            //Walk down the street between two rows of blocks, looking around
+            glm::vec3 eye(0.0f, 2.0f, 400.0f - frame * 2.0f);
+            glm::vec3 dir(sinf(frame * 0.02f) * 0.5f, -0.05f, -1.0f);
+            return proj * glm::lookAt(eye, eye + dir, glm::vec3(0.0f, 1.0f, 0.0f));
+        };
+
+        JobSystem& jobs = JobSystem::Get();
+        std::vector<unsigned int> visible;
+        double rasterMs = 0.0, hizMs = 0.0, testMs = 0.0, culledPercent = 0.0;
+        for (int frame = 0; frame < frames; frame++) {
+            culler.Render(viewProj(frame), jobs);
+            culler.Cull(mins.data(), maxs.data(), propCount, visible, jobs);
+            const OcclusionStats& stats = culler.GetStats();
+            rasterMs += stats.RasterMs;
+            hizMs += stats.HiZMs;
+            testMs += stats.TestMs;
+            culledPercent += stats.CulledPercent();
+        }
+        std::cout << "[occlusion] " << culler.GetWidth() << "x" << culler.GetHeight() << ", " << culler.GetStats().OccluderTriangles
+            << " occluder triangles, " << propCount << " occludees, " << jobs.GetWorkerCount() + 1 << " threads" << std::endl;
+        std::cout << "[occlusion] raster " << rasterMs / frames << " ms, hi-z " << hizMs / frames << " ms, test "
+            << testMs / frames << " ms, " << culledPercent / frames << "% culled" << std::endl;
+
+        //Same frame on one thread must give the same depth buffer and the same survivors
+        JobSystem serial(0);
+        OcclusionCuller reference = culler;
+        std::vector<unsigned int> referenceVisible;
+        reference.Render(viewProj(frames / 2), serial);
+        reference.Cull(mins.data(), maxs.data(), propCount, referenceVisible, serial);
+        culler.Render(viewProj(frames / 2), jobs);
+        culler.Cull(mins.data(), maxs.data(), propCount, visible, jobs);
+        bool same = visible == referenceVisible && std::equal(culler.GetDepth(), culler.GetDepth() + culler.GetWidth() * culler.GetHeight(), reference.GetDepth());
+        std::cout << "[occlusion] single threaded result " << (same ? "matches" : "DIFFERS") << std::endl;
+    }
+
+    struct BenchmarkEntry {
+        const char* Name;
+        void (*Run)(GLFWwindow* window, int frames);
+    };
+
+    const BenchmarkEntry s_Benchmarks[] = {
+        { "batch", BatchQuads },
+        { "instanced", InstancedQuads },
+        { "queue", SortedQueue },
+        { "indirect", MultiDrawIndirect },
+        { "commandlists", CommandLists },
+        { "culling", FrustumCulling },
+        { "occlusion", OcclusionCulling },
+        { "uniformblocks", UniformBlocks },
+        { "uniformlookup", UniformLookup },
+        { "shadercache", ShaderCache },
+        { "asyncshaders", AsyncShaders },
+        { "permutations", Permutations },
+        { "textureloading", TextureLoading },
+        { "atlas", AtlasSprites },
+        { "texturearray", ArraySprites },
+        { "mipmaps", MipGeneration },
+        { "compression", BlockCompression },
+        { "containers", ContainerLoading },
+        { "residency", TextureResidency },
+        { "virtual", VirtualTexturing },
+    };
+}
+
+int RunBenchmark(GLFWwindow* window, const std::string& name, int frames)
+{
+    for (const BenchmarkEntry& entry : s_Benchmarks) {
+        if (name == entry.Name) {
+            entry.Run(window, frames);
+            return 0;
+        }
+    }
+
+    std::cout << "Unknown benchmark " << name << ", available:";
+    for (const BenchmarkEntry& entry : s_Benchmarks)
+        std::cout << " " << entry.Name;
+    std::cout << std::endl;
+    return 1;
+}
\ No newline at end of file
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <string>
+
+struct GLFWwindow;
+
+//Benchmark scenes, started with `opengl --bench <name> [frames]`.
+//The window is created hidden so they also run headless (e.g. Mesa llvmpipe under Xvfb).
+int RunBenchmark(GLFWwindow* window, const std::string& name, int frames);
\ No newline at end of file
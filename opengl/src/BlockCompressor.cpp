@@ -0,0 +1,614 @@
+#include "BlockCompressor.h"
+#include "JobSystem.h"
+#include "Simd.h"
+
+#include <GL/glew.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace {
+	using Clock = std::chrono::high_resolution_clock;
+
+	//16 pixels of a block as floats, one array per channel
+	struct Block {
+		alignas(16) float Channel[4][16];
+	};
+
+	const int BC7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	//Pixels past the right or top edge repeat the last column or row
+	void FetchBlock(const unsigned char* pixels, int width, int height, int blockX, int blockY, Block& block)
+	{
+		for (int y = 0; y < 4; y++) {
+			int row = std::min(blockY * 4 + y, height - 1);
+			for (int x = 0; x < 4; x++) {
+				int column = std::min(blockX * 4 + x, width - 1);
+				const unsigned char* pixel = pixels + ((size_t)row * width + column) * 4;
+				for (int c = 0; c < 4; c++)
+					block.Channel[c][y * 4 + x] = pixel[c];
+			}
+		}
+	}
+
+	void ChannelRange(const Block& block, int channel, float& min, float& max)
+	{
+		const float* values = block.Channel[channel];
+#if defined(SIMD_SSE2)
+		__m128 low = _mm_load_ps(values), high = low;
+		for (int i = 4; i < 16; i += 4) {
+			__m128 v = _mm_load_ps(values + i);
+			low = _mm_min_ps(low, v);
+			high = _mm_max_ps(high, v);
+		}
+		low = _mm_min_ps(low, _mm_shuffle_ps(low, low, _MM_SHUFFLE(1, 0, 3, 2)));
+		low = _mm_min_ps(low, _mm_shuffle_ps(low, low, _MM_SHUFFLE(2, 3, 0, 1)));
+		high = _mm_max_ps(high, _mm_shuffle_ps(high, high, _MM_SHUFFLE(1, 0, 3, 2)));
+		high = _mm_max_ps(high, _mm_shuffle_ps(high, high, _MM_SHUFFLE(2, 3, 0, 1)));
+		min = _mm_cvtss_f32(low);
+		max = _mm_cvtss_f32(high);
+#else
+		min = max = values[0];
+		for (int i = 1; i < 16; i++) {
+			min = std::min(min, values[i]);
+			max = std::max(max, values[i]);
+		}
+#endif
+	}
+
+	//Position of every pixel along the line from e0 to e1 in [0, steps], rounded to nearest
+	void ProjectIndices(const Block& block, const float* e0, const float* e1, int firstChannel, int channels, int steps, int* indices)
+	{
+		float direction[4] = {}, length = 0.0f;
+		for (int c = 0; c < channels; c++) {
+			direction[c] = e1[c] - e0[c];
+			length += direction[c] * direction[c];
+		}
+		if (length == 0.0f) {
+			std::fill(indices, indices + 16, 0);
+			return;
+		}
+		float scale = steps / length;
+
+#if defined(SIMD_SSE2)
+		const __m128 zero = _mm_setzero_ps(), last = _mm_set1_ps((float)steps);
+		for (int i = 0; i < 16; i += 4) {
+			__m128 dot = _mm_setzero_ps();
+			for (int c = 0; c < channels; c++) {
+				__m128 offset = _mm_sub_ps(_mm_load_ps(block.Channel[firstChannel + c] + i), _mm_set1_ps(e0[c]));
+				dot = _mm_add_ps(dot, _mm_mul_ps(offset, _mm_set1_ps(direction[c])));
+			}
+			__m128 t = _mm_min_ps(_mm_max_ps(_mm_mul_ps(dot, _mm_set1_ps(scale)), zero), last);
+			_mm_storeu_si128((__m128i*)(indices + i), _mm_cvtps_epi32(t));
+		}
+#else
+		for (int i = 0; i < 16; i++) {
+			float dot = 0.0f;
+			for (int c = 0; c < channels; c++)
+				dot += (block.Channel[firstChannel + c][i] - e0[c]) * direction[c];
+			float t = std::min(std::max(dot * scale, 0.0f), (float)steps);
+			indices[i] = (int)(t + 0.5f);
+		}
+#endif
+	}
+
+	inline unsigned short To565(const float* color)
+	{
+		int r = (int)(color[0] * (31.0f / 255.0f) + 0.5f);
+		int g = (int)(color[1] * (63.0f / 255.0f) + 0.5f);
+		int b = (int)(color[2] * (31.0f / 255.0f) + 0.5f);
+		return (unsigned short)((r << 11) | (g << 5) | b);
+	}
+
+	inline void From565(unsigned short value, int* color)
+	{
+		int r = (value >> 11) & 31, g = (value >> 5) & 63, b = value & 31;
+		color[0] = (r << 3) | (r >> 2);
+		color[1] = (g << 2) | (g >> 4);
+		color[2] = (b << 3) | (b >> 2);
+	}
+
+	inline void Write16(unsigned char* out, unsigned int value)
+	{
+		out[0] = (unsigned char)value;
+		out[1] = (unsigned char)(value >> 8);
+	}
+
+	void EncodeBC1(const Block& block, unsigned char* out)
+	{
+		float min[3], max[3], center[3];
+		int reference = 0;
+		for (int c = 0; c < 3; c++) {
+			ChannelRange(block, c, min[c], max[c]);
+			center[c] = (min[c] + max[c]) * 0.5f;
+			if (max[c] - min[c] > max[reference] - min[reference])
+				reference = c;
+		}
+
+		//The bounding box has four diagonals, take the one the colors run along
+		float e0[3], e1[3];
+		for (int c = 0; c < 3; c++) {
+			float covariance = 0.0f;
+			for (int i = 0; i < 16; i++)
+				covariance += (block.Channel[reference][i] - center[reference]) * (block.Channel[c][i] - center[c]);
+			//Inset by 1/16 of the range, the extremes are rarely worth a palette entry each
+			float inset = (max[c] - min[c]) / 16.0f;
+			e0[c] = covariance < 0.0f ? min[c] + inset : max[c] - inset;
+			e1[c] = covariance < 0.0f ? max[c] - inset : min[c] + inset;
+		}
+
+		unsigned short c0 = To565(e0), c1 = To565(e1);
+		if (c0 < c1)
+			std::swap(c0, c1);
+		Write16(out, c0);
+		Write16(out + 2, c1);
+
+		unsigned int bits = 0;
+		if (c0 != c1) {
+			int p0[3], p1[3];
+			From565(c0, p0);
+			From565(c1, p1);
+			float f0[3] = { (float)p0[0], (float)p0[1], (float)p0[2] };
+			float f1[3] = { (float)p1[0], (float)p1[1], (float)p1[2] };
+
+			//Line position 0..3 to BC1 code: c0, 2/3 c0 + 1/3 c1, 1/3 c0 + 2/3 c1, c1
+			static const unsigned int codes[4] = { 0, 2, 3, 1 };
+			int indices[16];
+			ProjectIndices(block, f0, f1, 0, 3, 3, indices);
+			for (int i = 0; i < 16; i++)
+				bits |= codes[indices[i]] << (i * 2);
+		}
+		Write16(out + 4, bits & 0xffff);
+		Write16(out + 6, bits >> 16);
+	}
+
+	void EncodeBC4(const Block& block, int channel, unsigned char* out)
+	{
+		float min, max;
+		ChannelRange(block, channel, min, max);
+		out[0] = (unsigned char)max;
+		out[1] = (unsigned char)min;
+
+		unsigned long long bits = 0;
+		if (max > min) {
+			//max > min selects the eight value palette: r0, r1, then six steps from r0 to r1
+			static const unsigned long long codes[8] = { 0, 2, 3, 4, 5, 6, 7, 1 };
+			int indices[16];
+			ProjectIndices(block, &max, &min, channel, 1, 7, indices);
+			for (int i = 0; i < 16; i++)
+				bits |= codes[indices[i]] << (i * 3);
+		}
+		for (int i = 0; i < 6; i++)
+			out[2 + i] = (unsigned char)(bits >> (i * 8));
+	}
+
+	struct BC7Candidate {
+		int Quantized[2][4]; //7 bit
+		int PBit[2];
+		int Indices[16];
+		float Error;
+	};
+
+	//Quantizes both endpoints with the better p-bit each, then picks every index by exact error
+	void EvaluateBC7(const Block& block, const float* e0, const float* e1, BC7Candidate& candidate)
+	{
+		const float* endpoints[2] = { e0, e1 };
+		int decoded[2][4];
+		for (int e = 0; e < 2; e++) {
+			float bestError = 1e30f;
+			for (int p = 0; p < 2; p++) {
+				int quantized[4], value[4];
+				float error = 0.0f;
+				for (int c = 0; c < 4; c++) {
+					quantized[c] = std::min(std::max((int)std::floor((endpoints[e][c] - p) * 0.5f + 0.5f), 0), 127);
+					value[c] = (quantized[c] << 1) | p;
+					error += (value[c] - endpoints[e][c]) * (value[c] - endpoints[e][c]);
+				}
+				if (error < bestError) {
+					bestError = error;
+					candidate.PBit[e] = p;
+					memcpy(candidate.Quantized[e], quantized, sizeof(quantized));
+					memcpy(decoded[e], value, sizeof(value));
+				}
+			}
+		}
+
+		int palette[16][4];
+		for (int i = 0; i < 16; i++)
+			for (int c = 0; c < 4; c++)
+				palette[i][c] = ((64 - BC7Weights[i]) * decoded[0][c] + BC7Weights[i] * decoded[1][c] + 32) >> 6;
+
+		//Projection gets within one step, the weights aren't evenly spaced so check the neighbors
+		float f0[4], f1[4];
+		for (int c = 0; c < 4; c++) {
+			f0[c] = (float)decoded[0][c];
+			f1[c] = (float)decoded[1][c];
+		}
+		ProjectIndices(block, f0, f1, 0, 4, 15, candidate.Indices);
+
+		candidate.Error = 0.0f;
+		for (int i = 0; i < 16; i++) {
+			int best = candidate.Indices[i];
+			float bestError = 1e30f;
+			for (int index = std::max(best - 1, 0); index <= std::min(best + 1, 15); index++) {
+				float error = 0.0f;
+				for (int c = 0; c < 4; c++) {
+					float d = palette[index][c] - block.Channel[c][i];
+					error += d * d;
+				}
+				if (error < bestError) {
+					bestError = error;
+					best = index;
+				}
+			}
+			candidate.Indices[i] = best;
+			candidate.Error += bestError;
+		}
+	}
+
+	struct BitWriter {
+		unsigned char* Out;
+		unsigned int Position = 0;
+
+		void Write(unsigned int value, unsigned int bits)
+		{
+			for (unsigned int i = 0; i < bits; i++, Position++)
+				if (value & (1u << i))
+					Out[Position >> 3] |= (unsigned char)(1u << (Position & 7));
+		}
+	};
+
+	void EncodeBC7(const Block& block, unsigned char* out)
+	{
+		float mean[4] = {};
+		for (int c = 0; c < 4; c++) {
+			for (int i = 0; i < 16; i++)
+				mean[c] += block.Channel[c][i];
+			mean[c] /= 16.0f;
+		}
+
+		float covariance[4][4] = {};
+		for (int i = 0; i < 16; i++) {
+			float d[4];
+			for (int c = 0; c < 4; c++)
+				d[c] = block.Channel[c][i] - mean[c];
+			for (int a = 0; a < 4; a++)
+				for (int b = 0; b < 4; b++)
+					covariance[a][b] += d[a] * d[b];
+		}
+
+		//Principal axis by power iteration
+		float axis[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+		for (int iteration = 0; iteration < 8; iteration++) {
+			float next[4] = {}, length = 0.0f;
+			for (int a = 0; a < 4; a++) {
+				for (int b = 0; b < 4; b++)
+					next[a] += covariance[a][b] * axis[b];
+				length += next[a] * next[a];
+			}
+			if (length < 1e-12f)
+				break;
+			length = 1.0f / std::sqrt(length);
+			for (int a = 0; a < 4; a++)
+				axis[a] = next[a] * length;
+		}
+
+		float low = 0.0f, high = 0.0f;
+		for (int i = 0; i < 16; i++) {
+			float t = 0.0f;
+			for (int c = 0; c < 4; c++)
+				t += (block.Channel[c][i] - mean[c]) * axis[c];
+			low = std::min(low, t);
+			high = std::max(high, t);
+		}
+
+		float e0[4], e1[4];
+		for (int c = 0; c < 4; c++) {
+			e0[c] = std::min(std::max(mean[c] + axis[c] * low, 0.0f), 255.0f);
+			e1[c] = std::min(std::max(mean[c] + axis[c] * high, 0.0f), 255.0f);
+		}
+
+		BC7Candidate best, candidate;
+		EvaluateBC7(block, e0, e1, best);
+
+		//Least squares endpoints for the chosen weights, kept only while they help
+		for (int iteration = 0; iteration < 2 && best.Error > 0.0f; iteration++) {
+			float a = 0.0f, b = 0.0f, d = 0.0f, x[4] = {}, y[4] = {};
+			for (int i = 0; i < 16; i++) {
+				float w = BC7Weights[best.Indices[i]] / 64.0f;
+				a += (1.0f - w) * (1.0f - w);
+				b += (1.0f - w) * w;
+				d += w * w;
+				for (int c = 0; c < 4; c++) {
+					x[c] += (1.0f - w) * block.Channel[c][i];
+					y[c] += w * block.Channel[c][i];
+				}
+			}
+			float determinant = a * d - b * b;
+			if (std::fabs(determinant) < 1e-6f)
+				break;
+			for (int c = 0; c < 4; c++) {
+				e0[c] = std::min(std::max((d * x[c] - b * y[c]) / determinant, 0.0f), 255.0f);
+				e1[c] = std::min(std::max((a * y[c] - b * x[c]) / determinant, 0.0f), 255.0f);
+			}
+			EvaluateBC7(block, e0, e1, candidate);
+			if (candidate.Error >= best.Error)
+				break;
+			best = candidate;
+		}
+
+		//The first index is stored with 3 bits, its top bit has to be 0
+		if (best.Indices[0] >= 8) {
+			std::swap(best.Quantized[0], best.Quantized[1]);
+			std::swap(best.PBit[0], best.PBit[1]);
+			for (int& index : best.Indices)
+				index = 15 - index;
+		}
+
+		memset(out, 0, 16);
+		BitWriter writer = { out };
+		writer.Write(1 << 6, 7); //mode 6
+		for (int c = 0; c < 4; c++) {
+			writer.Write(best.Quantized[0][c], 7);
+			writer.Write(best.Quantized[1][c], 7);
+		}
+		writer.Write(best.PBit[0], 1);
+		writer.Write(best.PBit[1], 1);
+		writer.Write(best.Indices[0], 3);
+		for (int i = 1; i < 16; i++)
+			writer.Write(best.Indices[i], 4);
+	}
+
+	void DecodeBC1(const unsigned char* block, unsigned char* pixels, int stride)
+	{
+		unsigned short c0 = block[0] | (block[1] << 8), c1 = block[2] | (block[3] << 8);
+		int palette[4][4];
+		From565(c0, palette[0]);
+		From565(c1, palette[1]);
+		palette[0][3] = palette[1][3] = 255;
+		for (int c = 0; c < 3; c++) {
+			if (c0 > c1) {
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+			else {
+				palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+				palette[3][c] = 0;
+			}
+		}
+		palette[2][3] = 255;
+		palette[3][3] = c0 > c1 ? 255 : 0;
+
+		unsigned int bits = block[4] | (block[5] << 8) | (block[6] << 16) | ((unsigned int)block[7] << 24);
+		for (int i = 0; i < 16; i++) {
+			const int* color = palette[(bits >> (i * 2)) & 3];
+			unsigned char* pixel = pixels + (i / 4) * stride + (i % 4) * 4;
+			for (int c = 0; c < 4; c++)
+				pixel[c] = (unsigned char)color[c];
+		}
+	}
+
+	void DecodeBC4(const unsigned char* block, unsigned char* pixels, int stride, int channel)
+	{
+		int palette[8] = { block[0], block[1] };
+		for (int i = 1; i < 7; i++) {
+			if (block[0] > block[1])
+				palette[i + 1] = ((7 - i) * block[0] + i * block[1]) / 7;
+			else if (i < 5)
+				palette[i + 1] = ((5 - i) * block[0] + i * block[1]) / 5;
+		}
+		if (block[0] <= block[1]) {
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+
+		unsigned long long bits = 0;
+		for (int i = 0; i < 6; i++)
+			bits |= (unsigned long long)block[2 + i] << (i * 8);
+		for (int i = 0; i < 16; i++)
+			pixels[(i / 4) * stride + (i % 4) * 4 + channel] = (unsigned char)palette[(bits >> (i * 3)) & 7];
+	}
+
+	//Mode 6 only, that's all the encoder writes. Other modes decode as black.
+	void DecodeBC7(const unsigned char* block, unsigned char* pixels, int stride)
+	{
+		unsigned int position = 0;
+		auto read = [&](unsigned int bits) {
+			unsigned int value = 0;
+			for (unsigned int i = 0; i < bits; i++, position++)
+				value |= ((block[position >> 3] >> (position & 7)) & 1u) << i;
+			return value;
+		};
+
+		if (read(7) != (1 << 6)) {
+			for (int i = 0; i < 16; i++)
+				memset(pixels + (i / 4) * stride + (i % 4) * 4, 0, 4);
+			return;
+		}
+		int endpoints[2][4];
+		for (int c = 0; c < 4; c++) {
+			endpoints[0][c] = read(7) << 1;
+			endpoints[1][c] = read(7) << 1;
+		}
+		int p0 = read(1), p1 = read(1);
+		for (int c = 0; c < 4; c++) {
+			endpoints[0][c] |= p0;
+			endpoints[1][c] |= p1;
+		}
+		for (int i = 0; i < 16; i++) {
+			int weight = BC7Weights[read(i == 0 ? 3 : 4)];
+			unsigned char* pixel = pixels + (i / 4) * stride + (i % 4) * 4;
+			for (int c = 0; c < 4; c++)
+				pixel[c] = (unsigned char)(((64 - weight) * endpoints[0][c] + weight * endpoints[1][c] + 32) >> 6);
+		}
+	}
+}
+
+size_t CompressedImage::GetSize() const
+{
+	size_t size = 0;
+	for (const auto& level : Levels)
+		size += level.size();
+	return size;
+}
+
+BlockCompressor::BlockCompressor(BlockFormat format, bool srgb /*= false*/)
+	:m_Format(format), m_SRGB(srgb)
+{
+}
+
+CompressedImage BlockCompressor::Compress(const unsigned char* pixels, int width, int height, JobSystem& jobs,
+	const std::vector<MipLevel>* mips /*= nullptr*/, CompressionStats* stats /*= nullptr*/) const
+{
+	auto start = Clock::now();
+	CompressedImage image;
+	image.Format = m_Format;
+	image.SRGB = m_SRGB && (m_Format == BlockFormat::BC1 || m_Format == BlockFormat::BC3 || m_Format == BlockFormat::BC7);
+	image.Width = width;
+	image.Height = height;
+
+	size_t levelCount = 1 + (mips ? mips->size() : 0);
+	image.Levels.resize(levelCount);
+	size_t uncompressed = 0;
+	for (size_t level = 0; level < levelCount; level++) {
+		int levelWidth = level ? (*mips)[level - 1].Width : width;
+		int levelHeight = level ? (*mips)[level - 1].Height : height;
+		const unsigned char* levelPixels = level ? (*mips)[level - 1].Pixels.data() : pixels;
+		image.Levels[level].resize(GetLevelSize(m_Format, levelWidth, levelHeight));
+		CompressLevel(levelPixels, levelWidth, levelHeight, image.Levels[level].data(), jobs);
+		uncompressed += (size_t)levelWidth * levelHeight * 4;
+	}
+
+	if (stats) {
+		stats->EncodeMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		stats->UncompressedBytes = uncompressed;
+		stats->CompressedBytes = image.GetSize();
+		std::vector<unsigned char> decoded((size_t)width * height * 4);
+		Decompress(m_Format, image.Levels[0].data(), width, height, decoded.data());
+		stats->PSNR = ComputePSNR(pixels, decoded.data(), width, height, GetChannelCount(m_Format));
+	}
+	return image;
+}
+
+void BlockCompressor::CompressLevel(const unsigned char* pixels, int width, int height, unsigned char* blocks, JobSystem& jobs) const
+{
+	const int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+	const unsigned int blockSize = GetBlockSize(m_Format);
+	//Enough blocks per chunk that scheduling stays cheap next to BC1's few hundred cycles a block
+	unsigned int rowsPerChunk = std::max(1, 256 / blocksX);
+
+	jobs.ParallelFor(blocksY, rowsPerChunk, [&](unsigned int begin, unsigned int end) {
+		Block block;
+		for (unsigned int y = begin; y < end; y++) {
+			for (int x = 0; x < blocksX; x++) {
+				FetchBlock(pixels, width, height, x, y, block);
+				unsigned char* out = blocks + ((size_t)y * blocksX + x) * blockSize;
+				switch (m_Format) {
+					case BlockFormat::BC1: EncodeBC1(block, out); break;
+					case BlockFormat::BC3: EncodeBC4(block, 3, out); EncodeBC1(block, out + 8); break;
+					case BlockFormat::BC4: EncodeBC4(block, 0, out); break;
+					case BlockFormat::BC5: EncodeBC4(block, 0, out); EncodeBC4(block, 1, out + 8); break;
+					case BlockFormat::BC7: EncodeBC7(block, out); break;
+				}
+			}
+		}
+	});
+}
+
+void BlockCompressor::Decompress(BlockFormat format, const unsigned char* blocks, int width, int height, unsigned char* pixels)
+{
+	const int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+	const unsigned int blockSize = GetBlockSize(format);
+	const int stride = 16;
+	unsigned char decoded[4 * 4 * 4];
+
+	for (int y = 0; y < blocksY; y++) {
+		for (int x = 0; x < blocksX; x++) {
+			const unsigned char* block = blocks + ((size_t)y * blocksX + x) * blockSize;
+			memset(decoded, 0, sizeof(decoded));
+			switch (format) {
+				case BlockFormat::BC1: DecodeBC1(block, decoded, stride); break;
+				case BlockFormat::BC3: DecodeBC1(block + 8, decoded, stride); DecodeBC4(block, decoded, stride, 3); break;
+				case BlockFormat::BC4: DecodeBC4(block, decoded, stride, 0); break;
+				case BlockFormat::BC5: DecodeBC4(block, decoded, stride, 0); DecodeBC4(block + 8, decoded, stride, 1); break;
+				case BlockFormat::BC7: DecodeBC7(block, decoded, stride); break;
+			}
+			if (format == BlockFormat::BC4 || format == BlockFormat::BC5)
+				for (int i = 0; i < 16; i++)
+					decoded[i * 4 + 3] = 255;
+
+			for (int row = 0; row < 4 && y * 4 + row < height; row++) {
+				int columns = std::min(4, width - x * 4);
+				memcpy(pixels + ((size_t)(y * 4 + row) * width + x * 4) * 4, decoded + row * stride, columns * 4);
+			}
+		}
+	}
+}
+
+double BlockCompressor::ComputePSNR(const unsigned char* a, const unsigned char* b, int width, int height, int channels)
+{
+	double sum = 0.0;
+	size_t pixels = (size_t)width * height;
+	for (size_t i = 0; i < pixels; i++) {
+		for (int c = 0; c < channels; c++) {
+			double d = (double)a[i * 4 + c] - b[i * 4 + c];
+			sum += d * d;
+		}
+	}
+	double mse = sum / (pixels * channels);
+	return mse > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : 100.0;
+}
+
+unsigned int BlockCompressor::GetBlockSize(BlockFormat format)
+{
+	return format == BlockFormat::BC1 || format == BlockFormat::BC4 ? 8 : 16;
+}
+
+size_t BlockCompressor::GetLevelSize(BlockFormat format, int width, int height)
+{
+	return (size_t)((width + 3) / 4) * ((height + 3) / 4) * GetBlockSize(format);
+}
+
+unsigned int BlockCompressor::GetChannelCount(BlockFormat format)
+{
+	switch (format) {
+		case BlockFormat::BC1: return 3;
+		case BlockFormat::BC4: return 1;
+		case BlockFormat::BC5: return 2;
+		default: return 4;
+	}
+}
+
+const char* BlockCompressor::GetName(BlockFormat format)
+{
+	static const char* names[] = { "BC1", "BC3", "BC4", "BC5", "BC7" };
+	return names[(int)format];
+}
+
+unsigned int BlockCompressor::GetGLFormat(BlockFormat format, bool srgb)
+{
+	switch (format) {
+		case BlockFormat::BC1: return srgb ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+		case BlockFormat::BC3: return srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		case BlockFormat::BC4: return GL_COMPRESSED_RED_RGTC1;
+		case BlockFormat::BC5: return GL_COMPRESSED_RG_RGTC2;
+		case BlockFormat::BC7: return srgb ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : GL_COMPRESSED_RGBA_BPTC_UNORM;
+	}
+	return 0;
+}
+
+bool BlockCompressor::IsSupported(BlockFormat format, bool srgb)
+{
+	switch (format) {
+		case BlockFormat::BC1:
+		case BlockFormat::BC3:
+			return GLEW_EXT_texture_compression_s3tc && (!srgb || GLEW_EXT_texture_sRGB);
+		case BlockFormat::BC4:
+		case BlockFormat::BC5:
+			return GLEW_VERSION_3_0 || GLEW_ARB_texture_compression_rgtc;
+		case BlockFormat::BC7:
+			return GLEW_VERSION_4_2 || GLEW_ARB_texture_compression_bptc;
+	}
+	return false;
+}
\ No newline at end of file
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "MipGenerator.h"
+
+class JobSystem;
+
+enum class BlockFormat {
+	BC1, //RGB, 4 bpp
+	BC3, //RGBA, BC1 color plus BC4 alpha, 8 bpp
+	BC4, //R, 4 bpp
+	BC5, //RG, two BC4 blocks, 8 bpp, meant for normal maps
+	BC7  //RGBA, 8 bpp, mode 6 only: one subset, 7777.1 endpoints and 4 bit indices
+};
+
+//Every level of a block compressed image, level 0 first
+struct CompressedImage {
+	BlockFormat Format = BlockFormat::BC1;
+	bool SRGB = false;
+	int Width = 0, Height = 0;
+	std::vector<std::vector<unsigned char>> Levels;
+	//Block rows run top to bottom, as DDS/KTX2 files store them. Compress keeps the row order of
+	//its input, the caller sets this when the pixels were loaded unflipped.
+	bool TopFirst = false;
+
+	size_t GetSize() const;
+};
+
+struct CompressionStats {
+	double EncodeMs = 0.0;
+	double PSNR = 0.0; //level 0, over the channels the format stores
+	size_t UncompressedBytes = 0; //RGBA8 with the same levels
+	size_t CompressedBytes = 0;
+
+	inline double MPixelsPerSecond(int width, int height) const { return EncodeMs > 0.0 ? width * height / (EncodeMs * 1000.0) : 0.0; }
+	inline double Savings() const { return UncompressedBytes ? 100.0 * (1.0 - (double)CompressedBytes / UncompressedBytes) : 0.0; }
+};
+
+//CPU encoder for the BCn formats, 4x4 blocks spread over the job system one block row per job
+//chunk. BC1/BC3/BC4/BC5 are the fast path: inset bounding box endpoints, indices by projection
+//onto the endpoint line, four pixels per SSE step. BC7 is the quality path: principal axis
+//endpoints refined by least squares, p-bits chosen per endpoint. sRGB images are encoded as
+//stored, the GL format decodes them.
+class BlockCompressor {
+private:
+	BlockFormat m_Format;
+	bool m_SRGB;
+
+public:
+	BlockCompressor(BlockFormat format, bool srgb = false);
+
+	//RGBA8 rows, bottom first like Texture uploads them. Mips from MipGenerator are compressed
+	//as further levels.
+	CompressedImage Compress(const unsigned char* pixels, int width, int height, JobSystem& jobs,
+		const std::vector<MipLevel>* mips = nullptr, CompressionStats* stats = nullptr) const;
+
+	//One level back to RGBA8, channels the format lacks come out as 0 (alpha as 255)
+	static void Decompress(BlockFormat format, const unsigned char* blocks, int width, int height, unsigned char* pixels);
+	//Over the first `channels` of RGBA8 pixels
+	static double ComputePSNR(const unsigned char* a, const unsigned char* b, int width, int height, int channels);
+
+	static unsigned int GetBlockSize(BlockFormat format);
+	static size_t GetLevelSize(BlockFormat format, int width, int height);
+	static unsigned int GetChannelCount(BlockFormat format);
+	static const char* GetName(BlockFormat format);
+	//GL internal format, sRGB ignored for BC4/BC5
+	static unsigned int GetGLFormat(BlockFormat format, bool srgb);
+	//Needs a current context
+	static bool IsSupported(BlockFormat format, bool srgb);
+
+private:
+	void CompressLevel(const unsigned char* pixels, int width, int height, unsigned char* blocks, JobSystem& jobs) const;
+};
\ No newline at end of file
@@ -0,0 +1,76 @@
+#include "CommandList.h"
+
+#include <cstring>
+
+void CommandList::Draw(RenderPass pass, const VertexArray& vao, const IndexBuffer& ibo, Shader& shader,
+    const Texture* texture, float depth)
+{
+    uint64_t key = RenderQueue::MakeKey(pass, shader.GetRendererID(), texture ? texture->GetRendererID() : 0, vao.GetRendererID(), depth);
+    m_Commands.push_back({ key, &vao, &ibo, &shader, texture, nullptr });
+    m_LastUniform = nullptr;
+}
+
+UniformCommand* CommandList::AddUniform(const char* name, UniformType type)
+{
+    //Uniforms belong to the draw recorded before them, without one the value is dropped
+    ASSERT(!m_Commands.empty());
+    UniformCommand* uniform = (UniformCommand*)m_Arena.Allocate(sizeof(UniformCommand), alignof(UniformCommand));
+    uniform->ID = UniformID(name);
+    uniform->Type = type;
+    uniform->Next = nullptr;
+
+    if (m_LastUniform)
+        m_LastUniform->Next = uniform;
+    else if (!m_Commands.empty())
+        m_Commands.back().Uniforms = uniform;
+    m_LastUniform = uniform;
+    return uniform;
+}
+
+void CommandList::SetUniform1i(const char* name, int value)
+{
+    AddUniform(name, UniformType::Int)->Int = value;
+}
+
+void CommandList::SetUniform4f(const char* name, float v0, float v1, float v2, float v3)
+{
+    float* data = AddUniform(name, UniformType::Float4)->Float4;
+    data[0] = v0;
+    data[1] = v1;
+    data[2] = v2;
+    data[3] = v3;
+}
+
+void CommandList::SetUniformMat4f(const char* name, const glm::mat4& matrix)
+{
+    memcpy(AddUniform(name, UniformType::Mat4)->Mat4, &matrix[0][0], sizeof(float) * 16);
+}
+
+void CommandList::Reset()
+{
+    m_Commands.clear();
+    m_Arena.Reset();
+    m_LastUniform = nullptr;
+}
+
+void CommandList::ApplyUniforms(const DrawCommand& command)
+{
+    for (const UniformCommand* uniform = command.Uniforms; uniform; uniform = uniform->Next) {
+        switch (uniform->Type)
+        {
+            case UniformType::Int:
+                command.Program->SetUniform1i(uniform->ID, uniform->Int);
+                break;
+            case UniformType::Float4:
+                command.Program->SetUniform4f(uniform->ID, uniform->Float4[0], uniform->Float4[1], uniform->Float4[2], uniform->Float4[3]);
+                break;
+            case UniformType::Mat4:
+            {
+                glm::mat4 matrix;
+                memcpy(&matrix[0][0], uniform->Mat4, sizeof(float) * 16);
+                command.Program->SetUniformMat4f(uniform->ID, matrix);
+                break;
+            }
+        }
+    }
+}
\ No newline at end of file
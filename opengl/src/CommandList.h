@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "RenderQueue.h"
+#include "LinearArena.h"
+#include "Shader.h"
+
+#include "glm/glm.hpp"
+
+enum class UniformType {
+    Int,
+    Float4,
+    Mat4
+};
+
+//Uniform value recorded for one draw, lives in the CommandList arena
+struct UniformCommand {
+    UniformID ID; //hashed at record time, no string kept around
+    UniformType Type;
+    UniformCommand* Next;
+    union {
+        int Int;
+        float Float4[4];
+        float Mat4[16];
+    };
+};
+
+//Draw descriptor without any GL state, can be recorded on any thread
+struct DrawCommand {
+    uint64_t Key;
+    const VertexArray* VAO;
+    const IndexBuffer* IBO;
+    Shader* Program;
+    const Texture* Tex;
+    UniformCommand* Uniforms;
+};
+
+//Recording target for one worker thread. Commands go to a plain array, their uniform data to
+//the list's own linear arena, so recording takes no locks and no heap allocations once warm.
+class CommandList {
+private:
+    std::vector<DrawCommand> m_Commands;
+    LinearArena m_Arena;
+    UniformCommand* m_LastUniform = nullptr;
+
+public:
+    //Starts a command, following SetUniform* calls attach to it
+    void Draw(RenderPass pass, const VertexArray& vao, const IndexBuffer& ibo, Shader& shader,
+        const Texture* texture, float depth);
+
+    void SetUniform1i(const char* name, int value);
+    void SetUniform4f(const char* name, float v0, float v1, float v2, float v3);
+    void SetUniformMat4f(const char* name, const glm::mat4& matrix);
+
+    void Reset();
+
+    inline const std::vector<DrawCommand>& GetCommands() const { return m_Commands; }
+
+    //Uploads the recorded uniforms of one command, program must be bound
+    static void ApplyUniforms(const DrawCommand& command);
+
+private:
+    UniformCommand* AddUniform(const char* name, UniformType type);
+};
\ No newline at end of file
@@ -0,0 +1,38 @@
+#include "FileList.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+std::vector<std::string> ListFiles(const std::string& directory, const std::string& extension)
+{
+	std::vector<std::string> files;
+#ifdef _WIN32
+	WIN32_FIND_DATAA data;
+	HANDLE find = FindFirstFileA((directory + "/*" + extension).c_str(), &data);
+	if (find != INVALID_HANDLE_VALUE) {
+		do {
+			if (!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+				files.push_back(directory + "/" + data.cFileName);
+		} while (FindNextFileA(find, &data));
+		FindClose(find);
+	}
+#else
+	if (DIR* dir = opendir(directory.c_str())) {
+		while (dirent* entry = readdir(dir)) {
+			std::string name = entry->d_name;
+			if (name.size() > extension.size() && name.compare(name.size() - extension.size(), extension.size(), extension) == 0)
+				files.push_back(directory + "/" + name);
+		}
+		closedir(dir);
+	}
+#endif
+	std::sort(files.begin(), files.end());
+	return files;
+}
\ No newline at end of file
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+//Files directly inside directory whose name ends in extension, sorted, as "directory/name"
+std::vector<std::string> ListFiles(const std::string& directory, const std::string& extension);
\ No newline at end of file
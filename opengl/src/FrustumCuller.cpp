@@ -0,0 +1,222 @@
+#include "FrustumCuller.h"
+#include "JobSystem.h"
+#include "Simd.h"
+
+#include <algorithm>
+#include <cmath>
+
+Frustum Frustum::FromMatrix(const glm::mat4& viewProj)
+{
+    //Gribb/Hartmann: planes are sums/differences of the matrix rows
+    glm::vec4 row0(viewProj[0][0], viewProj[1][0], viewProj[2][0], viewProj[3][0]);
+    glm::vec4 row1(viewProj[0][1], viewProj[1][1], viewProj[2][1], viewProj[3][1]);
+    glm::vec4 row2(viewProj[0][2], viewProj[1][2], viewProj[2][2], viewProj[3][2]);
+    glm::vec4 row3(viewProj[0][3], viewProj[1][3], viewProj[2][3], viewProj[3][3]);
+
+    Frustum frustum;
+    frustum.Planes[0] = row3 + row0;
+    frustum.Planes[1] = row3 - row0;
+    frustum.Planes[2] = row3 + row1;
+    frustum.Planes[3] = row3 - row1;
+    frustum.Planes[4] = row3 + row2;
+    frustum.Planes[5] = row3 - row2;
+
+    for (glm::vec4& plane : frustum.Planes)
+        plane /= glm::length(glm::vec3(plane));
+
+    return frustum;
+}
+
+unsigned int FrustumCuller::AddAABB(const glm::vec3& min, const glm::vec3& max)
+{
+    return Add((min + max) * 0.5f, (max - min) * 0.5f, 0.0f);
+}
+
+unsigned int FrustumCuller::AddSphere(const glm::vec3& center, float radius)
+{
+    return Add(center, glm::vec3(0.0f), radius);
+}
+
+unsigned int FrustumCuller::Add(const glm::vec3& center, const glm::vec3& extents, float radius)
+{
+    //Arrays stay padded to a multiple of 8 so the SIMD loops never read past the end
+    unsigned int index = m_Count++;
+    size_t padded = (m_Count + 7) & ~7u;
+    for (std::vector<float>* array : { &m_CenterX, &m_CenterY, &m_CenterZ, &m_ExtentX, &m_ExtentY, &m_ExtentZ, &m_Radius })
+        array->resize(padded, 0.0f);
+
+    m_CenterX[index] = center.x;
+    m_CenterY[index] = center.y;
+    m_CenterZ[index] = center.z;
+    m_ExtentX[index] = extents.x;
+    m_ExtentY[index] = extents.y;
+    m_ExtentZ[index] = extents.z;
+    m_Radius[index] = radius;
+    return index;
+}
+
+void FrustumCuller::Clear()
+{
+    for (std::vector<float>* array : { &m_CenterX, &m_CenterY, &m_CenterZ, &m_ExtentX, &m_ExtentY, &m_ExtentZ, &m_Radius })
+        array->clear();
+    m_Count = 0;
+}
+
+CullPath FrustumCuller::GetBestPath()
+{
+#if defined(SIMD_AVX2)
+    return CullPath::AVX2;
+#elif defined(SIMD_SSE2)
+    return CullPath::SSE;
+#else
+    return CullPath::Scalar;
+#endif
+}
+
+void FrustumCuller::Cull(const Frustum& frustum, std::vector<unsigned int>& visible, CullPath path) const
+{
+    visible.resize(m_Count);
+    visible.resize(CullRange(frustum, 0, m_Count, visible.data(), path));
+}
+
+void FrustumCuller::CullParallel(const Frustum& frustum, std::vector<unsigned int>& visible, JobSystem& jobs, CullPath path) const
+{
+    const unsigned int chunkSize = 16384;
+    unsigned int chunks = (m_Count + chunkSize - 1) / chunkSize;
+    std::vector<unsigned int> counts(chunks);
+
+    //Every chunk writes its survivors at its own start, then they are packed in chunk order
+    visible.resize(m_Count);
+    jobs.ParallelFor(m_Count, chunkSize, [&](unsigned int begin, unsigned int end) {
+        counts[begin / chunkSize] = CullRange(frustum, begin, end, visible.data() + begin, path);
+    });
+
+    unsigned int total = 0;
+    for (unsigned int chunk = 0; chunk < chunks; chunk++) {
+        const unsigned int* src = visible.data() + chunk * chunkSize;
+        std::copy(src, src + counts[chunk], visible.data() + total);
+        total += counts[chunk];
+    }
+    visible.resize(total);
+}
+
+unsigned int FrustumCuller::CullRange(const Frustum& frustum, unsigned int begin, unsigned int end, unsigned int* out, CullPath path) const
+{
+    switch (path)
+    {
+        case CullPath::AVX2: return CullAVX2(frustum, begin, end, out);
+        case CullPath::SSE: return CullSSE(frustum, begin, end, out);
+        default:
+            return CullScalar(frustum, begin, end, out);
+    }
+}
+
+unsigned int FrustumCuller::CullScalar(const Frustum& frustum, unsigned int begin, unsigned int end, unsigned int* out) const
+{
+    unsigned int count = 0;
+    for (unsigned int i = begin; i < end; i++) {
+        bool inside = true;
+        for (const glm::vec4& plane : frustum.Planes) {
+            float distance = plane.x * m_CenterX[i] + plane.y * m_CenterY[i] + plane.z * m_CenterZ[i] + plane.w;
+            float radius = m_Radius[i] + std::fabs(plane.x) * m_ExtentX[i] + std::fabs(plane.y) * m_ExtentY[i] + std::fabs(plane.z) * m_ExtentZ[i];
+            if (distance < -radius) {
+                inside = false;
+                break;
+            }
+        }
+        out[count] = i;
+        count += inside;
+    }
+    return count;
+}
+
+unsigned int FrustumCuller::CullSSE(const Frustum& frustum, unsigned int begin, unsigned int end, unsigned int* out) const
+{
+#if defined(SIMD_SSE2)
+    __m128 nx[6], ny[6], nz[6], nw[6], ax[6], ay[6], az[6];
+    for (int p = 0; p < 6; p++) {
+        const glm::vec4& plane = frustum.Planes[p];
+        nx[p] = _mm_set1_ps(plane.x);
+        ny[p] = _mm_set1_ps(plane.y);
+        nz[p] = _mm_set1_ps(plane.z);
+        nw[p] = _mm_set1_ps(plane.w);
+        ax[p] = _mm_set1_ps(std::fabs(plane.x));
+        ay[p] = _mm_set1_ps(std::fabs(plane.y));
+        az[p] = _mm_set1_ps(std::fabs(plane.z));
+    }
+
+    unsigned int count = 0;
+    for (unsigned int i = begin; i < end; i += 4) {
+        __m128 cx = _mm_loadu_ps(&m_CenterX[i]);
+        __m128 cy = _mm_loadu_ps(&m_CenterY[i]);
+        __m128 cz = _mm_loadu_ps(&m_CenterZ[i]);
+        __m128 ex = _mm_loadu_ps(&m_ExtentX[i]);
+        __m128 ey = _mm_loadu_ps(&m_ExtentY[i]);
+        __m128 ez = _mm_loadu_ps(&m_ExtentZ[i]);
+        __m128 r = _mm_loadu_ps(&m_Radius[i]);
+
+        __m128 outside = _mm_setzero_ps();
+        for (int p = 0; p < 6; p++) {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx[p], cx), _mm_mul_ps(ny[p], cy)), _mm_add_ps(_mm_mul_ps(nz[p], cz), nw[p]));
+            __m128 radius = _mm_add_ps(_mm_add_ps(r, _mm_mul_ps(ax[p], ex)), _mm_add_ps(_mm_mul_ps(ay[p], ey), _mm_mul_ps(az[p], ez)));
+            //distance < -radius  <=>  distance + radius < 0
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+        }
+
+        unsigned int mask = ~_mm_movemask_ps(outside) & 0xf;
+        unsigned int lanes = std::min(4u, end - i);
+        for (unsigned int lane = 0; lane < lanes; lane++) {
+            out[count] = i + lane;
+            count += (mask >> lane) & 1;
+        }
+    }
+    return count;
+#else
+    return CullScalar(frustum, begin, end, out);
+#endif
+}
+
+unsigned int FrustumCuller::CullAVX2(const Frustum& frustum, unsigned int begin, unsigned int end, unsigned int* out) const
+{
+#if defined(SIMD_AVX2)
+    __m256 nx[6], ny[6], nz[6], nw[6], ax[6], ay[6], az[6];
+    for (int p = 0; p < 6; p++) {
+        const glm::vec4& plane = frustum.Planes[p];
+        nx[p] = _mm256_set1_ps(plane.x);
+        ny[p] = _mm256_set1_ps(plane.y);
+        nz[p] = _mm256_set1_ps(plane.z);
+        nw[p] = _mm256_set1_ps(plane.w);
+        ax[p] = _mm256_set1_ps(std::fabs(plane.x));
+        ay[p] = _mm256_set1_ps(std::fabs(plane.y));
+        az[p] = _mm256_set1_ps(std::fabs(plane.z));
+    }
+
+    unsigned int count = 0;
+    for (unsigned int i = begin; i < end; i += 8) {
+        __m256 cx = _mm256_loadu_ps(&m_CenterX[i]);
+        __m256 cy = _mm256_loadu_ps(&m_CenterY[i]);
+        __m256 cz = _mm256_loadu_ps(&m_CenterZ[i]);
+        __m256 ex = _mm256_loadu_ps(&m_ExtentX[i]);
+        __m256 ey = _mm256_loadu_ps(&m_ExtentY[i]);
+        __m256 ez = _mm256_loadu_ps(&m_ExtentZ[i]);
+        __m256 r = _mm256_loadu_ps(&m_Radius[i]);
+
+        __m256 outside = _mm256_setzero_ps();
+        for (int p = 0; p < 6; p++) {
+            __m256 distance = _mm256_fmadd_ps(nx[p], cx, _mm256_fmadd_ps(ny[p], cy, _mm256_fmadd_ps(nz[p], cz, nw[p])));
+            __m256 radius = _mm256_fmadd_ps(ax[p], ex, _mm256_fmadd_ps(ay[p], ey, _mm256_fmadd_ps(az[p], ez, r)));
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), _mm256_setzero_ps(), _CMP_LT_OQ));
+        }
+
+        unsigned int mask = ~_mm256_movemask_ps(outside) & 0xff;
+        unsigned int lanes = std::min(8u, end - i);
+        for (unsigned int lane = 0; lane < lanes; lane++) {
+            out[count] = i + lane;
+            count += (mask >> lane) & 1;
+        }
+    }
+    return count;
+#else
+    return CullSSE(frustum, begin, end, out);
+#endif
+}
\ No newline at end of file
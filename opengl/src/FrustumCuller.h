@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+
+#include "glm/glm.hpp"
+
+class JobSystem;
+
+struct Frustum {
+    //xyz = inward normal, w = distance; left, right, bottom, top, near, far
+    glm::vec4 Planes[6];
+
+    static Frustum FromMatrix(const glm::mat4& viewProj);
+};
+
+enum class CullPath {
+    Scalar,
+    SSE,  //4 objects per iteration
+    AVX2  //8 objects per iteration
+};
+
+//Bounding volumes in structure-of-arrays form, tested against the frustum several objects at a time.
+//Every object has a center, half extents and a radius, so AABBs (radius 0) and spheres
+//(extents 0) share one test: outside if dot(n, c) + w < -(radius + dot(|n|, extents)).
+class FrustumCuller {
+private:
+    std::vector<float> m_CenterX, m_CenterY, m_CenterZ;
+    std::vector<float> m_ExtentX, m_ExtentY, m_ExtentZ;
+    std::vector<float> m_Radius;
+    unsigned int m_Count = 0;
+
+public:
+    unsigned int AddAABB(const glm::vec3& min, const glm::vec3& max);
+    unsigned int AddSphere(const glm::vec3& center, float radius);
+    void Clear();
+
+    inline unsigned int GetCount() const { return m_Count; }
+
+    //Replaces visible with the indices of objects inside or touching the frustum, in ascending order
+    void Cull(const Frustum& frustum, std::vector<unsigned int>& visible, CullPath path = GetBestPath()) const;
+    //Same result, chunks spread over the job system
+    void CullParallel(const Frustum& frustum, std::vector<unsigned int>& visible, JobSystem& jobs, CullPath path = GetBestPath()) const;
+
+    static CullPath GetBestPath();
+
+private:
+    unsigned int Add(const glm::vec3& center, const glm::vec3& extents, float radius);
+    //Writes visible indices of [begin, end) to out, returns how many
+    unsigned int CullRange(const Frustum& frustum, unsigned int begin, unsigned int end, unsigned int* out, CullPath path) const;
+    unsigned int CullScalar(const Frustum& frustum, unsigned int begin, unsigned int end, unsigned int* out) const;
+    unsigned int CullSSE(const Frustum& frustum, unsigned int begin, unsigned int end, unsigned int* out) const;
+    unsigned int CullAVX2(const Frustum& frustum, unsigned int begin, unsigned int end, unsigned int* out) const;
+};
\ No newline at end of file
@@ -0,0 +1,183 @@
+#include "GLState.h"
+#include "Debug.h"
+
+namespace {
+    const unsigned int Unknown = 0xffffffff;
+}
+
+GLState::GLState()
+{
+    Invalidate();
+}
+
+GLState& GLState::Get()
+{
+    static GLState s_State;
+    return s_State;
+}
+
+void GLState::Invalidate()
+{
+    m_Program = Unknown;
+    m_VAO = Unknown;
+    m_ElementBuffer = Unknown;
+    m_VAOElementBuffers.clear();
+    m_ActiveTexture = Unknown;
+    for (auto& target : m_Textures)
+        for (unsigned int& texture : target)
+            texture = Unknown;
+    m_Blend = -1;
+    m_BlendSrc = Unknown;
+    m_BlendDst = Unknown;
+}
+
+int GLState::GetTargetIndex(unsigned int target)
+{
+    switch (target)
+    {
+        case GL_TEXTURE_2D: return Texture2D;
+        case GL_TEXTURE_2D_ARRAY: return Texture2DArray;
+        case GL_TEXTURE_CUBE_MAP: return TextureCubeMap;
+        case GL_TEXTURE_BUFFER: return TextureBufferTarget;
+        default:
+            return -1;
+    }
+}
+
+void GLState::UseProgram(unsigned int program)
+{
+    if (m_Program == program) {
+        Skip(m_Stats.ProgramSkipped);
+        return;
+    }
+    GLCall(glUseProgram(program));
+    m_Program = program;
+    m_Stats.Issued++;
+}
+
+void GLState::BindVertexArray(unsigned int vao)
+{
+    if (m_VAO == vao) {
+        Skip(m_Stats.VAOSkipped);
+        return;
+    }
+    GLCall(glBindVertexArray(vao));
+    m_VAO = vao;
+    m_Stats.Issued++;
+
+    auto it = m_VAOElementBuffers.find(vao);
+    m_ElementBuffer = it != m_VAOElementBuffers.end() ? it->second : Unknown;
+}
+
+void GLState::BindElementBuffer(unsigned int buffer)
+{
+    if (m_ElementBuffer == buffer) {
+        Skip(m_Stats.ElementBufferSkipped);
+        return;
+    }
+    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer));
+    m_ElementBuffer = buffer;
+    m_Stats.Issued++;
+
+    if (m_VAO != Unknown)
+        m_VAOElementBuffers[m_VAO] = buffer;
+}
+
+void GLState::ActiveTexture(unsigned int unit)
+{
+    if (m_ActiveTexture == unit) {
+        Skip(m_Stats.ActiveTextureSkipped);
+        return;
+    }
+    GLCall(glActiveTexture(GL_TEXTURE0 + unit));
+    m_ActiveTexture = unit;
+    m_Stats.Issued++;
+}
+
+void GLState::BindTexture(unsigned int target, unsigned int texture)
+{
+    int index = GetTargetIndex(target);
+    if (index < 0 || m_ActiveTexture >= MaxTextureUnits) {
+        GLCall(glBindTexture(target, texture));
+        m_Stats.Issued++;
+        return;
+    }
+
+    unsigned int& bound = m_Textures[index][m_ActiveTexture];
+    if (bound == texture) {
+        Skip(m_Stats.TextureSkipped);
+        return;
+    }
+    GLCall(glBindTexture(target, texture));
+    bound = texture;
+    m_Stats.Issued++;
+}
+
+void GLState::BindTextureUnit(unsigned int unit, unsigned int target, unsigned int texture)
+{
+    int index = GetTargetIndex(target);
+    if (index >= 0 && unit < MaxTextureUnits && m_Textures[index][unit] == texture) {
+        Skip(m_Stats.TextureSkipped);
+        return;
+    }
+    ActiveTexture(unit);
+    BindTexture(target, texture);
+}
+
+void GLState::SetBlend(bool enabled)
+{
+    if (m_Blend == (int)enabled) {
+        Skip(m_Stats.BlendSkipped);
+        return;
+    }
+    GLCall(enabled ? glEnable(GL_BLEND) : glDisable(GL_BLEND));
+    m_Blend = enabled;
+    m_Stats.Issued++;
+}
+
+void GLState::SetBlendFunc(unsigned int src, unsigned int dst)
+{
+    if (m_BlendSrc == src && m_BlendDst == dst) {
+        Skip(m_Stats.BlendSkipped);
+        return;
+    }
+    GLCall(glBlendFunc(src, dst));
+    m_BlendSrc = src;
+    m_BlendDst = dst;
+    m_Stats.Issued++;
+}
+
+void GLState::OnDeleteProgram(unsigned int program)
+{
+    if (m_Program == program)
+        m_Program = Unknown;
+}
+
+void GLState::OnDeleteVertexArray(unsigned int vao)
+{
+    if (m_VAO == vao) {
+        m_VAO = Unknown;
+        m_ElementBuffer = Unknown;
+    }
+    m_VAOElementBuffers.erase(vao);
+}
+
+void GLState::OnDeleteBuffer(unsigned int buffer)
+{
+    if (m_ElementBuffer == buffer)
+        m_ElementBuffer = Unknown;
+    for (auto& entry : m_VAOElementBuffers) {
+        if (entry.second == buffer)
+            entry.second = Unknown;
+    }
+}
+
+void GLState::OnDeleteTexture(unsigned int texture)
+{
+    for (auto& target : m_Textures) {
+        for (unsigned int& bound : target) {
+            if (bound == texture)
+                bound = Unknown;
+        }
+    }
+}
\ No newline at end of file
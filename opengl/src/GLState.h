@@ -0,0 +1,69 @@
+#pragma once
+
+#include <unordered_map>
+
+struct GLStateStats {
+    //Calls forwarded to GL / calls dropped because the state already matched
+    unsigned int Issued = 0;
+    unsigned int Skipped = 0;
+
+    unsigned int ProgramSkipped = 0;
+    unsigned int VAOSkipped = 0;
+    unsigned int ElementBufferSkipped = 0;
+    unsigned int ActiveTextureSkipped = 0;
+    unsigned int TextureSkipped = 0;
+    unsigned int BlendSkipped = 0;
+};
+
+//Shadow copy of the bindings of the GL context. Everything that binds goes through here,
+//so binds that would not change anything never reach the driver.
+class GLState {
+public:
+    static const unsigned int MaxTextureUnits = 32;
+
+private:
+    enum TextureTarget { Texture2D = 0, Texture2DArray, TextureCubeMap, TextureBufferTarget, TextureTargetCount };
+
+    unsigned int m_Program;
+    unsigned int m_VAO;
+    unsigned int m_ElementBuffer;
+    //Element buffer binding is part of the VAO state
+    std::unordered_map<unsigned int, unsigned int> m_VAOElementBuffers;
+    unsigned int m_ActiveTexture;
+    unsigned int m_Textures[TextureTargetCount][MaxTextureUnits];
+    int m_Blend;
+    unsigned int m_BlendSrc, m_BlendDst;
+
+    GLStateStats m_Stats;
+
+public:
+    static GLState& Get();
+
+    void UseProgram(unsigned int program);
+    void BindVertexArray(unsigned int vao);
+    void BindElementBuffer(unsigned int buffer);
+    void ActiveTexture(unsigned int unit);
+    //Binds to the active unit
+    void BindTexture(unsigned int target, unsigned int texture);
+    void BindTextureUnit(unsigned int unit, unsigned int target, unsigned int texture);
+    void SetBlend(bool enabled);
+    void SetBlendFunc(unsigned int src, unsigned int dst);
+
+    //GL reuses names of deleted objects, so forget them before deleting
+    void OnDeleteProgram(unsigned int program);
+    void OnDeleteVertexArray(unsigned int vao);
+    void OnDeleteBuffer(unsigned int buffer);
+    void OnDeleteTexture(unsigned int texture);
+
+    //State was changed behind our back (e.g. by a third party library)
+    void Invalidate();
+
+    inline const GLStateStats& GetStats() const { return m_Stats; }
+    inline void ResetStats() { m_Stats = GLStateStats(); }
+
+private:
+    GLState();
+
+    static int GetTargetIndex(unsigned int target);
+    inline void Skip(unsigned int& counter) { counter++; m_Stats.Skipped++; }
+};
\ No newline at end of file
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+//64-bit FNV-1a. Chain calls by passing the previous result as seed.
+const uint64_t Fnv1a64Seed = 14695981039346656037ull;
+
+inline uint64_t Fnv1a64(const void* data, size_t size, uint64_t hash = Fnv1a64Seed)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	for (size_t i = 0; i < size; i++)
+		hash = (hash ^ bytes[i]) * 1099511628211ull;
+	return hash;
+}
+
+inline uint64_t Fnv1a64(const std::string& text, uint64_t hash = Fnv1a64Seed)
+{
+	//Length first, so "ab" + "c" and "a" + "bc" differ
+	uint64_t length = text.size();
+	return Fnv1a64(text.data(), text.size(), Fnv1a64(&length, sizeof(length), hash));
+}
\ No newline at end of file
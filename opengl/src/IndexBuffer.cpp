@@ -1,26 +1,28 @@
 #include "Debug.h"
 #include "IndexBuffer.h"
+#include "GLState.h"
 
 
 IndexBuffer::IndexBuffer(const void* data, unsigned int count)
 {
     m_Count = count;
     GLCall(glGenBuffers(1, &m_RendererID));
-    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID));
+    GLState::Get().BindElementBuffer(m_RendererID);
     GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(unsigned int), data, GL_STATIC_DRAW));
 }
 
 IndexBuffer::~IndexBuffer()
 {
+    GLState::Get().OnDeleteBuffer(m_RendererID);
     GLCall(glDeleteBuffers(1,&m_RendererID))
 }
 
 void IndexBuffer::Bind() const
 {
-    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID));
+    GLState::Get().BindElementBuffer(m_RendererID);
 }
 
 void IndexBuffer::UnBind() const
 {
-    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
+    GLState::Get().BindElementBuffer(0);
 }
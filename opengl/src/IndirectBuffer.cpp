@@ -0,0 +1,26 @@
+#include "Debug.h"
+#include "IndirectBuffer.h"
+
+
+IndirectBuffer::IndirectBuffer(const DrawElementsIndirectCommand* commands, unsigned int count)
+{
+    m_Count = count;
+    GLCall(glGenBuffers(1, &m_RendererID));
+    GLCall(glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_RendererID));
+    GLCall(glBufferData(GL_DRAW_INDIRECT_BUFFER, count * sizeof(DrawElementsIndirectCommand), commands, GL_STATIC_DRAW));
+}
+
+IndirectBuffer::~IndirectBuffer()
+{
+    GLCall(glDeleteBuffers(1, &m_RendererID));
+}
+
+void IndirectBuffer::Bind() const
+{
+    GLCall(glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_RendererID));
+}
+
+void IndirectBuffer::UnBind() const
+{
+    GLCall(glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0));
+}
\ No newline at end of file
@@ -0,0 +1,25 @@
+#pragma once
+
+//Layout fixed by GL for GL_DRAW_INDIRECT_BUFFER
+struct DrawElementsIndirectCommand {
+	unsigned int Count;
+	unsigned int InstanceCount;
+	unsigned int FirstIndex;
+	int BaseVertex;
+	unsigned int BaseInstance;
+};
+
+class IndirectBuffer {
+private:
+	unsigned int m_RendererID;
+	unsigned int m_Count;
+
+public:
+	IndirectBuffer(const DrawElementsIndirectCommand* commands, unsigned int count);
+	~IndirectBuffer();
+
+	void Bind() const;
+	void UnBind() const;
+
+	inline unsigned int GetCount() const { return m_Count; }
+};
\ No newline at end of file
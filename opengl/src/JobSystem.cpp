@@ -0,0 +1,137 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <atomic>
+
+JobSystem::JobSystem(unsigned int workerCount /*= DefaultWorkerCount()*/)
+	:m_Active(0), m_Running(true)
+{
+	for (unsigned int i = 0; i < workerCount; i++)
+		m_Workers.emplace_back(&JobSystem::WorkerLoop, this);
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Running = false;
+	}
+	m_JobCV.notify_all();
+	for (std::thread& worker : m_Workers)
+		worker.join();
+}
+
+unsigned int JobSystem::DefaultWorkerCount()
+{
+	unsigned int hardware = std::thread::hardware_concurrency();
+	return hardware > 1 ? hardware - 1 : 1;
+}
+
+JobSystem& JobSystem::Get()
+{
+	static JobSystem s_JobSystem;
+	return s_JobSystem;
+}
+
+void JobSystem::Submit(std::function<void()> job)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Jobs.push_back(std::move(job));
+	}
+	m_JobCV.notify_one();
+	//ParallelFor callers sleep on m_DoneCV and run new jobs while their helpers are queued
+	m_DoneCV.notify_all();
+}
+
+void JobSystem::Wait()
+{
+	while (RunPendingJob()) {}
+
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_DoneCV.wait(lock, [this] { return m_Jobs.empty() && m_Active == 0; });
+}
+
+bool JobSystem::RunPendingJob()
+{
+	std::function<void()> job;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		if (m_Jobs.empty())
+			return false;
+		job = std::move(m_Jobs.front());
+		m_Jobs.pop_front();
+		m_Active++;
+	}
+
+	job();
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Active--;
+	}
+	m_DoneCV.notify_all();
+	return true;
+}
+
+void JobSystem::WorkerLoop()
+{
+	while (true) {
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_JobCV.wait(lock, [this] { return !m_Jobs.empty() || !m_Running; });
+			if (m_Jobs.empty())
+				return;
+			job = std::move(m_Jobs.front());
+			m_Jobs.pop_front();
+			m_Active++;
+		}
+
+		job();
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Active--;
+		}
+		m_DoneCV.notify_all();
+	}
+}
+
+void JobSystem::ParallelFor(unsigned int count, unsigned int chunkSize, const std::function<void(unsigned int begin, unsigned int end)>& func)
+{
+	if (count == 0)
+		return;
+	chunkSize = std::max(chunkSize, 1u);
+
+	unsigned int chunks = (count + chunkSize - 1) / chunkSize;
+	std::atomic<unsigned int> next{ 0 };
+	std::atomic<unsigned int> helpers{ std::min(GetWorkerCount(), chunks - 1) };
+
+	auto work = [&]() {
+		unsigned int chunk;
+		while ((chunk = next++) < chunks)
+			func(chunk * chunkSize, std::min(count, (chunk + 1) * chunkSize));
+	};
+
+	unsigned int helperCount = helpers;
+	for (unsigned int i = 0; i < helperCount; i++) {
+		Submit([&]() {
+			work();
+			//Last touch of this stack frame, the caller may return right after
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			helpers--;
+			m_DoneCV.notify_all();
+		});
+	}
+
+	work();
+
+	//Help with queued jobs instead of blocking, our helpers may be stuck behind them
+	while (helpers > 0) {
+		if (RunPendingJob())
+			continue;
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_DoneCV.wait(lock, [&] { return helpers == 0 || !m_Jobs.empty(); });
+	}
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//Fixed pool of worker threads fed from one queue
+class JobSystem {
+private:
+	std::vector<std::thread> m_Workers;
+	std::deque<std::function<void()>> m_Jobs;
+	std::mutex m_Mutex;
+	std::condition_variable m_JobCV;
+	std::condition_variable m_DoneCV;
+	unsigned int m_Active;
+	bool m_Running;
+
+public:
+	explicit JobSystem(unsigned int workerCount = DefaultWorkerCount());
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	//Shared pool for engine systems
+	static JobSystem& Get();
+
+	void Submit(std::function<void()> job);
+	//Blocks until the queue is empty and no job is running
+	void Wait();
+
+	//Splits [0, count) into chunks and runs func(begin, end) on the workers and the calling thread.
+	//Returns when every chunk is done. Safe to call from inside a job.
+	void ParallelFor(unsigned int count, unsigned int chunkSize, const std::function<void(unsigned int begin, unsigned int end)>& func);
+
+	inline unsigned int GetWorkerCount() const { return (unsigned int)m_Workers.size(); }
+	//One worker per hardware thread, minus the calling thread
+	static unsigned int DefaultWorkerCount();
+
+private:
+	void WorkerLoop();
+	//Runs one queued job on the calling thread, false if the queue was empty
+	bool RunPendingJob();
+};
\ No newline at end of file
@@ -0,0 +1,36 @@
+#include "LinearArena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+LinearArena::LinearArena(size_t blockSize /*= 64 * 1024*/)
+	:m_BlockSize(blockSize), m_BlockIndex(0), m_Offset(0)
+{
+}
+
+void* LinearArena::Allocate(size_t size, size_t alignment /*= 16*/)
+{
+	while (m_BlockIndex < m_Blocks.size()) {
+		Block& block = m_Blocks[m_BlockIndex];
+		uintptr_t base = (uintptr_t)block.Data.get();
+		uintptr_t aligned = (base + m_Offset + alignment - 1) & ~(uintptr_t)(alignment - 1);
+		if (aligned + size <= base + block.Size) {
+			m_Offset = aligned + size - base;
+			return (void*)aligned;
+		}
+		m_BlockIndex++;
+		m_Offset = 0;
+	}
+
+	size_t blockSize = std::max(m_BlockSize, size + alignment);
+	m_Blocks.push_back({ std::unique_ptr<unsigned char[]>(new unsigned char[blockSize]), blockSize });
+	m_BlockIndex = m_Blocks.size() - 1;
+	m_Offset = 0;
+	return Allocate(size, alignment);
+}
+
+void LinearArena::Reset()
+{
+	m_BlockIndex = 0;
+	m_Offset = 0;
+}
\ No newline at end of file
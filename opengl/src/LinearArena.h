@@ -0,0 +1,31 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+//Bump allocator for per-frame data. Reset keeps the blocks, so a warmed up arena never touches the heap.
+//Not thread safe, give every thread its own.
+class LinearArena {
+private:
+	struct Block {
+		std::unique_ptr<unsigned char[]> Data;
+		size_t Size;
+	};
+
+	std::vector<Block> m_Blocks;
+	size_t m_BlockSize;
+	size_t m_BlockIndex;
+	size_t m_Offset;
+
+public:
+	explicit LinearArena(size_t blockSize = 64 * 1024);
+
+	void* Allocate(size_t size, size_t alignment = 16);
+	void Reset();
+
+	template<typename T>
+	T* New(const T& value) {
+		void* memory = Allocate(sizeof(T), alignof(T));
+		return new (memory) T(value);
+	}
+};
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+//Read-only memory mapping of a whole file
+class MappedFile {
+private:
+	const unsigned char* m_Data;
+	size_t m_Size;
+#ifdef _WIN32
+	void* m_File;
+	void* m_Mapping;
+#else
+	int m_File;
+#endif
+
+public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	//false if the file doesn't exist, is empty or can't be mapped
+	bool Open(const std::string& path);
+	void Close();
+
+	inline bool IsOpen() const { return m_Data != nullptr; }
+	inline const unsigned char* GetData() const { return m_Data; }
+	inline size_t GetSize() const { return m_Size; }
+};
\ No newline at end of file
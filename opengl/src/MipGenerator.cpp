@@ -0,0 +1,320 @@
+#include "MipGenerator.h"
+#include "JobSystem.h"
+#include "Simd.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+	struct SRGBTables {
+		float ToLinear[256];
+		//Indexed by linear * 4095, fine enough that every 8 bit code is reachable
+		unsigned char FromLinear[4096];
+
+		SRGBTables()
+		{
+			for (int i = 0; i < 256; i++) {
+				double c = i / 255.0;
+				ToLinear[i] = (float)(c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4));
+			}
+			for (int i = 0; i < 4096; i++) {
+				double l = i / 4095.0;
+				double c = l <= 0.0031308 ? l * 12.92 : 1.055 * std::pow(l, 1.0 / 2.4) - 0.055;
+				FromLinear[i] = (unsigned char)(c * 255.0 + 0.5);
+			}
+		}
+	};
+
+	const SRGBTables& GetSRGBTables()
+	{
+		static const SRGBTables s_Tables;
+		return s_Tables;
+	}
+
+	double BesselI0(double x)
+	{
+		double sum = 1.0, term = 1.0;
+		for (int k = 1; k < 32; k++) {
+			term *= (x / (2.0 * k)) * (x / (2.0 * k));
+			sum += term;
+		}
+		return sum;
+	}
+
+	inline int ClampIndex(int index, int size)
+	{
+		return index < 0 ? 0 : (index >= size ? size - 1 : index);
+	}
+
+	inline float Saturate(float value)
+	{
+		return value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+	}
+
+	//Rows per job so every chunk covers roughly the same number of pixels
+	inline unsigned int RowsPerChunk(int width)
+	{
+		return std::max(1u, 16384u / (unsigned int)width);
+	}
+}
+
+MipGenerator::MipGenerator(MipFilter filter /*= MipFilter::Box*/, bool srgb /*= false*/, MipPath path /*= GetBestPath()*/)
+	:m_Filter(filter), m_SRGB(srgb), m_Path(path)
+{
+	//Taps sit at -3.5 .. 3.5 source pixels from the target pixel center, that is -1.75 .. 1.75
+	//target pixels. Windowed over 2 target pixels with alpha 4.
+	const double pi = 3.14159265358979323846;
+	const double alpha = 4.0, radius = 2.0;
+	double sum = 0.0, weights[8];
+	for (int k = 0; k < 8; k++) {
+		double t = (k - 3.5) * 0.5;
+		double sinc = std::sin(pi * t) / (pi * t);
+		double r = t / radius;
+		weights[k] = sinc * BesselI0(alpha * std::sqrt(1.0 - r * r)) / BesselI0(alpha);
+		sum += weights[k];
+	}
+	for (int k = 0; k < 8; k++)
+		m_Kernel[k] = (float)(weights[k] / sum);
+
+#if !defined(SIMD_AVX2)
+	if (m_Path == MipPath::AVX2)
+		m_Path = MipPath::SSE;
+#endif
+#if !defined(SIMD_SSE2)
+	m_Path = MipPath::Scalar;
+#endif
+}
+
+MipPath MipGenerator::GetBestPath()
+{
+#if defined(SIMD_AVX2)
+	return MipPath::AVX2;
+#elif defined(SIMD_SSE2)
+	return MipPath::SSE;
+#else
+	return MipPath::Scalar;
+#endif
+}
+
+unsigned int MipGenerator::GetLevelCount(int width, int height)
+{
+	unsigned int levels = 1;
+	while (width > 1 || height > 1) {
+		width = std::max(1, width / 2);
+		height = std::max(1, height / 2);
+		levels++;
+	}
+	return levels;
+}
+
+std::vector<MipLevel> MipGenerator::Generate(const unsigned char* pixels, int width, int height, JobSystem& jobs) const
+{
+	std::vector<MipLevel> levels;
+	std::vector<float> source((size_t)width * height * 4), target, temporary;
+	jobs.ParallelFor(height, RowsPerChunk(width), [&](unsigned int begin, unsigned int end) {
+		LoadRows(pixels, source.data(), width, begin, end);
+	});
+
+	int sourceWidth = width, sourceHeight = height;
+	while (sourceWidth > 1 || sourceHeight > 1) {
+		MipLevel level;
+		level.Width = std::max(1, sourceWidth / 2);
+		level.Height = std::max(1, sourceHeight / 2);
+		level.Pixels.resize((size_t)level.Width * level.Height * 4);
+		target.resize((size_t)level.Width * level.Height * 4);
+
+		if (m_Filter == MipFilter::Box) {
+			jobs.ParallelFor(level.Height, RowsPerChunk(level.Width), [&](unsigned int begin, unsigned int end) {
+				BoxRows(source.data(), sourceWidth, sourceHeight, target.data(), level.Width, begin, end);
+				StoreRows(target.data(), level.Pixels.data(), level.Width, begin, end);
+			});
+		}
+		else {
+			temporary.resize((size_t)level.Width * sourceHeight * 4);
+			jobs.ParallelFor(sourceHeight, RowsPerChunk(level.Width), [&](unsigned int begin, unsigned int end) {
+				KaiserHorizontal(source.data(), sourceWidth, temporary.data(), level.Width, begin, end);
+			});
+			jobs.ParallelFor(level.Height, RowsPerChunk(level.Width), [&](unsigned int begin, unsigned int end) {
+				KaiserVertical(temporary.data(), sourceHeight, target.data(), level.Width, begin, end);
+				StoreRows(target.data(), level.Pixels.data(), level.Width, begin, end);
+			});
+		}
+
+		sourceWidth = level.Width;
+		sourceHeight = level.Height;
+		source.swap(target);
+		levels.push_back(std::move(level));
+	}
+	return levels;
+}
+
+void MipGenerator::LoadRows(const unsigned char* pixels, float* target, int width, int begin, int end) const
+{
+	const SRGBTables& tables = GetSRGBTables();
+	size_t first = (size_t)begin * width * 4, last = (size_t)end * width * 4;
+	for (size_t i = first; i < last; i += 4) {
+		for (int c = 0; c < 3; c++)
+			target[i + c] = m_SRGB ? tables.ToLinear[pixels[i + c]] : pixels[i + c] * (1.0f / 255.0f);
+		target[i + 3] = pixels[i + 3] * (1.0f / 255.0f);
+	}
+}
+
+void MipGenerator::StoreRows(const float* source, unsigned char* target, int width, int begin, int end) const
+{
+	size_t first = (size_t)begin * width * 4, last = (size_t)end * width * 4;
+	if (m_SRGB) {
+		const SRGBTables& tables = GetSRGBTables();
+		for (size_t i = first; i < last; i += 4) {
+			for (int c = 0; c < 3; c++)
+				target[i + c] = tables.FromLinear[(int)(Saturate(source[i + c]) * 4095.0f + 0.5f)];
+			target[i + 3] = (unsigned char)(Saturate(source[i + 3]) * 255.0f + 0.5f);
+		}
+		return;
+	}
+
+	size_t i = first;
+#if defined(SIMD_SSE2)
+	if (m_Path != MipPath::Scalar) {
+		const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+		const __m128 scale = _mm_set1_ps(255.0f), half = _mm_set1_ps(0.5f);
+		for (; i + 16 <= last; i += 16) {
+			__m128i v[4];
+			for (int p = 0; p < 4; p++) {
+				__m128 value = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(source + i + p * 4), zero), one);
+				v[p] = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(value, scale), half));
+			}
+			__m128i packed = _mm_packus_epi16(_mm_packs_epi32(v[0], v[1]), _mm_packs_epi32(v[2], v[3]));
+			_mm_storeu_si128((__m128i*)(target + i), packed);
+		}
+	}
+#endif
+	for (; i < last; i++)
+		target[i] = (unsigned char)(Saturate(source[i]) * 255.0f + 0.5f);
+}
+
+void MipGenerator::BoxRows(const float* source, int sourceWidth, int sourceHeight, float* target, int targetWidth, int begin, int end) const
+{
+	for (int y = begin; y < end; y++) {
+		const float* row0 = source + (size_t)ClampIndex(2 * y, sourceHeight) * sourceWidth * 4;
+		const float* row1 = source + (size_t)ClampIndex(2 * y + 1, sourceHeight) * sourceWidth * 4;
+		float* out = target + (size_t)y * targetWidth * 4;
+		int x = 0;
+
+#if defined(SIMD_AVX2)
+		if (m_Path == MipPath::AVX2) {
+			//Two target pixels from four source pixels of each row, pairs are added across lanes
+			const __m256 quarter = _mm256_set1_ps(0.25f);
+			for (; x + 1 < targetWidth && 2 * x + 3 < sourceWidth; x += 2) {
+				__m256 a = _mm256_add_ps(_mm256_loadu_ps(row0 + x * 8), _mm256_loadu_ps(row1 + x * 8));
+				__m256 b = _mm256_add_ps(_mm256_loadu_ps(row0 + x * 8 + 8), _mm256_loadu_ps(row1 + x * 8 + 8));
+				__m256 left = _mm256_permute2f128_ps(a, b, 0x20);
+				__m256 right = _mm256_permute2f128_ps(a, b, 0x31);
+				_mm256_storeu_ps(out + x * 4, _mm256_mul_ps(_mm256_add_ps(left, right), quarter));
+			}
+		}
+#endif
+#if defined(SIMD_SSE2)
+		if (m_Path != MipPath::Scalar) {
+			const __m128 quarter = _mm_set1_ps(0.25f);
+			for (; x < targetWidth; x++) {
+				int x0 = ClampIndex(2 * x, sourceWidth) * 4, x1 = ClampIndex(2 * x + 1, sourceWidth) * 4;
+				__m128 sum = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(row0 + x0), _mm_loadu_ps(row0 + x1)),
+					_mm_add_ps(_mm_loadu_ps(row1 + x0), _mm_loadu_ps(row1 + x1)));
+				_mm_storeu_ps(out + x * 4, _mm_mul_ps(sum, quarter));
+			}
+		}
+#endif
+		for (; x < targetWidth; x++) {
+			int x0 = ClampIndex(2 * x, sourceWidth) * 4, x1 = ClampIndex(2 * x + 1, sourceWidth) * 4;
+			for (int c = 0; c < 4; c++)
+				out[x * 4 + c] = (row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c]) * 0.25f;
+		}
+	}
+}
+
+void MipGenerator::KaiserHorizontal(const float* source, int sourceWidth, float* target, int targetWidth, int begin, int end) const
+{
+	for (int y = begin; y < end; y++) {
+		const float* row = source + (size_t)y * sourceWidth * 4;
+		float* out = target + (size_t)y * targetWidth * 4;
+		int x = 0;
+
+#if defined(SIMD_AVX2)
+		if (m_Path == MipPath::AVX2) {
+			//Two target pixels, the second one's taps are two source pixels further right
+			for (; x + 1 < targetWidth; x += 2) {
+				__m256 sum = _mm256_setzero_ps();
+				for (int k = 0; k < 8; k++) {
+					__m128 first = _mm_loadu_ps(row + ClampIndex(2 * x - 3 + k, sourceWidth) * 4);
+					__m128 second = _mm_loadu_ps(row + ClampIndex(2 * x - 1 + k, sourceWidth) * 4);
+					__m256 taps = _mm256_insertf128_ps(_mm256_castps128_ps256(first), second, 1);
+					sum = _mm256_fmadd_ps(taps, _mm256_set1_ps(m_Kernel[k]), sum);
+				}
+				_mm256_storeu_ps(out + x * 4, sum);
+			}
+		}
+#endif
+#if defined(SIMD_SSE2)
+		if (m_Path != MipPath::Scalar) {
+			for (; x < targetWidth; x++) {
+				__m128 sum = _mm_setzero_ps();
+				for (int k = 0; k < 8; k++) {
+					__m128 tap = _mm_loadu_ps(row + ClampIndex(2 * x - 3 + k, sourceWidth) * 4);
+					sum = _mm_add_ps(sum, _mm_mul_ps(tap, _mm_set1_ps(m_Kernel[k])));
+				}
+				_mm_storeu_ps(out + x * 4, sum);
+			}
+		}
+#endif
+		for (; x < targetWidth; x++) {
+			float sum[4] = {};
+			for (int k = 0; k < 8; k++) {
+				const float* tap = row + ClampIndex(2 * x - 3 + k, sourceWidth) * 4;
+				for (int c = 0; c < 4; c++)
+					sum[c] += tap[c] * m_Kernel[k];
+			}
+			for (int c = 0; c < 4; c++)
+				out[x * 4 + c] = sum[c];
+		}
+	}
+}
+
+void MipGenerator::KaiserVertical(const float* source, int sourceHeight, float* target, int width, int begin, int end) const
+{
+	const int floats = width * 4;
+	for (int y = begin; y < end; y++) {
+		const float* rows[8];
+		for (int k = 0; k < 8; k++)
+			rows[k] = source + (size_t)ClampIndex(2 * y - 3 + k, sourceHeight) * floats;
+		float* out = target + (size_t)y * floats;
+		int i = 0;
+
+		//Rows are contiguous, so this runs straight across channels and pixels alike
+#if defined(SIMD_AVX2)
+		if (m_Path == MipPath::AVX2) {
+			for (; i + 8 <= floats; i += 8) {
+				__m256 sum = _mm256_setzero_ps();
+				for (int k = 0; k < 8; k++)
+					sum = _mm256_fmadd_ps(_mm256_loadu_ps(rows[k] + i), _mm256_set1_ps(m_Kernel[k]), sum);
+				_mm256_storeu_ps(out + i, sum);
+			}
+		}
+#endif
+#if defined(SIMD_SSE2)
+		if (m_Path != MipPath::Scalar) {
+			for (; i + 4 <= floats; i += 4) {
+				__m128 sum = _mm_setzero_ps();
+				for (int k = 0; k < 8; k++)
+					sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(rows[k] + i), _mm_set1_ps(m_Kernel[k])));
+				_mm_storeu_ps(out + i, sum);
+			}
+		}
+#endif
+		for (; i < floats; i++) {
+			float sum = 0.0f;
+			for (int k = 0; k < 8; k++)
+				sum += rows[k][i] * m_Kernel[k];
+			out[i] = sum;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vector>
+
+class JobSystem;
+
+enum class MipFilter {
+	Box,   //2x2 average, cheap, slightly blurry and aliases on fine patterns
+	Kaiser //8 tap Kaiser windowed sinc, keeps detail sharp over many levels
+};
+
+enum class MipPath {
+	Scalar,
+	SSE, //one pixel per iteration
+	AVX2 //two pixels per iteration
+};
+
+struct MipLevel {
+	int Width, Height;
+	std::vector<unsigned char> Pixels; //RGBA8
+};
+
+//Builds the mip chain of an RGBA8 image on the CPU. Level 0 is converted to float once and
+//every level is filtered from the one above it, rows spread over the job system. sRGB images
+//are filtered in linear light and encoded again per level, alpha is always linear.
+class MipGenerator {
+private:
+	MipFilter m_Filter;
+	bool m_SRGB;
+	MipPath m_Path;
+	float m_Kernel[8];
+
+public:
+	MipGenerator(MipFilter filter = MipFilter::Box, bool srgb = false, MipPath path = GetBestPath());
+
+	//Levels 1 down to 1x1, level 0 is the input itself
+	std::vector<MipLevel> Generate(const unsigned char* pixels, int width, int height, JobSystem& jobs) const;
+
+	static unsigned int GetLevelCount(int width, int height);
+	static MipPath GetBestPath();
+
+private:
+	void LoadRows(const unsigned char* pixels, float* target, int width, int begin, int end) const;
+	void StoreRows(const float* source, unsigned char* target, int width, int begin, int end) const;
+
+	void BoxRows(const float* source, int sourceWidth, int sourceHeight, float* target, int targetWidth, int begin, int end) const;
+	//Kaiser is separable: rows are halved horizontally first, then columns vertically
+	void KaiserHorizontal(const float* source, int sourceWidth, float* target, int targetWidth, int begin, int end) const;
+	void KaiserVertical(const float* source, int sourceHeight, float* target, int width, int begin, int end) const;
+};
\ No newline at end of file
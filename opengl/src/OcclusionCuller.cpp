@@ -0,0 +1,294 @@
+#include "OcclusionCuller.h"
+#include "JobSystem.h"
+#include "Simd.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+    //Vertices closer than this to the eye plane are not projected
+    const float NearW = 1e-4f;
+
+    double MsSince(std::chrono::high_resolution_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+}
+
+OcclusionCuller::OcclusionCuller(int width, int height)
+    : m_ViewProj(1.0f)
+{
+    m_TilesX = (width + TileWidth - 1) / TileWidth;
+    m_TilesY = (height + TileHeight - 1) / TileHeight;
+    m_Width = m_TilesX * TileWidth;
+    m_Height = m_TilesY * TileHeight;
+    m_Bins.resize(m_TilesX * m_TilesY);
+
+    //Level 0 is the depth buffer itself, each level above halves it down to 1x1
+    int levelWidth = m_Width, levelHeight = m_Height;
+    while (true) {
+        m_Levels.push_back({ levelWidth, levelHeight, std::vector<float>(levelWidth * levelHeight, 1.0f) });
+        if (levelWidth == 1 && levelHeight == 1)
+            break;
+        levelWidth = std::max(1, (levelWidth + 1) / 2);
+        levelHeight = std::max(1, (levelHeight + 1) / 2);
+    }
+}
+
+void OcclusionCuller::AddOccluder(const glm::vec3* vertices, const unsigned int* indices, unsigned int indexCount, const glm::mat4& model)
+{
+    m_Occluders.push_back({ vertices, indices, indexCount, model });
+}
+
+void OcclusionCuller::ClearOccluders()
+{
+    m_Occluders.clear();
+}
+
+void OcclusionCuller::Render(const glm::mat4& viewProj, JobSystem& jobs)
+{
+    m_ViewProj = viewProj;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    SetupTriangles();
+    std::fill(m_Levels[0].Depth.begin(), m_Levels[0].Depth.end(), 1.0f);
+    //One job per tile: nothing else writes its pixels, so no locking and no ordering issues
+    jobs.ParallelFor((unsigned int)m_Bins.size(), 1, [this](unsigned int begin, unsigned int end) {
+        for (unsigned int tile = begin; tile < end; tile++)
+            RasterizeTile(tile);
+    });
+    m_Stats.RasterMs = MsSince(start);
+
+    start = std::chrono::high_resolution_clock::now();
+    BuildHiZ();
+    m_Stats.HiZMs = MsSince(start);
+}
+
+void OcclusionCuller::SetupTriangles()
+{
+    m_Triangles.clear();
+    for (std::vector<unsigned int>& bin : m_Bins)
+        bin.clear();
+
+    std::vector<glm::vec3> screen;
+    std::vector<bool> clipped;
+    for (const Occluder& occluder : m_Occluders) {
+        glm::mat4 mvp = m_ViewProj * occluder.Model;
+
+        unsigned int vertexCount = 0;
+        for (unsigned int i = 0; i < occluder.IndexCount; i++)
+            vertexCount = std::max(vertexCount, occluder.Indices[i] + 1);
+
+        screen.resize(vertexCount);
+        clipped.assign(vertexCount, false);
+        for (unsigned int i = 0; i < vertexCount; i++) {
+            glm::vec4 clip = mvp * glm::vec4(occluder.Vertices[i], 1.0f);
+            if (clip.w < NearW) {
+                clipped[i] = true;
+                continue;
+            }
+            glm::vec3 ndc = glm::vec3(clip) / clip.w;
+            screen[i] = glm::vec3((ndc.x * 0.5f + 0.5f) * m_Width, (ndc.y * 0.5f + 0.5f) * m_Height, ndc.z * 0.5f + 0.5f);
+        }
+
+        for (unsigned int i = 0; i + 2 < occluder.IndexCount; i += 3) {
+            unsigned int i0 = occluder.Indices[i], i1 = occluder.Indices[i + 1], i2 = occluder.Indices[i + 2];
+            //Dropping a triangle that crosses the near plane only hides less, never too much
+            if (clipped[i0] || clipped[i1] || clipped[i2])
+                continue;
+
+            glm::vec3 v0 = screen[i0], v1 = screen[i1], v2 = screen[i2];
+            float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+            if (std::fabs(area) < 1e-6f)
+                continue;
+            //Occluders are drawn double sided, flip to one winding so the edge tests agree
+            if (area < 0.0f) {
+                std::swap(v1, v2);
+                area = -area;
+            }
+
+            Triangle tri;
+            tri.MinX = std::max(0, (int)std::floor(std::min({ v0.x, v1.x, v2.x })));
+            tri.MinY = std::max(0, (int)std::floor(std::min({ v0.y, v1.y, v2.y })));
+            tri.MaxX = std::min(m_Width - 1, (int)std::floor(std::max({ v0.x, v1.x, v2.x })));
+            tri.MaxY = std::min(m_Height - 1, (int)std::floor(std::max({ v0.y, v1.y, v2.y })));
+            if (tri.MinX > tri.MaxX || tri.MinY > tri.MaxY)
+                continue;
+
+            const glm::vec3* verts[3] = { &v0, &v1, &v2 };
+            for (int e = 0; e < 3; e++) {
+                const glm::vec3& a = *verts[e];
+                const glm::vec3& b = *verts[(e + 1) % 3];
+                tri.EdgeA[e] = a.y - b.y;
+                tri.EdgeB[e] = b.x - a.x;
+                tri.EdgeC[e] = -(tri.EdgeA[e] * a.x + tri.EdgeB[e] * a.y);
+            }
+
+            tri.DepthA = ((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) / area;
+            tri.DepthB = ((v2.z - v0.z) * (v1.x - v0.x) - (v1.z - v0.z) * (v2.x - v0.x)) / area;
+            tri.DepthC = v0.z - tri.DepthA * v0.x - tri.DepthB * v0.y;
+
+            unsigned int index = (unsigned int)m_Triangles.size();
+            m_Triangles.push_back(tri);
+            for (int ty = tri.MinY / TileHeight; ty <= tri.MaxY / TileHeight; ty++)
+                for (int tx = tri.MinX / TileWidth; tx <= tri.MaxX / TileWidth; tx++)
+                    m_Bins[ty * m_TilesX + tx].push_back(index);
+        }
+    }
+    m_Stats.OccluderTriangles = (unsigned int)m_Triangles.size();
+}
+
+void OcclusionCuller::RasterizeTile(int tile)
+{
+    int tileX = (tile % m_TilesX) * TileWidth;
+    int tileY = (tile / m_TilesX) * TileHeight;
+    float* depth = m_Levels[0].Depth.data();
+
+    for (unsigned int index : m_Bins[tile]) {
+        const Triangle& tri = m_Triangles[index];
+        //TileWidth is a multiple of 4, so rounding down to 4 stays inside the tile
+        int minX = std::max(tri.MinX, tileX) & ~3;
+        int maxX = std::min(tri.MaxX, tileX + TileWidth - 1);
+        int minY = std::max(tri.MinY, tileY);
+        int maxY = std::min(tri.MaxY, tileY + TileHeight - 1);
+
+#if defined(SIMD_SSE2)
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+        for (int y = minY; y <= maxY; y++) {
+            __m128 py = _mm_set1_ps(y + 0.5f);
+            //Everything constant along the row folded in once
+            __m128 rowEdge0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri.EdgeB[0]), py), _mm_set1_ps(tri.EdgeC[0]));
+            __m128 rowEdge1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri.EdgeB[1]), py), _mm_set1_ps(tri.EdgeC[1]));
+            __m128 rowEdge2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri.EdgeB[2]), py), _mm_set1_ps(tri.EdgeC[2]));
+            __m128 rowDepth = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri.DepthB), py), _mm_set1_ps(tri.DepthC));
+
+            float* row = depth + y * m_Width;
+            for (int x = minX; x <= maxX; x += 4) {
+                __m128 px = _mm_add_ps(_mm_set1_ps((float)x), offsets);
+                __m128 e0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri.EdgeA[0]), px), rowEdge0);
+                __m128 e1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri.EdgeA[1]), px), rowEdge1);
+                __m128 e2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri.EdgeA[2]), px), rowEdge2);
+                __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+                if (_mm_movemask_ps(inside) == 0)
+                    continue;
+
+                __m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri.DepthA), px), rowDepth);
+                __m128 old = _mm_loadu_ps(row + x);
+                __m128 nearest = _mm_min_ps(old, z);
+                _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, old)));
+            }
+        }
+#else
+        for (int y = minY; y <= maxY; y++) {
+            float py = y + 0.5f;
+            float* row = depth + y * m_Width;
+            for (int x = minX; x <= maxX; x++) {
+                float px = x + 0.5f;
+                bool inside = true;
+                for (int e = 0; e < 3; e++)
+                    inside &= tri.EdgeA[e] * px + tri.EdgeB[e] * py + tri.EdgeC[e] >= 0.0f;
+                if (inside)
+                    row[x] = std::min(row[x], tri.DepthA * px + tri.DepthB * py + tri.DepthC);
+            }
+        }
+#endif
+    }
+}
+
+void OcclusionCuller::BuildHiZ()
+{
+    //Each texel keeps the farthest depth of the 2x2 below it, so a box nearer than one texel
+    //is in front of everything that texel covers
+    for (size_t level = 1; level < m_Levels.size(); level++) {
+        const Level& src = m_Levels[level - 1];
+        Level& dst = m_Levels[level];
+        for (int y = 0; y < dst.Height; y++) {
+            int y0 = std::min(y * 2, src.Height - 1), y1 = std::min(y * 2 + 1, src.Height - 1);
+            for (int x = 0; x < dst.Width; x++) {
+                int x0 = std::min(x * 2, src.Width - 1), x1 = std::min(x * 2 + 1, src.Width - 1);
+                dst.Depth[y * dst.Width + x] = std::max(
+                    std::max(src.Depth[y0 * src.Width + x0], src.Depth[y0 * src.Width + x1]),
+                    std::max(src.Depth[y1 * src.Width + x0], src.Depth[y1 * src.Width + x1]));
+            }
+        }
+    }
+}
+
+bool OcclusionCuller::IsVisible(const glm::vec3& min, const glm::vec3& max) const
+{
+    glm::vec2 screenMin(1e30f), screenMax(-1e30f);
+    float nearest = 1.0f;
+    //Corners as one transformed point plus the transformed edges, instead of eight full transforms
+    glm::vec4 origin = m_ViewProj * glm::vec4(min, 1.0f);
+    glm::vec4 edgeX = m_ViewProj[0] * (max.x - min.x);
+    glm::vec4 edgeY = m_ViewProj[1] * (max.y - min.y);
+    glm::vec4 edgeZ = m_ViewProj[2] * (max.z - min.z);
+    for (int corner = 0; corner < 8; corner++) {
+        glm::vec4 clip = origin;
+        if (corner & 1) clip += edgeX;
+        if (corner & 2) clip += edgeY;
+        if (corner & 4) clip += edgeZ;
+        //Box reaches the eye plane, can't be behind anything
+        if (clip.w < NearW)
+            return true;
+        glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        glm::vec2 pixel((ndc.x * 0.5f + 0.5f) * m_Width, (ndc.y * 0.5f + 0.5f) * m_Height);
+        screenMin = glm::min(screenMin, pixel);
+        screenMax = glm::max(screenMax, pixel);
+        nearest = std::min(nearest, ndc.z * 0.5f + 0.5f);
+    }
+
+    int minX = std::max(0, (int)std::floor(screenMin.x));
+    int minY = std::max(0, (int)std::floor(screenMin.y));
+    int maxX = std::min(m_Width - 1, (int)std::floor(screenMax.x));
+    int maxY = std::min(m_Height - 1, (int)std::floor(screenMax.y));
+    //Off screen is the frustum culler's call
+    if (minX > maxX || minY > maxY)
+        return true;
+
+    //Climb until the rectangle spans at most 2x2 texels
+    size_t level = 0;
+    while (level + 1 < m_Levels.size() && ((maxX >> level) - (minX >> level) > 1 || (maxY >> level) - (minY >> level) > 1))
+        level++;
+
+    const Level& hiz = m_Levels[level];
+    for (int y = minY >> level; y <= (maxY >> level); y++)
+        for (int x = minX >> level; x <= (maxX >> level); x++)
+            if (nearest <= hiz.Depth[y * hiz.Width + x])
+                return true;
+    return false;
+}
+
+void OcclusionCuller::Cull(const glm::vec3* mins, const glm::vec3* maxs, unsigned int count, std::vector<unsigned int>& visible, JobSystem& jobs)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    const unsigned int chunkSize = 1024;
+    unsigned int chunks = (count + chunkSize - 1) / chunkSize;
+    std::vector<unsigned int> counts(chunks);
+
+    //Same scheme as FrustumCuller::CullParallel: survivors at the chunk start, packed in chunk order
+    visible.resize(count);
+    jobs.ParallelFor(count, chunkSize, [&](unsigned int begin, unsigned int end) {
+        unsigned int* out = visible.data() + begin;
+        unsigned int survivors = 0;
+        for (unsigned int i = begin; i < end; i++)
+            if (IsVisible(mins[i], maxs[i]))
+                out[survivors++] = i;
+        counts[begin / chunkSize] = survivors;
+    });
+
+    unsigned int total = 0;
+    for (unsigned int chunk = 0; chunk < chunks; chunk++) {
+        const unsigned int* src = visible.data() + chunk * chunkSize;
+        std::copy(src, src + counts[chunk], visible.data() + total);
+        total += counts[chunk];
+    }
+    visible.resize(total);
+
+    m_Stats.Tested = count;
+    m_Stats.Culled = count - total;
+    m_Stats.TestMs = MsSince(start);
+}
\ No newline at end of file
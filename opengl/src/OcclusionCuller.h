@@ -0,0 +1,85 @@
+#pragma once
+
+#include <vector>
+
+#include "glm/glm.hpp"
+
+class JobSystem;
+
+struct OcclusionStats {
+    unsigned int OccluderTriangles = 0;
+    unsigned int Tested = 0;
+    unsigned int Culled = 0;
+    double RasterMs = 0.0;
+    double HiZMs = 0.0;
+    double TestMs = 0.0;
+
+    inline float CulledPercent() const { return Tested ? 100.0f * Culled / Tested : 0.0f; }
+};
+
+//Rasterizes occluder meshes into a small CPU depth buffer and tests occludee boxes against
+//a max-depth pyramid built from it. No GL involved, so it runs and can be checked without a GPU.
+//Tiles are rasterized in parallel; each pixel is only written by the job owning its tile and
+//depth resolves with min(), so results do not depend on thread timing.
+class OcclusionCuller {
+public:
+    static const int TileWidth = 32;
+    static const int TileHeight = 16;
+
+private:
+    struct Occluder {
+        const glm::vec3* Vertices;
+        const unsigned int* Indices;
+        unsigned int IndexCount;
+        glm::mat4 Model;
+    };
+
+    //Screen space triangle, edges as A*x + B*y + C >= 0 inside
+    struct Triangle {
+        float EdgeA[3], EdgeB[3], EdgeC[3];
+        //depth = DepthA*x + DepthB*y + DepthC
+        float DepthA, DepthB, DepthC;
+        int MinX, MinY, MaxX, MaxY;
+    };
+
+    struct Level {
+        int Width, Height;
+        std::vector<float> Depth;
+    };
+
+    int m_Width, m_Height;
+    int m_TilesX, m_TilesY;
+    std::vector<Occluder> m_Occluders;
+    std::vector<Triangle> m_Triangles;
+    std::vector<std::vector<unsigned int>> m_Bins;
+    std::vector<Level> m_Levels;
+    glm::mat4 m_ViewProj;
+
+    OcclusionStats m_Stats;
+
+public:
+    //Width/height are rounded up to whole tiles
+    OcclusionCuller(int width = 256, int height = 128);
+
+    //Mesh data is referenced, not copied, and must stay alive
+    void AddOccluder(const glm::vec3* vertices, const unsigned int* indices, unsigned int indexCount, const glm::mat4& model);
+    void ClearOccluders();
+
+    //Rasterizes all occluders for this view and rebuilds the depth pyramid
+    void Render(const glm::mat4& viewProj, JobSystem& jobs);
+
+    //false if the box is certainly hidden behind the occluders
+    bool IsVisible(const glm::vec3& min, const glm::vec3& max) const;
+    //Replaces visible with the indices (ascending) of the boxes that survive
+    void Cull(const glm::vec3* mins, const glm::vec3* maxs, unsigned int count, std::vector<unsigned int>& visible, JobSystem& jobs);
+
+    inline int GetWidth() const { return m_Width; }
+    inline int GetHeight() const { return m_Height; }
+    inline const float* GetDepth() const { return m_Levels[0].Depth.data(); }
+    inline const OcclusionStats& GetStats() const { return m_Stats; }
+
+private:
+    void SetupTriangles();
+    void RasterizeTile(int tile);
+    void BuildHiZ();
+};
\ No newline at end of file
@@ -0,0 +1,172 @@
+#include "ProgramBinaryCache.h"
+#include "Shader.h"
+#include "Hash.h"
+#include "Debug.h"
+
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace {
+	const uint32_t FileMagic = 0x4E494250; //"PBIN"
+	const uint32_t FileVersion = 1;
+
+	struct FileHeader {
+		uint32_t Magic;
+		uint32_t Version;
+		uint64_t Key;
+		uint32_t Format;
+		uint32_t Length;
+	};
+
+	void MakeDirectory(const std::string& directory)
+	{
+#ifdef _WIN32
+		_mkdir(directory.c_str());
+#else
+		mkdir(directory.c_str(), 0755);
+#endif
+	}
+}
+
+ProgramBinaryCache::ProgramBinaryCache()
+	: m_Directory("shadercache"), m_Enabled(true), m_Supported(-1), m_DriverHash(0)
+{
+}
+
+ProgramBinaryCache& ProgramBinaryCache::Get()
+{
+	static ProgramBinaryCache cache;
+	return cache;
+}
+
+void ProgramBinaryCache::SetDirectory(const std::string& directory)
+{
+	m_Directory = directory;
+}
+
+bool ProgramBinaryCache::IsAvailable()
+{
+	if (m_Supported < 0) {
+		int formats = 0;
+		if (GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary)
+			GLCall(glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats));
+		m_Supported = formats > 0;
+
+		//Binaries are only valid for the exact driver that produced them
+		for (unsigned int name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+			const char* value = (const char*)glGetString(name);
+			m_DriverHash = Fnv1a64(std::string(value ? value : ""), m_DriverHash);
+		}
+	}
+	return m_Enabled && m_Supported > 0;
+}
+
+uint64_t ProgramBinaryCache::MakeKey(const ShaderProgramSource& source, const std::string& defines)
+{
+	IsAvailable();
+	uint64_t key = Fnv1a64(source.VertexSource, m_DriverHash);
+	key = Fnv1a64(source.FragmentSource, key);
+	return Fnv1a64(defines, key);
+}
+
+std::string ProgramBinaryCache::GetPath(uint64_t key) const
+{
+	char name[32];
+	snprintf(name, sizeof(name), "/%016llx.bin", (unsigned long long)key);
+	return m_Directory + name;
+}
+
+unsigned int ProgramBinaryCache::Load(uint64_t key)
+{
+	if (!IsAvailable())
+		return 0;
+
+	std::ifstream stream(GetPath(key), std::ios::binary);
+	if (!stream) {
+		m_Stats.Misses++;
+		return 0;
+	}
+
+	FileHeader header;
+	std::vector<char> binary;
+	bool valid = (bool)stream.read((char*)&header, sizeof(header))
+		&& header.Magic == FileMagic && header.Version == FileVersion && header.Key == key;
+	if (valid) {
+		//The length comes from disk, it has to be exactly what follows the header
+		std::streamoff begin = stream.tellg();
+		stream.seekg(0, std::ios::end);
+		std::streamoff remaining = stream.tellg() - begin;
+		stream.seekg(begin);
+		valid = header.Length > 0 && (std::streamoff)header.Length == remaining;
+	}
+	if (valid) {
+		binary.resize(header.Length);
+		valid = (bool)stream.read(binary.data(), header.Length);
+	}
+	stream.close();
+
+	unsigned int program = 0;
+	if (valid) {
+		program = glCreateProgram();
+		glProgramBinary(program, header.Format, binary.data(), header.Length);
+		//Drivers reject binaries they don't like with a failed link, not with an error
+		int linked = GL_FALSE;
+		glGetProgramiv(program, GL_LINK_STATUS, &linked);
+		GLClearError();
+		if (linked == GL_FALSE) {
+			glDeleteProgram(program);
+			program = 0;
+		}
+	}
+
+	if (!program) {
+		m_Stats.Rejected++;
+		Remove(key);
+		return 0;
+	}
+
+	m_Stats.Hits++;
+	return program;
+}
+
+void ProgramBinaryCache::PrepareForStore(unsigned int program)
+{
+	if (IsAvailable())
+		GLCall(glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+}
+
+void ProgramBinaryCache::Store(uint64_t key, unsigned int program)
+{
+	if (!IsAvailable())
+		return;
+
+	int length = 0;
+	GLCall(glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length));
+	if (length <= 0)
+		return;
+
+	std::vector<char> binary(length);
+	FileHeader header = { FileMagic, FileVersion, key, 0, 0 };
+	GLCall(glGetProgramBinary(program, length, &length, &header.Format, binary.data()));
+	header.Length = length;
+
+	MakeDirectory(m_Directory);
+	std::ofstream stream(GetPath(key), std::ios::binary | std::ios::trunc);
+	if (!stream)
+		return;
+	stream.write((const char*)&header, sizeof(header));
+	stream.write(binary.data(), length);
+	m_Stats.Stores++;
+}
+
+void ProgramBinaryCache::Remove(uint64_t key)
+{
+	std::remove(GetPath(key).c_str());
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+struct ShaderProgramSource;
+
+struct ProgramBinaryCacheStats {
+	unsigned int Hits = 0;
+	unsigned int Misses = 0;
+	//Entry found but unusable (driver changed, corrupt file), removed and recompiled
+	unsigned int Rejected = 0;
+	unsigned int Stores = 0;
+};
+
+//Linked programs saved with glGetProgramBinary, one file per program in the cache directory.
+//Keys hash the preprocessed sources, the defines and GL vendor/renderer/version, so a driver
+//update simply misses. Anything that fails to load is deleted and the caller compiles from source.
+class ProgramBinaryCache {
+private:
+	std::string m_Directory;
+	bool m_Enabled;
+	int m_Supported; //-1 until the first query, needs a current context
+	uint64_t m_DriverHash;
+
+	ProgramBinaryCacheStats m_Stats;
+
+public:
+	ProgramBinaryCache();
+
+	static ProgramBinaryCache& Get();
+
+	void SetDirectory(const std::string& directory);
+	inline const std::string& GetDirectory() const { return m_Directory; }
+	inline void SetEnabled(bool enabled) { m_Enabled = enabled; }
+	//GL 4.1 or ARB_get_program_binary, with at least one binary format
+	bool IsAvailable();
+
+	uint64_t MakeKey(const ShaderProgramSource& source, const std::string& defines);
+
+	//New linked program, 0 on a miss
+	unsigned int Load(uint64_t key);
+	//Call before glLinkProgram so the driver keeps the binary around
+	void PrepareForStore(unsigned int program);
+	void Store(uint64_t key, unsigned int program);
+	void Remove(uint64_t key);
+
+	inline const ProgramBinaryCacheStats& GetStats() const { return m_Stats; }
+	inline void ResetStats() { m_Stats = ProgramBinaryCacheStats(); }
+
+private:
+	std::string GetPath(uint64_t key) const;
+};
\ No newline at end of file
@@ -0,0 +1,144 @@
+#include "RenderQueue.h"
+#include "CommandList.h"
+
+#include <algorithm>
+
+namespace {
+    const uint64_t IdMask = (1u << 12) - 1;
+    const uint64_t DepthMask = (1u << 24) - 1;
+
+    constexpr UniformID s_MVP("u_MVP");
+
+    //Packets and commands alike, get(i) returns the i-th draw in the order being counted
+    template<typename Get>
+    void CountSwitches(RenderQueueStats& stats, int column, size_t count, Get get)
+    {
+        for (size_t i = 0; i < count; i++) {
+            const auto& draw = get(i);
+            if (i == 0 || get(i - 1).Program != draw.Program)
+                stats.ProgramSwitches[column]++;
+            if (i == 0 || get(i - 1).Tex != draw.Tex)
+                stats.TextureSwitches[column]++;
+            if (i == 0 || get(i - 1).VAO != draw.VAO)
+                stats.VAOSwitches[column]++;
+        }
+    }
+}
+
+uint64_t RenderQueue::MakeKey(RenderPass pass, unsigned int program, unsigned int texture, unsigned int vao, float depth)
+{
+    uint64_t d = (uint64_t)(std::min(std::max(depth, 0.0f), 1.0f) * DepthMask);
+    uint64_t state = ((program & IdMask) << 24) | ((texture & IdMask) << 12) | (vao & IdMask);
+    uint64_t key = (uint64_t)pass << 62;
+
+    if (pass == RenderPass::Transparent)
+        return key | ((DepthMask - d) << 36) | state;
+
+    return key | (state << 24) | d;
+}
+
+void RenderQueue::Submit(RenderPass pass, const VertexArray& vao, const IndexBuffer& ibo, Shader& shader,
+    const Texture* texture, const glm::mat4& mvp, float depth)
+{
+    unsigned int index = (unsigned int)m_Packets.size();
+    m_Packets.push_back({ &vao, &ibo, &shader, texture, mvp });
+
+    uint64_t key = MakeKey(pass, shader.GetRendererID(), texture ? texture->GetRendererID() : 0, vao.GetRendererID(), depth);
+    m_Buckets[(int)pass].push_back({ key, index });
+}
+
+//LSD radix sort over 8 bit digits. Stable, so equal keys keep submission order.
+void RenderQueue::RadixSort(std::vector<SortItem>& items, std::vector<SortItem>& scratch)
+{
+    scratch.resize(items.size());
+
+    for (int shift = 0; shift < 64; shift += 8) {
+        unsigned int counts[256] = {};
+        for (const SortItem& item : items)
+            counts[(item.Key >> shift) & 0xff]++;
+
+        //All keys share this digit, the pass would not move anything
+        if (counts[(items[0].Key >> shift) & 0xff] == items.size())
+            continue;
+
+        unsigned int offsets[256];
+        unsigned int sum = 0;
+        for (int i = 0; i < 256; i++) {
+            offsets[i] = sum;
+            sum += counts[i];
+        }
+
+        for (const SortItem& item : items)
+            scratch[offsets[(item.Key >> shift) & 0xff]++] = item;
+
+        items.swap(scratch);
+    }
+}
+
+void RenderQueue::Execute(const Renderer& renderer)
+{
+    m_Stats = RenderQueueStats();
+    m_Stats.Packets = (unsigned int)m_Packets.size();
+
+    CountSwitches(m_Stats, 0, m_Packets.size(), [this](size_t i) -> const DrawPacket& { return m_Packets[i]; });
+
+    m_Order.clear();
+    for (auto& bucket : m_Buckets) {
+        if (bucket.empty())
+            continue;
+        RadixSort(bucket, m_Scratch);
+        for (const SortItem& item : bucket)
+            m_Order.push_back(item.Index);
+        bucket.clear();
+    }
+    CountSwitches(m_Stats, 1, m_Order.size(), [this](size_t i) -> const DrawPacket& { return m_Packets[m_Order[i]]; });
+
+    const Texture* boundTexture = nullptr;
+    for (unsigned int index : m_Order) {
+        DrawPacket& packet = m_Packets[index];
+        if (packet.Tex && packet.Tex != boundTexture) {
+            packet.Tex->Bind();
+            boundTexture = packet.Tex;
+        }
+        packet.Program->Bind();
+        packet.Program->SetUniformMat4f(s_MVP, packet.MVP);
+        renderer.Draw(*packet.VAO, *packet.IBO, *packet.Program);
+    }
+
+    m_Packets.clear();
+}
+
+void RenderQueue::Execute(const Renderer& renderer, CommandList* const* lists, unsigned int listCount)
+{
+    m_Merged.clear();
+    m_MergedCommands.clear();
+    for (unsigned int l = 0; l < listCount; l++) {
+        for (const DrawCommand& command : lists[l]->GetCommands()) {
+            m_Merged.push_back({ command.Key, (unsigned int)m_MergedCommands.size() });
+            m_MergedCommands.push_back(&command);
+        }
+    }
+
+    m_Stats = RenderQueueStats();
+    m_Stats.Packets = (unsigned int)m_Merged.size();
+    if (m_Merged.empty())
+        return;
+
+    //The pass sits in the top bits of the key, one sort keeps opaque ahead of transparent
+    RadixSort(m_Merged, m_Scratch);
+    //Same counters as the single queue, lists appended in order stand for submission order
+    CountSwitches(m_Stats, 0, m_MergedCommands.size(), [this](size_t i) -> const DrawCommand& { return *m_MergedCommands[i]; });
+    CountSwitches(m_Stats, 1, m_Merged.size(), [this](size_t i) -> const DrawCommand& { return *m_MergedCommands[m_Merged[i].Index]; });
+
+    const Texture* boundTexture = nullptr;
+    for (const SortItem& item : m_Merged) {
+        const DrawCommand& command = *m_MergedCommands[item.Index];
+        if (command.Tex && command.Tex != boundTexture) {
+            command.Tex->Bind();
+            boundTexture = command.Tex;
+        }
+        command.Program->Bind();
+        CommandList::ApplyUniforms(command);
+        renderer.Draw(*command.VAO, *command.IBO, *command.Program);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Renderer.h"
+
+#include "glm/glm.hpp"
+
+class CommandList;
+struct DrawCommand;
+
+enum class RenderPass {
+    Opaque = 0,      //sorted by state, then front-to-back
+    Transparent = 1, //sorted back-to-front, then by state
+    Count
+};
+
+//One recorded draw, MVP is uploaded to u_MVP on replay.
+//Fixed size so the queue is a flat array rebuilt every frame.
+struct DrawPacket {
+    const VertexArray* VAO;
+    const IndexBuffer* IBO;
+    Shader* Program;
+    const Texture* Tex;
+    glm::mat4 MVP;
+};
+
+struct RenderQueueStats {
+    unsigned int Packets = 0;
+    //State changes in submission order vs after sorting
+    unsigned int ProgramSwitches[2] = { 0,0 };
+    unsigned int TextureSwitches[2] = { 0,0 };
+    unsigned int VAOSwitches[2] = { 0,0 };
+
+    inline unsigned int ProgramSwitchesSaved() const { return ProgramSwitches[0] - ProgramSwitches[1]; }
+    inline unsigned int TextureSwitchesSaved() const { return TextureSwitches[0] - TextureSwitches[1]; }
+    inline unsigned int VAOSwitchesSaved() const { return VAOSwitches[0] - VAOSwitches[1]; }
+};
+
+class RenderQueue {
+private:
+    struct SortItem {
+        uint64_t Key;
+        unsigned int Index;
+    };
+
+    std::vector<DrawPacket> m_Packets;
+    std::vector<SortItem> m_Buckets[(int)RenderPass::Count];
+    std::vector<SortItem> m_Scratch;
+    std::vector<unsigned int> m_Order;
+    std::vector<SortItem> m_Merged;
+    std::vector<const DrawCommand*> m_MergedCommands;
+
+    RenderQueueStats m_Stats;
+
+public:
+    //depth is the normalized view depth in [0,1], 0 = near
+    void Submit(RenderPass pass, const VertexArray& vao, const IndexBuffer& ibo, Shader& shader,
+        const Texture* texture, const glm::mat4& mvp, float depth);
+
+    //Sorts every bucket, draws opaque then transparent and clears the queue
+    void Execute(const Renderer& renderer);
+    //Merges command lists recorded on worker threads and replays them sorted. Lists are merged in
+    //array order and the sort is stable, so the result does not depend on thread scheduling.
+    void Execute(const Renderer& renderer, CommandList* const* lists, unsigned int listCount);
+
+    inline const RenderQueueStats& GetStats() const { return m_Stats; }
+
+    //Key layout, high to low bits:
+    //  opaque:      pass:2 | program:12 | texture:12 | vao:12 | depth:24
+    //  transparent: pass:2 | ~depth:24  | program:12 | texture:12 | vao:12
+    static uint64_t MakeKey(RenderPass pass, unsigned int program, unsigned int texture, unsigned int vao, float depth);
+
+private:
+    static void RadixSort(std::vector<SortItem>& items, std::vector<SortItem>& scratch);
+};
\ No newline at end of file
@@ -0,0 +1,106 @@
+#include "RenderThread.h"
+#include "Timer.h"
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <cstring>
+
+namespace {
+    template<typename T>
+    void CopyVector(ImVector<T>& dst, const ImVector<T>& src)
+    {
+        //resize keeps the capacity, operator= would free and reallocate every frame
+        dst.resize(src.Size);
+        if (src.Size)
+            memcpy(dst.Data, src.Data, src.Size * sizeof(T));
+    }
+}
+
+void FramePacket::SetDrawData(const ImDrawData* drawData)
+{
+    while ((int)m_DrawLists.size() < drawData->CmdListsCount)
+        m_DrawLists.push_back(std::make_unique<ImDrawList>(ImGui::GetDrawListSharedData()));
+    m_DrawListPtrs.resize(drawData->CmdListsCount);
+
+    for (int i = 0; i < drawData->CmdListsCount; i++) {
+        const ImDrawList* src = drawData->CmdLists[i];
+        ImDrawList* dst = m_DrawLists[i].get();
+        CopyVector(dst->CmdBuffer, src->CmdBuffer);
+        CopyVector(dst->IdxBuffer, src->IdxBuffer);
+        CopyVector(dst->VtxBuffer, src->VtxBuffer);
+        dst->Flags = src->Flags;
+        m_DrawListPtrs[i] = dst;
+    }
+
+    DrawData = *drawData;
+    DrawData.CmdLists = m_DrawListPtrs.data();
+}
+
+RenderThread::RenderThread(GLFWwindow* window, RenderFunc render)
+    :m_Window(window), m_Render(std::move(render))
+{
+}
+
+RenderThread::~RenderThread()
+{
+    if (m_Thread.joinable())
+        Stop();
+}
+
+void RenderThread::Start()
+{
+    m_Running = true;
+    m_Thread = std::thread(&RenderThread::Run, this);
+}
+
+void RenderThread::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Running = false;
+    }
+    m_CV.notify_all();
+    m_Thread.join();
+    glfwMakeContextCurrent(m_Window);
+}
+
+void RenderThread::Submit()
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_CV.wait(lock, [this] { return !m_Pending && !m_Rendering; });
+
+    m_ReadIndex = m_WriteIndex;
+    m_WriteIndex ^= 1;
+    m_Pending = true;
+    lock.unlock();
+    m_CV.notify_all();
+}
+
+void RenderThread::Run()
+{
+    glfwMakeContextCurrent(m_Window);
+
+    while (true) {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_CV.wait(lock, [this] { return m_Pending || !m_Running; });
+        if (!m_Pending)
+            break;
+
+        FramePacket& packet = m_Packets[m_ReadIndex];
+        m_Pending = false;
+        m_Rendering = true;
+        lock.unlock();
+
+        double cpuStart = ThreadCpuTimeMs();
+        m_Render(packet);
+        glfwSwapBuffers(m_Window);
+        packet.RenderCpuMs = ThreadCpuTimeMs() - cpuStart;
+
+        lock.lock();
+        m_Rendering = false;
+        lock.unlock();
+        m_CV.notify_all();
+    }
+
+    glfwMakeContextCurrent(nullptr);
+}
\ No newline at end of file
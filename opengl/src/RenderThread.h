@@ -0,0 +1,74 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "GLState.h"
+#include "Shader.h"
+#include "TextureManager.h"
+#include "vendor/imgui/imgui.h"
+
+#include "glm/glm.hpp"
+
+struct GLFWwindow;
+
+//Everything the render thread needs to draw one frame. Built by the main thread, then handed over.
+struct FramePacket {
+    glm::mat4 MVP{ 1.0f };
+    ImDrawData DrawData;
+
+    //Filled in by the render thread after drawing, read when the main thread gets the packet back
+    double RenderCpuMs = 0.0;
+    GLStateStats GLStats;
+    UniformStats Uniforms;
+    TextureManagerStats Textures;
+
+    //Deep copy, ImGui's own draw lists are overwritten by the next NewFrame
+    void SetDrawData(const ImDrawData* drawData);
+
+private:
+    std::vector<std::unique_ptr<ImDrawList>> m_DrawLists;
+    std::vector<ImDrawList*> m_DrawListPtrs;
+};
+
+//Owns the GL context on its own thread. The main thread fills one packet while the
+//render thread draws the other, so simulation of frame N+1 overlaps submission of frame N.
+class RenderThread {
+public:
+    using RenderFunc = std::function<void(FramePacket& packet)>;
+
+private:
+    GLFWwindow* m_Window;
+    RenderFunc m_Render;
+    std::thread m_Thread;
+
+    std::mutex m_Mutex;
+    std::condition_variable m_CV;
+    FramePacket m_Packets[2];
+    int m_WriteIndex = 0;
+    int m_ReadIndex = 0;
+    bool m_Pending = false;   //submitted, not picked up yet
+    bool m_Rendering = false; //render thread is drawing m_ReadIndex
+    bool m_Running = false;
+
+public:
+    RenderThread(GLFWwindow* window, RenderFunc render);
+    ~RenderThread();
+
+    //The context must not be current on the calling thread
+    void Start();
+    //Draws the last submitted packet, then makes the context current on the caller again
+    void Stop();
+
+    //Packet for the main thread to fill, free until Submit
+    inline FramePacket& GetWritePacket() { return m_Packets[m_WriteIndex]; }
+    //Hands the write packet over, waiting for the previous frame to finish drawing
+    void Submit();
+
+private:
+    void Run();
+};
\ No newline at end of file
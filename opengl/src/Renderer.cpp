@@ -3,7 +3,13 @@
 #include "IndexBuffer.h"
 #include "Shader.h"
 #include "VertexArray.h"
+#include "VertexBufferLayout.h"
 #include "Debug.h"
+#include "TextureLoader.h"
+#include "TextureManager.h"
+
+#include <cstring>
+#include <algorithm>
 
 
 void Renderer::Clear()
@@ -14,7 +20,286 @@ void Renderer::Clear()
 void Renderer::Draw(const VertexArray& vao, const IndexBuffer& ibo, const Shader& shader) const
 {
     shader.Bind();
+    shader.UploadUniforms();
     vao.Bind();
     ibo.Bind();
     GLCall(glDrawElements(GL_TRIANGLES, ibo.GetCount(), GL_UNSIGNED_INT, nullptr));
+    m_Stats.DrawCalls++;
+}
+
+void Renderer::DrawInstanced(const VertexArray& vao, const IndexBuffer& ibo, const Shader& shader, unsigned int instanceCount) const
+{
+    shader.Bind();
+    shader.UploadUniforms();
+    vao.Bind();
+    ibo.Bind();
+    GLCall(glDrawElementsInstanced(GL_TRIANGLES, ibo.GetCount(), GL_UNSIGNED_INT, nullptr, instanceCount));
+    m_Stats.DrawCalls++;
+}
+
+void Renderer::MultiDrawIndirect(const VertexArray& vao, const IndexBuffer& ibo, const IndirectBuffer& commands, const Shader& shader) const
+{
+    shader.Bind();
+    shader.UploadUniforms();
+    vao.Bind();
+    ibo.Bind();
+    commands.Bind();
+    GLCall(glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, commands.GetCount(), 0));
+    m_Stats.DrawCalls++;
+}
+
+bool Renderer::SupportsMultiDrawIndirect()
+{
+    return GLEW_ARB_multi_draw_indirect && GLEW_ARB_shader_draw_parameters;
+}
+
+void Renderer::InitBatch()
+{
+    m_QuadBuffer.reset(new QuadVertex[MaxVertices]);
+
+    //Room for a few full batches per frame unless reserved for more, three frames in flight
+    if (m_BatchStreamSize == 0)
+        m_BatchStreamSize = 4 * MaxVertices * (unsigned int)sizeof(QuadVertex);
+    CreateBatchStream(m_BatchStreamSize);
+
+    //Every quad uses the same 0,1,2,2,3,0 pattern, so the index buffer never changes
+    std::unique_ptr<unsigned int[]> indices(new unsigned int[MaxIndices]);
+    unsigned int offset = 0;
+    for (unsigned int i = 0; i < MaxIndices; i += 6) {
+        indices[i + 0] = offset + 0;
+        indices[i + 1] = offset + 1;
+        indices[i + 2] = offset + 2;
+        indices[i + 3] = offset + 2;
+        indices[i + 4] = offset + 3;
+        indices[i + 5] = offset + 0;
+        offset += 4;
+    }
+    m_QuadIBO = std::make_unique<IndexBuffer>(indices.get(), MaxIndices);
+
+    unsigned int white = 0xffffffff;
+    m_WhiteTexture = std::make_unique<Texture>(1, 1, &white);
+}
+
+void Renderer::CreateBatchStream(unsigned int frameSize)
+{
+    m_QuadVAO = std::make_unique<VertexArray>();
+    m_QuadStream = std::make_unique<StreamBuffer>(GL_ARRAY_BUFFER, frameSize);
+
+    VertexBufferLayout layout;
+    layout.Push<float>(2); //position
+    layout.Push<float>(2); //texcoord
+    layout.Push<float>(4); //color
+    layout.Push<float>(1); //texture slot
+    m_QuadVAO->AddBuffer(*m_QuadStream, layout);
+
+    //The element buffer binding belongs to the VAO
+    if (m_QuadIBO)
+        m_QuadIBO->Bind();
+}
+
+void Renderer::ReserveBatchQuads(unsigned int quadsPerFrame)
+{
+    ASSERT(m_QuadCount == 0);
+    //One vertex of alignment slack per flush
+    unsigned long long size = (unsigned long long)quadsPerFrame * 4 * sizeof(QuadVertex)
+        + (quadsPerFrame / MaxQuads + 1) * sizeof(QuadVertex);
+    size = std::min(size, (unsigned long long)MaxBatchStreamSize);
+    if (size <= m_BatchStreamSize)
+        return;
+
+    m_BatchStreamSize = (unsigned int)size;
+    if (m_QuadStream)
+        CreateBatchStream(m_BatchStreamSize);
+}
+
+void Renderer::BeginBatch(Shader& shader)
+{
+    if (!m_QuadVAO)
+        InitBatch();
+
+    m_BatchShader = &shader;
+    m_QuadBufferPtr = m_QuadBuffer.get();
+    m_QuadCount = 0;
+    m_TextureSlots[0] = m_WhiteTexture.get();
+    m_TextureSlotIndex = 1;
+    m_TextureArray = nullptr;
+
+    int samplers[MaxTextureSlots];
+    for (unsigned int i = 0; i < MaxTextureSlots; i++)
+        samplers[i] = i;
+
+    m_BatchShader->Bind();
+    m_BatchShader->SetUniform1iv("u_Textures", MaxTextureSlots, samplers);
+}
+
+void Renderer::DrawQuad(const glm::vec2& position, const glm::vec2& size, const glm::vec4& color)
+{
+    //Slot 0 is the white texture, an array batch would read it as layer 0
+    ASSERT(!m_TextureArray);
+    PushQuad(position, size, color, 0.0f);
+}
+
+void Renderer::DrawQuad(const glm::vec2& position, const glm::vec2& size, const Texture& texture, const glm::vec4& tint)
+{
+    ASSERT(!m_TextureArray);
+    if (texture.IsTopFirst())
+        PushQuad(position, size, tint, (float)GetTextureSlot(texture), glm::vec2(0.0f, 1.0f), glm::vec2(1.0f, 0.0f));
+    else
+        PushQuad(position, size, tint, (float)GetTextureSlot(texture));
+}
+
+void Renderer::DrawQuad(const glm::vec2& position, const glm::vec2& size, const Texture& texture, const glm::vec2& uvMin, const glm::vec2& uvMax, const glm::vec4& tint)
+{
+    ASSERT(!m_TextureArray);
+    //Top-first textures (DDS/KTX2) have V pointing down
+    if (texture.IsTopFirst())
+        PushQuad(position, size, tint, (float)GetTextureSlot(texture), glm::vec2(uvMin.x, 1.0f - uvMin.y), glm::vec2(uvMax.x, 1.0f - uvMax.y));
+    else
+        PushQuad(position, size, tint, (float)GetTextureSlot(texture), uvMin, uvMax);
 }
+
+void Renderer::BeginBatch(Shader& shader, const TextureArray& textures)
+{
+    if (!m_QuadVAO)
+        InitBatch();
+
+    m_BatchShader = &shader;
+    m_QuadBufferPtr = m_QuadBuffer.get();
+    m_QuadCount = 0;
+    m_TextureSlots[0] = m_WhiteTexture.get();
+    m_TextureSlotIndex = 1;
+    m_TextureArray = &textures;
+
+    m_BatchShader->Bind();
+    m_BatchShader->SetUniform1i("u_TextureArray", 0);
+}
+
+void Renderer::DrawQuad(const glm::vec2& position, const glm::vec2& size, const TextureArray& textures, unsigned int layer, const glm::vec4& tint)
+{
+    //A sampler2D batch shader cannot take the array, begin the batch with BeginBatch(shader, textures)
+    ASSERT(m_TextureArray);
+    if (!m_TextureArray)
+        return;
+
+    if (m_TextureArray != &textures) {
+        Flush();
+        m_TextureArray = &textures;
+    }
+    PushQuad(position, size, tint, (float)layer);
+}
+
+unsigned int Renderer::GetTextureSlot(const Texture& texture)
+{
+    unsigned int slot = 0;
+    for (unsigned int i = 1; i < m_TextureSlotIndex; i++) {
+        if (m_TextureSlots[i]->GetRendererID() == texture.GetRendererID()) {
+            slot = i;
+            break;
+        }
+    }
+
+    if (slot == 0) {
+        if (m_TextureSlotIndex >= MaxTextureSlots)
+            Flush();
+
+        slot = m_TextureSlotIndex++;
+        m_TextureSlots[slot] = &texture;
+    }
+    return slot;
+}
+
+void Renderer::PushQuad(const glm::vec2& position, const glm::vec2& size, const glm::vec4& color, float texIndex,
+    const glm::vec2& uvMin, const glm::vec2& uvMax)
+{
+    if (m_QuadCount >= MaxQuads) {
+        //Keep the texture slots, the quad being pushed may reference them
+        unsigned int slots = m_TextureSlotIndex;
+        Flush();
+        m_TextureSlotIndex = slots;
+    }
+
+    const glm::vec2 corners[4] = { {0.0f,0.0f},{1.0f,0.0f},{1.0f,1.0f},{0.0f,1.0f} };
+    for (int i = 0; i < 4; i++) {
+        m_QuadBufferPtr->Position = position + corners[i] * size;
+        m_QuadBufferPtr->TexCoord = uvMin + corners[i] * (uvMax - uvMin);
+        m_QuadBufferPtr->Color = color;
+        m_QuadBufferPtr->TexIndex = texIndex;
+        m_QuadBufferPtr++;
+    }
+
+    m_QuadCount++;
+    m_Stats.QuadCount++;
+}
+
+void Renderer::EndBatch()
+{
+    Flush();
+    m_BatchShader = nullptr;
+    m_TextureArray = nullptr;
+}
+
+void Renderer::Flush()
+{
+    if (m_QuadCount == 0)
+        return;
+
+    unsigned int size = (unsigned int)((char*)m_QuadBufferPtr - (char*)m_QuadBuffer.get());
+    unsigned int overflows = m_QuadStream->GetStats().Overflows;
+    StreamAllocation allocation = m_QuadStream->Allocate(size, sizeof(QuadVertex));
+    m_Stats.StreamOverflows += m_QuadStream->GetStats().Overflows - overflows;
+    m_BatchStreamBytes += size + (unsigned int)sizeof(QuadVertex);
+    memcpy(allocation.Data, m_QuadBuffer.get(), size);
+    m_QuadStream->Flush();
+
+    if (m_TextureArray) {
+        m_TextureArray->Bind(0);
+        m_Stats.TextureBinds++;
+    }
+    else {
+        for (unsigned int i = 0; i < m_TextureSlotIndex; i++)
+            m_TextureSlots[i]->Bind(i);
+        m_Stats.TextureBinds += m_TextureSlotIndex;
+    }
+
+    m_BatchShader->Bind();
+    m_BatchShader->UploadUniforms();
+    m_QuadVAO->Bind();
+    GLint baseVertex = allocation.Offset / sizeof(QuadVertex);
+    GLCall(glDrawElementsBaseVertex(GL_TRIANGLES, m_QuadCount * 6, GL_UNSIGNED_INT, nullptr, baseVertex));
+    m_Stats.DrawCalls++;
+
+    m_QuadBufferPtr = m_QuadBuffer.get();
+    m_QuadCount = 0;
+    m_TextureSlotIndex = 1;
+}
+
+void Renderer::SetFrameUniforms(const glm::mat4& viewProjection, float time, float deltaTime)
+{
+    if (!m_FrameUniforms) {
+        m_FrameUniforms = std::make_unique<UniformBuffer>((unsigned int)sizeof(FrameUniforms));
+        m_FrameUniforms->Bind(UniformBinding::Frame);
+    }
+
+    FrameUniforms frame = { viewProjection, glm::vec4(time, deltaTime, 0.0f, 0.0f) };
+    m_FrameUniforms->SetData(&frame, sizeof(frame));
+    m_FrameUniforms->Upload();
+}
+
+void Renderer::EndFrame()
+{
+    Shader::PollBuilds();
+    TextureLoader::Get().Update();
+    TextureManager::Get().Update();
+    if (m_QuadStream) {
+        m_QuadStream->EndFrame();
+
+        //An overflowing region waits on the fence of a frame still in flight, which makes the
+        //ring synchronous. Grow to the frame's workload with headroom so the next one fits.
+        if (m_BatchStreamBytes > m_BatchStreamSize && m_BatchStreamSize < MaxBatchStreamSize) {
+            unsigned long long size = (unsigned long long)m_BatchStreamBytes * 3 / 2;
+            m_BatchStreamSize = (unsigned int)std::min(size, (unsigned long long)MaxBatchStreamSize);
+            CreateBatchStream(m_BatchStreamSize);
+        }
+    }
+    m_BatchStreamBytes = 0;
+}
\ No newline at end of file
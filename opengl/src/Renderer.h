@@ -1,11 +1,119 @@
 #pragma once
 
+#include <array>
+#include <memory>
+
 #include "VertexArray.h"
 #include "IndexBuffer.h"
 #include "Shader.h"
+#include "Texture.h"
+#include "TextureArray.h"
+#include "IndirectBuffer.h"
+#include "StreamBuffer.h"
+#include "UniformBuffer.h"
+
+#include "glm/glm.hpp"
+
+//std140 mirror of the FrameData block
+struct FrameUniforms {
+    glm::mat4 ViewProjection;
+    glm::vec4 Time; //x = seconds, y = delta seconds
+};
+
+struct RendererStats {
+    unsigned int DrawCalls = 0;
+    unsigned int QuadCount = 0;
+    //Texture units bound by batch flushes
+    unsigned int TextureBinds = 0;
+    //Batch vertices did not fit the stream region, the batch stream grows at EndFrame
+    unsigned int StreamOverflows = 0;
+};
 
 class Renderer {
+public:
+    static const unsigned int MaxQuads = 10000;
+    static const unsigned int MaxVertices = MaxQuads * 4;
+    static const unsigned int MaxIndices = MaxQuads * 6;
+    static const unsigned int MaxTextureSlots = 16;
+    //Upper bound for one frame region of the batch stream, three regions are mapped
+    static const unsigned int MaxBatchStreamSize = 32 * 1024 * 1024;
+
+private:
+    struct QuadVertex {
+        glm::vec2 Position;
+        glm::vec2 TexCoord;
+        glm::vec4 Color;
+        float TexIndex;
+    };
+
+    //Batch
+    std::unique_ptr<VertexArray> m_QuadVAO;
+    std::unique_ptr<StreamBuffer> m_QuadStream;
+    std::unique_ptr<IndexBuffer> m_QuadIBO;
+    std::unique_ptr<Texture> m_WhiteTexture;
+    unsigned int m_BatchStreamSize = 0; //region size, 0 until the first batch
+    unsigned int m_BatchStreamBytes = 0; //streamed this frame
+
+    std::unique_ptr<QuadVertex[]> m_QuadBuffer;
+    QuadVertex* m_QuadBufferPtr = nullptr;
+    unsigned int m_QuadCount = 0;
+
+    std::array<const Texture*, MaxTextureSlots> m_TextureSlots{};
+    unsigned int m_TextureSlotIndex = 1; //0 = white texture
+    //Set for array batches, TexIndex is then the layer
+    const TextureArray* m_TextureArray = nullptr;
+
+    Shader* m_BatchShader = nullptr;
+
+    std::unique_ptr<UniformBuffer> m_FrameUniforms;
+
+    mutable RendererStats m_Stats;
+
 public:
     void Clear();
     void Draw(const VertexArray& vao,const IndexBuffer& ibo,const Shader& shader) const;
+    //Per-instance attributes come from layout elements with a divisor
+    void DrawInstanced(const VertexArray& vao, const IndexBuffer& ibo, const Shader& shader, unsigned int instanceCount) const;
+    //All commands of the indirect buffer in one call, shaders index per-draw data with gl_DrawIDARB
+    void MultiDrawIndirect(const VertexArray& vao, const IndexBuffer& ibo, const IndirectBuffer& commands, const Shader& shader) const;
+    static bool SupportsMultiDrawIndirect();
+
+    //Batch: quads are collected in a staging array and drawn with as few draw calls as possible.
+    //The shader needs a `u_Textures[MaxTextureSlots]` sampler array, u_MVP is left to the caller.
+    void BeginBatch(Shader& shader);
+    void DrawQuad(const glm::vec2& position, const glm::vec2& size, const glm::vec4& color);
+    void DrawQuad(const glm::vec2& position, const glm::vec2& size, const Texture& texture, const glm::vec4& tint = glm::vec4(1.0f));
+    //Part of a texture, e.g. an AtlasRegion. V is flipped for textures that are IsTopFirst.
+    void DrawQuad(const glm::vec2& position, const glm::vec2& size, const Texture& texture, const glm::vec2& uvMin, const glm::vec2& uvMax, const glm::vec4& tint = glm::vec4(1.0f));
+    //Array batch: every quad carries a layer of one TextureArray bound to unit 0, so any number of
+    //images draw without a flush. The shader needs a `u_TextureArray` sampler2DArray (BatchArray.shader),
+    //only the TextureArray DrawQuad goes into these batches (asserted, as is the reverse).
+    void BeginBatch(Shader& shader, const TextureArray& textures);
+    //Flushes first when the array differs from the one of the quads before
+    void DrawQuad(const glm::vec2& position, const glm::vec2& size, const TextureArray& textures, unsigned int layer, const glm::vec4& tint = glm::vec4(1.0f));
+    void EndBatch();
+    void Flush();
+    //Sizes the batch stream region for a frame of this many quads, call outside a batch.
+    //Frames that stream more than the region grow it at EndFrame.
+    void ReserveBatchQuads(unsigned int quadsPerFrame);
+
+    //Writes the shared FrameData block and binds it to UniformBinding::Frame,
+    //one upload for every program that declares the block
+    void SetFrameUniforms(const glm::mat4& viewProjection, float time, float deltaTime);
+
+    //Fences this frame's streamed data, picks up finished async shader builds and uploads
+    //the next slice of loading textures, call once per frame before swapping
+    void EndFrame();
+
+    inline const RendererStats& GetStats() const { return m_Stats; }
+    inline void ResetStats() { m_Stats = RendererStats(); }
+    inline const StreamBuffer* GetBatchStream() const { return m_QuadStream.get(); }
+
+private:
+    void InitBatch();
+    //New stream and VAO, the old stream's regions stay alive until GL is done with them
+    void CreateBatchStream(unsigned int frameSize);
+    void PushQuad(const glm::vec2& position, const glm::vec2& size, const glm::vec4& color, float texIndex,
+        const glm::vec2& uvMin = glm::vec2(0.0f), const glm::vec2& uvMax = glm::vec2(1.0f));
+    unsigned int GetTextureSlot(const Texture& texture);
 };
\ No newline at end of file
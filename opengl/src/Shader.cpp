@@ -1,94 +1,369 @@
 #include "Shader.h"
 #include "GL/glew.h"
 #include <iostream>
-#include <fstream>
-#include <sstream>
+#include <algorithm>
+#include <cstring>
 #include "Debug.h"
+#include "GLState.h"
+#include "ProgramBinaryCache.h"
+#include "ShaderPreprocessor.h"
+#include "ShaderArchive.h"
+
+
+UniformStats Shader::s_UniformStats;
+std::vector<Shader*> Shader::s_Building;
+bool Shader::s_ParallelCompileSet = false;
+
+namespace {
+	//Bytes of one array element. 0 for the 64-bit types, the setters only write 32-bit values.
+	//Everything else glGetActiveUniform reports (int, bool, samplers, images) is a single int.
+	unsigned int UniformElementSize(unsigned int type)
+	{
+		switch (type)
+		{
+			case GL_FLOAT_VEC2: case GL_INT_VEC2: case GL_UNSIGNED_INT_VEC2: case GL_BOOL_VEC2: return 8;
+			case GL_FLOAT_VEC3: case GL_INT_VEC3: case GL_UNSIGNED_INT_VEC3: case GL_BOOL_VEC3: return 12;
+			case GL_FLOAT_VEC4: case GL_INT_VEC4: case GL_UNSIGNED_INT_VEC4: case GL_BOOL_VEC4: return 16;
+			case GL_FLOAT_MAT2: return 16;
+			case GL_FLOAT_MAT3: return 36;
+			case GL_FLOAT_MAT4: return 64;
+			case GL_FLOAT_MAT2x3: case GL_FLOAT_MAT3x2: return 24;
+			case GL_FLOAT_MAT2x4: case GL_FLOAT_MAT4x2: return 32;
+			case GL_FLOAT_MAT3x4: case GL_FLOAT_MAT4x3: return 48;
+			case GL_DOUBLE: case GL_DOUBLE_VEC2: case GL_DOUBLE_VEC3: case GL_DOUBLE_VEC4:
+			case GL_DOUBLE_MAT2: case GL_DOUBLE_MAT3: case GL_DOUBLE_MAT4:
+			case GL_DOUBLE_MAT2x3: case GL_DOUBLE_MAT2x4: case GL_DOUBLE_MAT3x2:
+			case GL_DOUBLE_MAT3x4: case GL_DOUBLE_MAT4x2: case GL_DOUBLE_MAT4x3:
+			case GL_INT64_ARB: case GL_INT64_VEC2_ARB: case GL_INT64_VEC3_ARB: case GL_INT64_VEC4_ARB:
+			case GL_UNSIGNED_INT64_ARB: case GL_UNSIGNED_INT64_VEC2_ARB: case GL_UNSIGNED_INT64_VEC3_ARB: case GL_UNSIGNED_INT64_VEC4_ARB:
+				return 0;
+			default: return 4;
+		}
+	}
+
+	bool IsFloatUniform(unsigned int type)
+	{
+		switch (type)
+		{
+			case GL_FLOAT: case GL_FLOAT_VEC2: case GL_FLOAT_VEC3: case GL_FLOAT_VEC4:
+			case GL_FLOAT_MAT2: case GL_FLOAT_MAT3: case GL_FLOAT_MAT4:
+			case GL_FLOAT_MAT2x3: case GL_FLOAT_MAT2x4: case GL_FLOAT_MAT3x2:
+			case GL_FLOAT_MAT3x4: case GL_FLOAT_MAT4x2: case GL_FLOAT_MAT4x3:
+				return true;
+			default: return false;
+		}
+	}
+
+	bool IsUnsignedUniform(unsigned int type)
+	{
+		return type == GL_UNSIGNED_INT || type == GL_UNSIGNED_INT_VEC2 || type == GL_UNSIGNED_INT_VEC3 || type == GL_UNSIGNED_INT_VEC4;
+	}
+
+	//program != 0 uses glProgramUniform*, program == 0 the bound program
+	void SendUniform(unsigned int program, const UniformInfo& uniform, const unsigned char* value)
+	{
+		int location = uniform.Location;
+		int count = uniform.Size;
+		const float* f = (const float*)value;
+		const int* i = (const int*)value;
+		const unsigned int* u = (const unsigned int*)value;
+
+		switch (uniform.Type)
+		{
+			case GL_FLOAT: program ? glProgramUniform1fv(program, location, count, f) : glUniform1fv(location, count, f); break;
+			case GL_FLOAT_VEC2: program ? glProgramUniform2fv(program, location, count, f) : glUniform2fv(location, count, f); break;
+			case GL_FLOAT_VEC3: program ? glProgramUniform3fv(program, location, count, f) : glUniform3fv(location, count, f); break;
+			case GL_FLOAT_VEC4: program ? glProgramUniform4fv(program, location, count, f) : glUniform4fv(location, count, f); break;
+			case GL_INT_VEC2: case GL_BOOL_VEC2: program ? glProgramUniform2iv(program, location, count, i) : glUniform2iv(location, count, i); break;
+			case GL_INT_VEC3: case GL_BOOL_VEC3: program ? glProgramUniform3iv(program, location, count, i) : glUniform3iv(location, count, i); break;
+			case GL_INT_VEC4: case GL_BOOL_VEC4: program ? glProgramUniform4iv(program, location, count, i) : glUniform4iv(location, count, i); break;
+			case GL_UNSIGNED_INT: program ? glProgramUniform1uiv(program, location, count, u) : glUniform1uiv(location, count, u); break;
+			case GL_UNSIGNED_INT_VEC2: program ? glProgramUniform2uiv(program, location, count, u) : glUniform2uiv(location, count, u); break;
+			case GL_UNSIGNED_INT_VEC3: program ? glProgramUniform3uiv(program, location, count, u) : glUniform3uiv(location, count, u); break;
+			case GL_UNSIGNED_INT_VEC4: program ? glProgramUniform4uiv(program, location, count, u) : glUniform4uiv(location, count, u); break;
+			case GL_FLOAT_MAT2: program ? glProgramUniformMatrix2fv(program, location, count, GL_FALSE, f) : glUniformMatrix2fv(location, count, GL_FALSE, f); break;
+			case GL_FLOAT_MAT3: program ? glProgramUniformMatrix3fv(program, location, count, GL_FALSE, f) : glUniformMatrix3fv(location, count, GL_FALSE, f); break;
+			case GL_FLOAT_MAT4: program ? glProgramUniformMatrix4fv(program, location, count, GL_FALSE, f) : glUniformMatrix4fv(location, count, GL_FALSE, f); break;
+			case GL_FLOAT_MAT2x3: program ? glProgramUniformMatrix2x3fv(program, location, count, GL_FALSE, f) : glUniformMatrix2x3fv(location, count, GL_FALSE, f); break;
+			case GL_FLOAT_MAT2x4: program ? glProgramUniformMatrix2x4fv(program, location, count, GL_FALSE, f) : glUniformMatrix2x4fv(location, count, GL_FALSE, f); break;
+			case GL_FLOAT_MAT3x2: program ? glProgramUniformMatrix3x2fv(program, location, count, GL_FALSE, f) : glUniformMatrix3x2fv(location, count, GL_FALSE, f); break;
+			case GL_FLOAT_MAT3x4: program ? glProgramUniformMatrix3x4fv(program, location, count, GL_FALSE, f) : glUniformMatrix3x4fv(location, count, GL_FALSE, f); break;
+			case GL_FLOAT_MAT4x2: program ? glProgramUniformMatrix4x2fv(program, location, count, GL_FALSE, f) : glUniformMatrix4x2fv(location, count, GL_FALSE, f); break;
+			case GL_FLOAT_MAT4x3: program ? glProgramUniformMatrix4x3fv(program, location, count, GL_FALSE, f) : glUniformMatrix4x3fv(location, count, GL_FALSE, f); break;
+			//int, bool, samplers and images, 64-bit types never get here
+			default: program ? glProgramUniform1iv(program, location, count, i) : glUniform1iv(location, count, i); break;
+		}
+	}
+}
 
 
 Shader::~Shader()
 {
-	
+	s_Building.erase(std::remove(s_Building.begin(), s_Building.end(), this), s_Building.end());
 }
 
 void Shader::Bind() const
 {
-	GLCall(glUseProgram(m_RendererID));
+	GLState::Get().UseProgram(m_Status == ShaderStatus::Ready ? m_RendererID : GetPlaceholder().m_RendererID);
 }
 
 void Shader::UnBind() const
 {
-	GLCall(glUseProgram(0));
+	GLState::Get().UseProgram(0);
 }
 
 void Shader::SetUniform1i(const char* name, int value)
 {
-	unsigned int location = GetUniformLocation(name);
-	GLCall(glUniform1i(location, value));
+	WriteUniform(name, HashUniformName(name), &value, sizeof(int));
+}
+
+void Shader::SetUniform1i(UniformID id, int value)
+{
+	WriteUniform(nullptr, id.Hash, &value, sizeof(int));
+}
+
+void Shader::SetUniform1i(UniformHandle handle, int value)
+{
+	WriteUniform(handle, &value, sizeof(int));
+}
+
+void Shader::SetUniform1iv(const char* name, int count, const int* value)
+{
+	WriteUniform(name, HashUniformName(name), value, count * sizeof(int));
+}
+
+void Shader::SetUniform1iv(UniformID id, int count, const int* value)
+{
+	WriteUniform(nullptr, id.Hash, value, count * sizeof(int));
+}
+
+void Shader::SetUniform1iv(UniformHandle handle, int count, const int* value)
+{
+	WriteUniform(handle, value, count * sizeof(int));
 }
 
 void Shader::SetUniform4f(const char* name, float v0, float v1, float v2, float v3)
 {
-	unsigned int location = GetUniformLocation(name);
-	GLCall(glUniform4f(location, v0, v1, v2, v3));
+	float value[4] = { v0, v1, v2, v3 };
+	WriteUniform(name, HashUniformName(name), value, sizeof(value));
 }
 
-void Shader::SetUniformMat4f(const char* name, glm::mat4 proj)
+void Shader::SetUniform4f(UniformID id, float v0, float v1, float v2, float v3)
 {
-	unsigned int location = GetUniformLocation(name);
-	GLCall(glUniformMatrix4fv(location,1,GL_FALSE,&proj[0][0]));
+	float value[4] = { v0, v1, v2, v3 };
+	WriteUniform(nullptr, id.Hash, value, sizeof(value));
 }
 
-int Shader::GetUniformLocation(const char* name)
+void Shader::SetUniform4f(UniformHandle handle, float v0, float v1, float v2, float v3)
 {
-	if (m_UniformLoactionCache.find(name) != m_UniformLoactionCache.end()) 
-		return m_UniformLoactionCache[name];
+	float value[4] = { v0, v1, v2, v3 };
+	WriteUniform(handle, value, sizeof(value));
+}
 
-	int location = glGetUniformLocation(m_RendererID, (const GLchar*)name);
-	if (location == -1){
+void Shader::SetUniformMat4f(const char* name, const glm::mat4& matrix)
+{
+	WriteUniform(name, HashUniformName(name), &matrix[0][0], sizeof(glm::mat4));
+}
+
+void Shader::SetUniformMat4f(UniformID id, const glm::mat4& matrix)
+{
+	WriteUniform(nullptr, id.Hash, &matrix[0][0], sizeof(glm::mat4));
+}
+
+void Shader::SetUniformMat4f(UniformHandle handle, const glm::mat4& matrix)
+{
+	WriteUniform(handle, &matrix[0][0], sizeof(glm::mat4));
+}
+
+void Shader::WriteUniform(const char* name, unsigned int hash, const void* data, unsigned int size)
+{
+	//Not linked yet, nothing to look up. Keep the latest value and apply it once ready.
+	if (m_Status != ShaderStatus::Ready) {
+		const unsigned char* bytes = (const unsigned char*)data;
+		for (PendingUniform& pending : m_PendingUniforms) {
+			if (pending.Hash == hash) {
+				pending.Value.assign(bytes, bytes + size);
+				return;
+			}
+		}
+		m_PendingUniforms.push_back({ hash, std::vector<unsigned char>(bytes, bytes + size) });
+		return;
+	}
+
+	UniformHandle handle;
+	handle.Index = FindUniform(hash);
+	if (!handle.IsValid()) {
+		if (name)
+			std::cout << "Warning: uniform " << name << " doesn't exist!" << std::endl;
+		else
+			std::cout << "Warning: uniform with hash " << hash << " doesn't exist!" << std::endl;
+		return;
+	}
+	WriteUniform(handle, data, size);
+}
+
+void Shader::WriteUniform(UniformHandle handle, const void* data, unsigned int size)
+{
+	if (!handle.IsValid())
+		return;
+
+	s_UniformStats.Writes++;
+	const UniformInfo& uniform = m_Uniforms[handle.Index];
+	unsigned char* shadow = m_UniformValues.data() + uniform.ValueOffset;
+	size = std::min(size, uniform.ValueSize);
+	if (memcmp(shadow, data, size) == 0) {
+		s_UniformStats.Skipped++;
+		return;
+	}
+
+	memcpy(shadow, data, size);
+	if (!m_UniformDirty[handle.Index]) {
+		m_UniformDirty[handle.Index] = true;
+		m_DirtyUniforms.push_back(handle.Index);
+	}
+}
+
+void Shader::UploadUniforms() const
+{
+	if (m_Status != ShaderStatus::Ready) {
+		//Bind() picked the placeholder, give it this shader's u_MVP if there is one
+		Shader& placeholder = GetPlaceholder();
+		static constexpr UniformID mvp("u_MVP");
+		for (const PendingUniform& pending : m_PendingUniforms)
+			if (pending.Hash == mvp.Hash && pending.Value.size() == sizeof(glm::mat4))
+				placeholder.WriteUniform(nullptr, mvp.Hash, pending.Value.data(), sizeof(glm::mat4));
+		placeholder.UploadUniforms();
+		return;
+	}
+
+	if (m_DirtyUniforms.empty())
+		return;
+
+	static const bool dsa = GLEW_ARB_separate_shader_objects || GLEW_VERSION_4_1;
+	//Without DSA glUniform* goes to the bound program
+	unsigned int program = dsa ? m_RendererID : 0;
+	if (!dsa)
+		GLState::Get().UseProgram(m_RendererID);
+
+	GLClearError();
+	for (int index : m_DirtyUniforms) {
+		SendUniform(program, m_Uniforms[index], m_UniformValues.data() + m_Uniforms[index].ValueOffset);
+		m_UniformDirty[index] = false;
+	}
+	ASSERT(GLLogCall("Shader::UploadUniforms", __FILE__, __LINE__));
+
+	s_UniformStats.Issued += (unsigned int)m_DirtyUniforms.size();
+	m_DirtyUniforms.clear();
+}
+
+UniformHandle Shader::GetUniformHandle(const char* name) const
+{
+	UniformHandle handle;
+	handle.Index = FindUniform(HashUniformName(name));
+	if (!handle.IsValid()) {
 		LOG("Warning: uniform ");
 		LOG(name);
 		LOG("doesn't exist!");
 	}
+	return handle;
+}
 
-	return location;
+UniformHandle Shader::GetUniformHandle(UniformID id) const
+{
+	UniformHandle handle;
+	handle.Index = FindUniform(id.Hash);
+	if (!handle.IsValid())
+		std::cout << "Warning: uniform with hash " << id.Hash << " doesn't exist!" << std::endl;
+	return handle;
 }
 
+int Shader::FindUniform(unsigned int hash) const
+{
+	auto it = std::lower_bound(m_Uniforms.begin(), m_Uniforms.end(), hash,
+		[](const UniformInfo& uniform, unsigned int value) { return uniform.Hash < value; });
+	if (it == m_Uniforms.end() || it->Hash != hash)
+		return -1;
+	return (int)(it - m_Uniforms.begin());
+}
 
-ShaderProgramSource Shader::ParseShader(const std::string& filepath){
-	std::ifstream stream(filepath);
+void Shader::ReflectUniforms()
+{
+	m_Uniforms.clear();
 
-	enum class ShaderType {
-		NONE = -1,
-		VERTEX = 0,
-		FRAGMENT = 1
-	};
+	int count = 0;
+	GLCall(glGetProgramiv(m_RendererID, GL_ACTIVE_UNIFORMS, &count));
+	for (int i = 0; i < count; i++) {
+		char name[256];
+		int size = 0;
+		unsigned int type = 0;
+		GLCall(glGetActiveUniform(m_RendererID, i, sizeof(name), nullptr, &size, &type, name));
 
-	std::string line;
-	std::stringstream ss[2];
-	ShaderType type = ShaderType::NONE;
+		//Block members have no location, they are reflected with their block
+		int location = glGetUniformLocation(m_RendererID, name);
+		if (location == -1)
+			continue;
 
-	while (getline(stream, line)) {
-		if (line.find("#shader") != std::string::npos) {
-			if (line.find("vertex") != std::string::npos) {
-				type = ShaderType::VERTEX;
-			}
-			else if (line.find("fragment") != std::string::npos) {
-				type = ShaderType::FRAGMENT;
-			}
+		std::string uniformName = name;
+		size_t bracket = uniformName.find("[0]");
+		if (bracket != std::string::npos && bracket + 3 == uniformName.size())
+			uniformName.erase(bracket);
+
+		if (UniformElementSize(type) == 0) {
+			std::cout << "Warning: uniform " << uniformName << " has a 64-bit type, it is not settable through Shader" << std::endl;
+			continue;
 		}
-		else {
-			ss[(int)type] << line << "\n";
+
+		m_Uniforms.push_back({ HashUniformName(uniformName.c_str()), location, type, size, uniformName, 0, UniformElementSize(type) * size });
+	}
+
+	std::sort(m_Uniforms.begin(), m_Uniforms.end(),
+		[](const UniformInfo& a, const UniformInfo& b) { return a.Hash < b.Hash; });
+	for (size_t i = 1; i < m_Uniforms.size(); i++) {
+		if (m_Uniforms[i].Hash == m_Uniforms[i - 1].Hash)
+			std::cout << "Warning: uniforms " << m_Uniforms[i - 1].Name << " and " << m_Uniforms[i].Name
+				<< " have the same hash, rename one" << std::endl;
+	}
+
+	unsigned int valueSize = 0;
+	for (UniformInfo& uniform : m_Uniforms) {
+		uniform.ValueOffset = valueSize;
+		valueSize += (uniform.ValueSize + 15) & ~15u;
+	}
+	m_UniformValues.assign(valueSize, 0);
+
+	//Start the shadow copy from what the program holds, so GLSL initializers are not mistaken
+	//for zeros: writing 0 then still uploads and writing the initial value is skipped
+	GLClearError();
+	for (const UniformInfo& uniform : m_Uniforms) {
+		unsigned int elementSize = uniform.ValueSize / uniform.Size;
+		for (int element = 0; element < uniform.Size; element++) {
+			int location = uniform.Location;
+			if (element > 0)
+				location = glGetUniformLocation(m_RendererID, (uniform.Name + "[" + std::to_string(element) + "]").c_str());
+			if (location == -1)
+				continue;
+
+			void* value = m_UniformValues.data() + uniform.ValueOffset + element * elementSize;
+			if (IsFloatUniform(uniform.Type))
+				glGetUniformfv(m_RendererID, location, (float*)value);
+			else if (IsUnsignedUniform(uniform.Type))
+				glGetUniformuiv(m_RendererID, location, (unsigned int*)value);
+			else
+				glGetUniformiv(m_RendererID, location, (int*)value);
 		}
 	}
+	ASSERT(GLLogCall("Shader::ReflectUniforms", __FILE__, __LINE__));
 
-	return { ss[0].str(),ss[1].str() };
+	m_UniformDirty.assign(m_Uniforms.size(), false);
+	m_DirtyUniforms.clear();
 }
 
 
 
 
 
+
+
 //Shader 
 unsigned int Shader::CompileShader(unsigned int type,std::string& source) {
 	unsigned int id = glCreateShader(type);
@@ -96,7 +371,11 @@ unsigned int Shader::CompileShader(unsigned int type,std::string& source) {
 	glShaderSource(id, 1, &src, nullptr);
 	glCompileShader(id);
 
-	//TODO Error handling
+	//Status is checked in FinishBuild, asking now would wait for the compiler
+	return id;
+}
+
+bool Shader::CheckCompileStatus(unsigned int id, unsigned int type) {
 	int result;
 	glGetShaderiv(id, GL_COMPILE_STATUS, &result);
 	if (result == GL_FALSE) {
@@ -107,29 +386,259 @@ unsigned int Shader::CompileShader(unsigned int type,std::string& source) {
 		std::cout << "Failed to compile " <<
 			(type == GL_VERTEX_SHADER ? "vertex" : "fragment") << " shader!" << std::endl;
 		std::cout << message << std::endl;
+		return false;
+	}
+	return true;
+}
 
-		glDeleteShader(id);
-		return 0;
+void Shader::CreateShader(const std::string& filepath) {
+	m_FilePath = filepath;
+	ShaderProgramSource source;
+	if (!LoadDefaultPermutation(filepath, source)) {
+		std::cout << "Failed to load shader " << filepath << ", using the placeholder" << std::endl;
+		m_Status = ShaderStatus::Failed;
+		return;
 	}
+	CreateShaderFromSource(source, false);
+}
 
-	return id;
+void Shader::CreateShaderAsync(const std::string& filepath) {
+	m_FilePath = filepath;
+	ShaderProgramSource source;
+	if (!LoadDefaultPermutation(filepath, source)) {
+		std::cout << "Failed to load shader " << filepath << ", using the placeholder" << std::endl;
+		m_Status = ShaderStatus::Failed;
+		return;
+	}
+	CreateShaderFromSource(source, true);
 }
 
-void Shader::CreateShader(const std::string& filepath) {
-	ShaderProgramSource source = Shader::ParseShader(filepath);
-	
-	unsigned int program = glCreateProgram();
-	unsigned int vs = CompileShader(GL_VERTEX_SHADER, source.VertexSource);
-	unsigned int fs = CompileShader(GL_FRAGMENT_SHADER, source.FragmentSource);
-
-	glAttachShader(program, vs);
-	glAttachShader(program, fs);
-	glLinkProgram(program);
-	glValidateProgram(program);
+bool Shader::LoadDefaultPermutation(const std::string& filepath, ShaderProgramSource& source) {
+	//Cooked archive first, it has every permutation preprocessed already
+	if (ShaderArchive::Get().GetPermutation(filepath, 0, source))
+		return true;
+
+	//Files with variants get the first keyword of every set, ShaderVariants picks others
+	ShaderFile file;
+	if (!ShaderPreprocessor::Load(filepath, file))
+		return false;
+	source = ShaderPreprocessor::MakePermutation(file, 0);
+	return true;
+}
+
+void Shader::CreateShaderFromSource(const ShaderProgramSource& source, bool async /*= false*/) {
+	//A rebuild replaces whatever is still compiling or failed before
+	s_Building.erase(std::remove(s_Building.begin(), s_Building.end(), this), s_Building.end());
+	DeleteProgram();
+	m_PendingUniforms.clear();
+
+	//A cached binary skips compile and link entirely
+	ProgramBinaryCache& cache = ProgramBinaryCache::Get();
+	m_CacheKey = cache.MakeKey(source, "");
+	unsigned int program = cache.Load(m_CacheKey);
+	if (program) {
+		m_RendererID = program;
+		m_Status = ShaderStatus::Ready;
+		ReflectUniforms();
+		ReflectUniformBlocks();
+		return;
+	}
+
+	if (async && !s_ParallelCompileSet) {
+		//Let the driver use as many compiler threads as it likes
+		if (GLEW_KHR_parallel_shader_compile)
+			glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+		else if (GLEW_ARB_parallel_shader_compile)
+			glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+		s_ParallelCompileSet = true;
+	}
+
+	std::string vertexSource = source.VertexSource, fragmentSource = source.FragmentSource;
+	program = glCreateProgram();
+	m_VertexID = CompileShader(GL_VERTEX_SHADER, vertexSource);
+	m_FragmentID = CompileShader(GL_FRAGMENT_SHADER, fragmentSource);
 
-	glDeleteShader(vs);
-	glDeleteShader(fs);
+	glAttachShader(program, m_VertexID);
+	glAttachShader(program, m_FragmentID);
+	cache.PrepareForStore(program);
+	glLinkProgram(program);
 
-	//std::cout << program << std::endl;
 	m_RendererID = program;
+	m_Status = ShaderStatus::Compiling;
+	if (async)
+		s_Building.push_back(this);
+	else
+		FinishBuild();
+}
+
+bool Shader::IsBuildComplete() const {
+	if (GLEW_KHR_parallel_shader_compile || GLEW_ARB_parallel_shader_compile) {
+		int complete = GL_FALSE;
+		glGetProgramiv(m_RendererID, GL_COMPLETION_STATUS_KHR, &complete);
+		return complete == GL_TRUE;
+	}
+	//No way to ask without blocking, the first poll finishes it
+	return true;
+}
+
+void Shader::FinishBuild() {
+	bool compiled = CheckCompileStatus(m_VertexID, GL_VERTEX_SHADER);
+	compiled &= CheckCompileStatus(m_FragmentID, GL_FRAGMENT_SHADER);
+
+	glDetachShader(m_RendererID, m_VertexID);
+	glDetachShader(m_RendererID, m_FragmentID);
+	glDeleteShader(m_VertexID);
+	glDeleteShader(m_FragmentID);
+	m_VertexID = m_FragmentID = 0;
+
+	int linked = GL_FALSE;
+	glGetProgramiv(m_RendererID, GL_LINK_STATUS, &linked);
+	if (!compiled || linked == GL_FALSE) {
+		int length = 0;
+		glGetProgramiv(m_RendererID, GL_INFO_LOG_LENGTH, &length);
+		if (length > 0) {
+			std::vector<char> message(length);
+			glGetProgramInfoLog(m_RendererID, length, &length, message.data());
+			std::cout << "Failed to link " << m_FilePath << std::endl << message.data() << std::endl;
+		}
+		//Keeps drawing with the placeholder
+		DeleteProgram();
+		m_Status = ShaderStatus::Failed;
+		return;
+	}
+
+	ProgramBinaryCache::Get().Store(m_CacheKey, m_RendererID);
+
+	m_Status = ShaderStatus::Ready;
+	ReflectUniforms();
+	ReflectUniformBlocks();
+
+	for (const PendingUniform& pending : m_PendingUniforms)
+		WriteUniform(nullptr, pending.Hash, pending.Value.data(), (unsigned int)pending.Value.size());
+	m_PendingUniforms.clear();
+}
+
+void Shader::DeleteProgram() {
+	if (m_VertexID) {
+		glDeleteShader(m_VertexID);
+		m_VertexID = 0;
+	}
+	if (m_FragmentID) {
+		glDeleteShader(m_FragmentID);
+		m_FragmentID = 0;
+	}
+	if (m_RendererID) {
+		GLState::Get().OnDeleteProgram(m_RendererID);
+		glDeleteProgram(m_RendererID);
+		m_RendererID = 0;
+	}
+}
+
+unsigned int Shader::PollBuilds() {
+	for (size_t i = 0; i < s_Building.size();) {
+		Shader* shader = s_Building[i];
+		if (shader->IsBuildComplete()) {
+			shader->FinishBuild();
+			s_Building[i] = s_Building.back();
+			s_Building.pop_back();
+		}
+		else {
+			i++;
+		}
+	}
+	return (unsigned int)s_Building.size();
+}
+
+Shader& Shader::GetPlaceholder() {
+	static Shader placeholder;
+	static bool built = false;
+	if (!built) {
+		built = true;
+		ShaderProgramSource source;
+		source.VertexSource =
+			"#version 330 core\n"
+			"layout(location = 0) in vec4 position;\n"
+			"uniform mat4 u_MVP;\n"
+			"void main() { gl_Position = u_MVP * position; }\n";
+		source.FragmentSource =
+			"#version 330 core\n"
+			"layout(location = 0) out vec4 color;\n"
+			"void main() { color = vec4(1.0, 0.0, 1.0, 1.0); }\n";
+		placeholder.m_FilePath = "<placeholder>";
+		placeholder.CreateShaderFromSource(source, false);
+		placeholder.SetUniformMat4f("u_MVP", glm::mat4(1.0f));
+	}
+	return placeholder;
+}
+
+void Shader::ReflectUniformBlocks()
+{
+	m_UniformBlocks.clear();
+
+	int blockCount = 0;
+	GLCall(glGetProgramiv(m_RendererID, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount));
+	for (int block = 0; block < blockCount; block++) {
+		UniformBlockLayout layout;
+		layout.Index = block;
+
+		char name[256];
+		GLCall(glGetActiveUniformBlockName(m_RendererID, block, sizeof(name), nullptr, name));
+		layout.Name = name;
+
+		int size = 0, memberCount = 0;
+		GLCall(glGetActiveUniformBlockiv(m_RendererID, block, GL_UNIFORM_BLOCK_DATA_SIZE, &size));
+		GLCall(glGetActiveUniformBlockiv(m_RendererID, block, GL_UNIFORM_BLOCK_ACTIVE_UNIFORMS, &memberCount));
+		layout.Size = size;
+
+		std::vector<int> indices(memberCount);
+		if (memberCount > 0)
+			GLCall(glGetActiveUniformBlockiv(m_RendererID, block, GL_UNIFORM_BLOCK_ACTIVE_UNIFORM_INDICES, indices.data()));
+
+		//One query per property for all members at once
+		std::vector<unsigned int> uniforms(indices.begin(), indices.end());
+		std::vector<int> types(memberCount), offsets(memberCount), arrayStrides(memberCount), matrixStrides(memberCount);
+		if (memberCount > 0) {
+			GLCall(glGetActiveUniformsiv(m_RendererID, memberCount, uniforms.data(), GL_UNIFORM_TYPE, types.data()));
+			GLCall(glGetActiveUniformsiv(m_RendererID, memberCount, uniforms.data(), GL_UNIFORM_OFFSET, offsets.data()));
+			GLCall(glGetActiveUniformsiv(m_RendererID, memberCount, uniforms.data(), GL_UNIFORM_ARRAY_STRIDE, arrayStrides.data()));
+			GLCall(glGetActiveUniformsiv(m_RendererID, memberCount, uniforms.data(), GL_UNIFORM_MATRIX_STRIDE, matrixStrides.data()));
+		}
+
+		for (int i = 0; i < memberCount; i++) {
+			GLCall(glGetActiveUniformName(m_RendererID, uniforms[i], sizeof(name), nullptr, name));
+			std::string memberName = name;
+			size_t bracket = memberName.find("[0]");
+			if (bracket != std::string::npos && bracket + 3 == memberName.size())
+				memberName.erase(bracket);
+			layout.Members.push_back({ memberName, (unsigned int)types[i], offsets[i], arrayStrides[i], matrixStrides[i] });
+		}
+		std::sort(layout.Members.begin(), layout.Members.end(),
+			[](const UniformBlockMember& a, const UniformBlockMember& b) { return a.Offset < b.Offset; });
+
+		int binding = UniformBuffer::GetStandardBinding(layout.Name);
+		if (binding >= 0)
+			GLCall(glUniformBlockBinding(m_RendererID, block, binding));
+
+		m_UniformBlocks.push_back(std::move(layout));
+	}
+}
+
+const UniformBlockLayout* Shader::GetUniformBlock(const char* name) const
+{
+	for (const UniformBlockLayout& block : m_UniformBlocks)
+		if (block.Name == name)
+			return &block;
+	return nullptr;
+}
+
+void Shader::BindUniformBlock(const char* name, unsigned int binding)
+{
+	const UniformBlockLayout* block = GetUniformBlock(name);
+	if (!block) {
+		LOG("Warning: uniform block ");
+		LOG(name);
+		LOG("doesn't exist!");
+		return;
+	}
+	GLCall(glUniformBlockBinding(m_RendererID, block->Index, binding));
 }
\ No newline at end of file
@@ -1,9 +1,11 @@
 #pragma once
 
 #include "GL/glew.h"
+#include <cstdint>
 #include <string>
-#include <unordered_map>
+#include <vector>
 #include "glm/glm.hpp"
+#include "UniformBuffer.h"
 
 enum class ShaderType {
 	NONE = -1,
@@ -11,6 +13,52 @@ enum class ShaderType {
 	FRAGMENT = GL_FRAGMENT_SHADER,
 };
 
+//FNV-1a of a uniform name. constexpr, so `static constexpr UniformID id("u_Color");`
+//is hashed by the compiler and the setter only does a binary search.
+constexpr unsigned int HashUniformName(const char* name)
+{
+	unsigned int hash = 2166136261u;
+	while (*name)
+		hash = (hash ^ (unsigned char)*name++) * 16777619u;
+	return hash;
+}
+
+struct UniformID {
+	unsigned int Hash;
+	constexpr explicit UniformID(const char* name) : Hash(HashUniformName(name)) {}
+};
+
+//Index into one shader's uniform table, resolve once and keep it
+struct UniformHandle {
+	int Index = -1;
+	inline bool IsValid() const { return Index >= 0; }
+};
+
+//Active uniform outside of blocks, arrays are stored once without the [0]
+struct UniformInfo {
+	unsigned int Hash;
+	int Location;
+	unsigned int Type;
+	int Size;
+	std::string Name;
+	unsigned int ValueOffset; //into the shadow copy
+	unsigned int ValueSize;
+};
+
+//Uniform traffic since the last ResetUniformStats, over all shaders
+struct UniformStats {
+	unsigned int Writes = 0;  //setter calls
+	unsigned int Skipped = 0; //value equal to the shadow copy, nothing to send
+	unsigned int Issued = 0;  //glProgramUniform*/glUniform* calls
+};
+
+enum class ShaderStatus {
+	Empty,
+	Compiling, //submitted, the placeholder draws in its place
+	Ready,
+	Failed     //compile or link error, keeps the placeholder
+};
+
 struct ShaderProgramSource {
 	std::string VertexSource;
 	std::string FragmentSource;
@@ -21,25 +69,101 @@ private:
 	std::string m_FilePath;
 	unsigned int m_RendererID;
 	std::string m_ShaderSource;
-	std::unordered_map<std::string,int> m_UniformLoactionCache;
+	uint64_t m_CacheKey;
+	ShaderStatus m_Status;
+	unsigned int m_VertexID;
+	unsigned int m_FragmentID;
+
+	//Values set before the program is linked, applied by FinishBuild
+	struct PendingUniform {
+		unsigned int Hash;
+		std::vector<unsigned char> Value;
+	};
+	std::vector<PendingUniform> m_PendingUniforms;
+	std::vector<UniformInfo> m_Uniforms; //sorted by Hash
+	std::vector<UniformBlockLayout> m_UniformBlocks;
+
+	//Last value written for every uniform, starts zeroed like GL's own defaults.
+	//Setters only update this; changed uniforms are queued and sent by UploadUniforms.
+	std::vector<unsigned char> m_UniformValues;
+	mutable std::vector<int> m_DirtyUniforms;
+	mutable std::vector<bool> m_UniformDirty;
+
+	static UniformStats s_UniformStats;
+	static std::vector<Shader*> s_Building;
+	static bool s_ParallelCompileSet;
 public:
-	Shader() : m_RendererID(0) {};
+	Shader() : m_RendererID(0), m_CacheKey(0), m_Status(ShaderStatus::Empty), m_VertexID(0), m_FragmentID(0) {};
 	~Shader();
 
 	void Bind() const;
 	void UnBind() const;
 	void CreateShader(const std::string& filepath);
+	//Submits compile and link and returns without waiting. Until PollBuilds sees it finished
+	//the shader draws with the placeholder; uniforms set meanwhile are kept and applied.
+	void CreateShaderAsync(const std::string& filepath);
+	void CreateShaderFromSource(const ShaderProgramSource& source, bool async = false);
+
+	inline ShaderStatus GetStatus() const { return m_Status; }
+	inline bool IsReady() const { return m_Status == ShaderStatus::Ready; }
+
+	//Finishes async builds the driver is done with, never blocks when KHR/ARB_parallel_shader_compile
+	//is there (without it, the first poll waits for everything). Returns how many are still building.
+	static unsigned int PollBuilds();
+	//Flat magenta, drawn with u_MVP in place of shaders that aren't ready
+	static Shader& GetPlaceholder();
 
-	//Set uniforms
+	//Set uniforms, by name, by hashed name or by handle. None of them allocate or query GL
+	//for the location, the handle overloads skip the lookup as well.
+	//Values are compared against the shadow copy and only changes reach GL, at UploadUniforms.
 	void SetUniform1i(const char* name, int value);
+	void SetUniform1i(UniformID id, int value);
+	void SetUniform1i(UniformHandle handle, int value);
+	void SetUniform1iv(const char* name, int count, const int* value);
+	void SetUniform1iv(UniformID id, int count, const int* value);
+	void SetUniform1iv(UniformHandle handle, int count, const int* value);
 	void SetUniform4f(const char* name, float v0, float v1, float v2, float v3);
+	void SetUniform4f(UniformID id, float v0, float v1, float v2, float v3);
+	void SetUniform4f(UniformHandle handle, float v0, float v1, float v2, float v3);
+	void SetUniformMat4f(const char* name, const glm::mat4& matrix);
+	void SetUniformMat4f(UniformID id, const glm::mat4& matrix);
+	void SetUniformMat4f(UniformHandle handle, const glm::mat4& matrix);
+
+	//Invalid handle (and a warning) if the program has no such active uniform.
+	//Only resolvable once the shader is ready.
+	UniformHandle GetUniformHandle(const char* name) const;
+	UniformHandle GetUniformHandle(UniformID id) const;
+	inline const std::vector<UniformInfo>& GetUniforms() const { return m_Uniforms; }
+
+	//Sends every changed uniform in one pass, the Renderer calls it right before each draw.
+	//Uses glProgramUniform* when ARB_separate_shader_objects is there, otherwise binds the program.
+	void UploadUniforms() const;
+
+	static inline const UniformStats& GetUniformStats() { return s_UniformStats; }
+	static inline void ResetUniformStats() { s_UniformStats = UniformStats(); }
+
+	//Uniform blocks, reflected at link time. FrameData/MaterialData are already bound to
+	//their UniformBinding, others need BindUniformBlock.
+	const UniformBlockLayout* GetUniformBlock(const char* name) const;
+	inline const std::vector<UniformBlockLayout>& GetUniformBlocks() const { return m_UniformBlocks; }
+	void BindUniformBlock(const char* name, unsigned int binding);
 
 	unsigned int GetRendererID() const { return m_RendererID; }
+	//Key of the program in the ProgramBinaryCache
+	uint64_t GetCacheKey() const { return m_CacheKey; }
 private:
-	int GetUniformLocation(const char* name);
+	void ReflectUniforms();
+	void ReflectUniformBlocks();
+	int FindUniform(unsigned int hash) const;
+	void WriteUniform(const char* name, unsigned int hash, const void* data, unsigned int size);
+	void WriteUniform(UniformHandle handle, const void* data, unsigned int size);
+	bool IsBuildComplete() const;
+	void FinishBuild();
+	//Drops the program and any stage still being compiled
+	void DeleteProgram();
 
 	static unsigned int CompileShader(unsigned int type, std::string& source);
-	static ShaderProgramSource ParseShader(const std::string& filepath);
-public:
-	void SetUniformMat4f(const char* name, glm::mat4 proj);
+	static bool CheckCompileStatus(unsigned int id, unsigned int type);
+	//false if the file or one of its includes can't be read
+	static bool LoadDefaultPermutation(const std::string& filepath, ShaderProgramSource& source);
 };
\ No newline at end of file
@@ -0,0 +1,275 @@
+#include "ShaderArchive.h"
+#include "Hash.h"
+#include "ShaderPreprocessor.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+	const uint32_t ArchiveMagic = 0x4B504853; //"SHPK"
+	const uint32_t ArchiveVersion = 1;
+
+	std::string JoinVariantSets(const std::vector<std::vector<std::string>>& sets)
+	{
+		std::string text;
+		for (size_t s = 0; s < sets.size(); s++) {
+			if (s > 0)
+				text += '\n';
+			for (size_t k = 0; k < sets[s].size(); k++)
+				text += (k > 0 ? " " : "") + sets[s][k];
+		}
+		return text;
+	}
+
+	std::vector<std::vector<std::string>> SplitVariantSets(const std::string& text)
+	{
+		std::vector<std::vector<std::string>> sets;
+		std::istringstream lines(text);
+		std::string line;
+		while (getline(lines, line)) {
+			std::istringstream words(line);
+			std::vector<std::string> set;
+			std::string word;
+			while (words >> word)
+				set.push_back(word);
+			if (!set.empty())
+				sets.push_back(set);
+		}
+		return sets;
+	}
+}
+
+const char* const ShaderArchive::DefaultPath = "res/shaders.pak";
+
+ShaderArchive::ShaderArchive()
+	: m_Files(nullptr), m_Entries(nullptr), m_FileCount(0),
+#ifdef _DEBUG
+	m_VerifyInputs(true)
+#else
+	m_VerifyInputs(false)
+#endif
+{
+}
+
+ShaderArchive& ShaderArchive::Get()
+{
+	static ShaderArchive archive;
+	return archive;
+}
+
+std::string ShaderArchive::NormalizePath(const std::string& path)
+{
+	std::string normalized = path;
+	std::replace(normalized.begin(), normalized.end(), '\\', '/');
+	return normalized;
+}
+
+uint64_t ShaderArchive::HashInputs(const std::vector<std::string>& dependencies)
+{
+	uint64_t hash = Fnv1a64Seed;
+	for (const std::string& path : dependencies) {
+		std::ifstream stream(path, std::ios::binary);
+		std::stringstream contents;
+		contents << stream.rdbuf();
+		hash = Fnv1a64(NormalizePath(path), hash);
+		hash = Fnv1a64(contents.str(), hash);
+	}
+	return hash;
+}
+
+bool ShaderArchive::Open(const std::string& path)
+{
+	Close();
+	if (!m_File.Open(path))
+		return false;
+
+	//Check every record stays inside the file once, lookups trust them afterwards
+	const unsigned char* data = m_File.GetData();
+	size_t size = m_File.GetSize();
+	const Header* header = (const Header*)data;
+	bool valid = size >= sizeof(Header) && header->Magic == ArchiveMagic && header->Version == ArchiveVersion
+		&& sizeof(Header) + (uint64_t)header->FileCount * sizeof(FileRecord) + (uint64_t)header->EntryCount * sizeof(EntryRecord) <= size;
+	if (valid) {
+		m_Files = (const FileRecord*)(data + sizeof(Header));
+		m_Entries = (const EntryRecord*)(m_Files + header->FileCount);
+		for (uint32_t i = 0; i < header->FileCount && valid; i++) {
+			const FileRecord& file = m_Files[i];
+			valid = (uint64_t)file.PathOffset + file.PathSize <= size && (uint64_t)file.VariantsOffset + file.VariantsSize <= size
+				&& (uint64_t)file.FirstEntry + file.EntryCount <= header->EntryCount;
+		}
+		for (uint32_t i = 0; i < header->EntryCount && valid; i++) {
+			const EntryRecord& entry = m_Entries[i];
+			valid = (uint64_t)entry.VertexOffset + entry.VertexSize <= size && (uint64_t)entry.FragmentOffset + entry.FragmentSize <= size;
+		}
+	}
+
+	if (!valid) {
+		Close();
+		return false;
+	}
+	m_FileCount = header->FileCount;
+	return true;
+}
+
+void ShaderArchive::Close()
+{
+	m_File.Close();
+	m_Verified.clear();
+	m_Files = nullptr;
+	m_Entries = nullptr;
+	m_FileCount = 0;
+}
+
+const ShaderArchive::FileRecord* ShaderArchive::FindFile(const std::string& path) const
+{
+	if (!IsOpen())
+		return nullptr;
+
+	std::string normalized = NormalizePath(path);
+	uint64_t hash = Fnv1a64(normalized);
+	const FileRecord* end = m_Files + m_FileCount;
+	const FileRecord* file = std::lower_bound(m_Files, end, hash,
+		[](const FileRecord& record, uint64_t value) { return record.PathHash < value; });
+	for (; file != end && file->PathHash == hash; file++)
+		if (GetString(file->PathOffset, file->PathSize) == normalized)
+			return file;
+	return nullptr;
+}
+
+const ShaderArchive::FileRecord* ShaderArchive::FindCurrentFile(const std::string& path) const
+{
+	const FileRecord* file = FindFile(path);
+	if (!file || !m_VerifyInputs)
+		return file;
+
+	auto verified = m_Verified.find(file);
+	if (verified == m_Verified.end()) {
+		//An archive shipped without its sources has nothing to compare against
+		bool current = true;
+		std::string cookedPath = GetString(file->PathOffset, file->PathSize);
+		ShaderFile loose;
+		if (std::ifstream(cookedPath) && ShaderPreprocessor::Load(cookedPath, loose)) {
+			current = HashInputs(loose.Dependencies) == file->InputHash;
+			if (!current)
+				std::cout << "[ShaderArchive] " << cookedPath << " changed since the cook, using the loose file" << std::endl;
+		}
+		verified = m_Verified.emplace(file, current).first;
+	}
+	return verified->second ? file : nullptr;
+}
+
+const ShaderArchive::EntryRecord* ShaderArchive::FindEntry(const FileRecord& file, uint64_t key) const
+{
+	const EntryRecord* begin = m_Entries + file.FirstEntry;
+	const EntryRecord* end = begin + file.EntryCount;
+	const EntryRecord* entry = std::lower_bound(begin, end, key,
+		[](const EntryRecord& record, uint64_t value) { return record.Key < value; });
+	return entry != end && entry->Key == key ? entry : nullptr;
+}
+
+std::string ShaderArchive::GetString(uint32_t offset, uint32_t size) const
+{
+	return std::string((const char*)m_File.GetData() + offset, size);
+}
+
+bool ShaderArchive::GetVariantSets(const std::string& path, std::vector<std::vector<std::string>>& sets) const
+{
+	const FileRecord* file = FindCurrentFile(path);
+	if (!file)
+		return false;
+	sets = SplitVariantSets(GetString(file->VariantsOffset, file->VariantsSize));
+	return true;
+}
+
+bool ShaderArchive::GetPermutation(const std::string& path, uint64_t key, ShaderProgramSource& source) const
+{
+	const FileRecord* file = FindCurrentFile(path);
+	const EntryRecord* entry = file ? FindEntry(*file, key) : nullptr;
+	if (!entry)
+		return false;
+	source.VertexSource = GetString(entry->VertexOffset, entry->VertexSize);
+	source.FragmentSource = GetString(entry->FragmentOffset, entry->FragmentSize);
+	return true;
+}
+
+bool ShaderArchive::GetCookedFile(const std::string& path, CookedFile& cooked) const
+{
+	const FileRecord* file = FindFile(path);
+	if (!file)
+		return false;
+
+	cooked.Path = NormalizePath(path);
+	cooked.InputHash = file->InputHash;
+	cooked.VariantSets = SplitVariantSets(GetString(file->VariantsOffset, file->VariantsSize));
+	cooked.Permutations.clear();
+	for (uint32_t i = 0; i < file->EntryCount; i++) {
+		const EntryRecord& entry = m_Entries[file->FirstEntry + i];
+		cooked.Permutations.push_back({ entry.Key, entry.SourceHash,
+			GetString(entry.VertexOffset, entry.VertexSize), GetString(entry.FragmentOffset, entry.FragmentSize) });
+	}
+	return true;
+}
+
+bool ShaderArchive::Write(const std::string& path, std::vector<CookedFile>& files)
+{
+	for (CookedFile& file : files) {
+		file.Path = NormalizePath(file.Path);
+		std::sort(file.Permutations.begin(), file.Permutations.end(),
+			[](const CookedPermutation& a, const CookedPermutation& b) { return a.Key < b.Key; });
+	}
+	std::sort(files.begin(), files.end(),
+		[](const CookedFile& a, const CookedFile& b) { return Fnv1a64(a.Path) < Fnv1a64(b.Path); });
+
+	Header header = { ArchiveMagic, ArchiveVersion, (uint32_t)files.size(), 0 };
+	for (const CookedFile& file : files)
+		header.EntryCount += (uint32_t)file.Permutations.size();
+
+	std::vector<FileRecord> fileRecords;
+	std::vector<EntryRecord> entryRecords;
+	std::string strings;
+	uint32_t stringBase = (uint32_t)(sizeof(Header) + header.FileCount * sizeof(FileRecord) + header.EntryCount * sizeof(EntryRecord));
+	auto addString = [&](const std::string& text, uint32_t& offset, uint32_t& size) {
+		offset = stringBase + (uint32_t)strings.size();
+		size = (uint32_t)text.size();
+		strings += text;
+	};
+
+	for (const CookedFile& file : files) {
+		FileRecord record = {};
+		record.PathHash = Fnv1a64(file.Path);
+		record.InputHash = file.InputHash;
+		addString(file.Path, record.PathOffset, record.PathSize);
+		addString(JoinVariantSets(file.VariantSets), record.VariantsOffset, record.VariantsSize);
+		record.FirstEntry = (uint32_t)entryRecords.size();
+		record.EntryCount = (uint32_t)file.Permutations.size();
+		fileRecords.push_back(record);
+
+		for (const CookedPermutation& permutation : file.Permutations) {
+			EntryRecord entry = {};
+			entry.Key = permutation.Key;
+			entry.SourceHash = permutation.SourceHash;
+			addString(permutation.VertexSource, entry.VertexOffset, entry.VertexSize);
+			addString(permutation.FragmentSource, entry.FragmentOffset, entry.FragmentSize);
+			entryRecords.push_back(entry);
+		}
+	}
+
+	//Written next to the target and swapped in, a failed cook never leaves half an archive
+	std::string temporary = path + ".tmp";
+	{
+		std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+		if (!stream)
+			return false;
+		stream.write((const char*)&header, sizeof(header));
+		stream.write((const char*)fileRecords.data(), fileRecords.size() * sizeof(FileRecord));
+		stream.write((const char*)entryRecords.data(), entryRecords.size() * sizeof(EntryRecord));
+		stream.write(strings.data(), strings.size());
+		if (!stream)
+			return false;
+	}
+	std::remove(path.c_str());
+	return std::rename(temporary.c_str(), path.c_str()) == 0;
+}
\ No newline at end of file
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "MappedFile.h"
+#include "Shader.h"
+
+//One permutation as the cooker produces it
+struct CookedPermutation {
+	uint64_t Key;
+	uint64_t SourceHash;
+	std::string VertexSource;
+	std::string FragmentSource;
+};
+
+struct CookedFile {
+	std::string Path;
+	uint64_t InputHash; //contents of the file and all its includes
+	std::vector<std::vector<std::string>> VariantSets;
+	std::vector<CookedPermutation> Permutations;
+};
+
+//Preprocessed sources of every permutation of every .shader file, written by `--cook-shaders`
+//and mapped at startup. Lookups are binary searches over fixed size records, sources are
+//read straight out of the mapping.
+//Layout: Header, FileRecord[FileCount] sorted by path hash, EntryRecord[EntryCount] grouped
+//by file and sorted by key, then the string data. Offsets are from the start of the file.
+//With input verification on (the default in _DEBUG builds) the first lookup of a file
+//preprocesses its loose source and compares the input hash; an edited file is then read
+//from disk instead of the stale archive until the next cook.
+class ShaderArchive {
+public:
+	static const char* const DefaultPath;
+
+	struct Header {
+		uint32_t Magic;
+		uint32_t Version;
+		uint32_t FileCount;
+		uint32_t EntryCount;
+	};
+
+	struct FileRecord {
+		uint64_t PathHash;
+		uint64_t InputHash;
+		uint32_t PathOffset, PathSize;
+		uint32_t VariantsOffset, VariantsSize; //sets split by '\n', keywords by ' '
+		uint32_t FirstEntry, EntryCount;
+	};
+
+	struct EntryRecord {
+		uint64_t Key;
+		uint64_t SourceHash;
+		uint32_t VertexOffset, VertexSize;
+		uint32_t FragmentOffset, FragmentSize;
+	};
+
+private:
+	MappedFile m_File;
+	const FileRecord* m_Files;
+	const EntryRecord* m_Entries;
+	uint32_t m_FileCount;
+
+	bool m_VerifyInputs;
+	//File record to whether it still matches the loose files, filled on first lookup
+	mutable std::unordered_map<const FileRecord*, bool> m_Verified;
+
+public:
+	ShaderArchive();
+
+	//Archive Shader and ShaderVariants look in before touching .shader files
+	static ShaderArchive& Get();
+
+	bool Open(const std::string& path);
+	void Close();
+	inline bool IsOpen() const { return m_File.IsOpen(); }
+	inline void SetVerifyInputs(bool verify) { m_VerifyInputs = verify; m_Verified.clear(); }
+
+	const FileRecord* FindFile(const std::string& path) const;
+	const EntryRecord* FindEntry(const FileRecord& file, uint64_t key) const;
+	std::string GetString(uint32_t offset, uint32_t size) const;
+
+	bool GetVariantSets(const std::string& path, std::vector<std::vector<std::string>>& sets) const;
+	bool GetPermutation(const std::string& path, uint64_t key, ShaderProgramSource& source) const;
+	//Everything stored for one file, the cooker reuses it when the inputs didn't change
+	bool GetCookedFile(const std::string& path, CookedFile& file) const;
+
+	static bool Write(const std::string& path, std::vector<CookedFile>& files);
+	static std::string NormalizePath(const std::string& path);
+	//Paths and contents of a file and its includes, as stored in FileRecord::InputHash
+	static uint64_t HashInputs(const std::vector<std::string>& dependencies);
+
+private:
+	//FindFile, skipping files whose sources changed since the cook when verifying
+	const FileRecord* FindCurrentFile(const std::string& path) const;
+};
\ No newline at end of file
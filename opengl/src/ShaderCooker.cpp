@@ -0,0 +1,127 @@
+#include "ShaderCooker.h"
+#include "ShaderArchive.h"
+#include "ShaderPreprocessor.h"
+#include "ProgramBinaryCache.h"
+#include "JobSystem.h"
+#include "Hash.h"
+#include "FileList.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace {
+	//Permutation that has to be preprocessed this run
+	struct CookJob {
+		unsigned int File;
+		uint64_t Key;
+		CookedPermutation Result;
+		bool NeedsCompile;
+	};
+}
+
+int CookShaders(const std::string& directory, const std::string& archivePath)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	std::vector<std::string> paths = ListFiles(directory, ".shader");
+	if (paths.empty()) {
+		std::cout << "[cook] no .shader files in " << directory << std::endl;
+		return 1;
+	}
+
+	ShaderArchive previous;
+	previous.Open(archivePath);
+
+	std::vector<CookedFile> files(paths.size());
+	std::vector<ShaderFile> sources(paths.size());
+	std::vector<CookJob> jobs;
+	unsigned int reusedFiles = 0, reusedPermutations = 0;
+
+	for (unsigned int i = 0; i < paths.size(); i++) {
+		if (!ShaderPreprocessor::Load(paths[i], sources[i]))
+			return 1;
+
+		CookedFile& file = files[i];
+		uint64_t inputHash = ShaderArchive::HashInputs(sources[i].Dependencies);
+		if (previous.GetCookedFile(paths[i], file) && file.InputHash == inputHash) {
+			reusedFiles++;
+			reusedPermutations += (unsigned int)file.Permutations.size();
+			continue;
+		}
+
+		file.Path = paths[i];
+		file.InputHash = inputHash;
+		file.VariantSets = sources[i].VariantSets;
+		file.Permutations.clear();
+		for (uint64_t key = 0; key < ShaderPreprocessor::GetPermutationCount(sources[i]); key++)
+			jobs.push_back({ i, key, {}, true });
+	}
+
+	//Preprocess on every core. A permutation whose output matches the previous archive
+	//was already validated and skips the compile.
+	JobSystem& jobSystem = JobSystem::Get();
+	jobSystem.ParallelFor((unsigned int)jobs.size(), 4, [&](unsigned int begin, unsigned int end) {
+		for (unsigned int j = begin; j < end; j++) {
+			CookJob& job = jobs[j];
+			ShaderProgramSource source = ShaderPreprocessor::MakePermutation(sources[job.File], job.Key);
+			job.Result = { job.Key, Fnv1a64(source.FragmentSource, Fnv1a64(source.VertexSource)), source.VertexSource, source.FragmentSource };
+
+			const ShaderArchive::FileRecord* old = previous.FindFile(paths[job.File]);
+			const ShaderArchive::EntryRecord* entry = old ? previous.FindEntry(*old, job.Key) : nullptr;
+			job.NeedsCompile = !entry || entry->SourceHash != job.Result.SourceHash;
+		}
+	});
+	previous.Close();
+
+	//Compile everything that changed at once, the driver spreads it over its own threads
+	//when it has parallel shader compile
+	ProgramBinaryCache::Get().SetEnabled(false);
+	std::vector<std::unique_ptr<Shader>> shaders(jobs.size());
+	unsigned int compiled = 0;
+	for (unsigned int j = 0; j < jobs.size(); j++) {
+		if (!jobs[j].NeedsCompile)
+			continue;
+		shaders[j] = std::make_unique<Shader>();
+		shaders[j]->CreateShaderFromSource({ jobs[j].Result.VertexSource, jobs[j].Result.FragmentSource }, true);
+		compiled++;
+	}
+	while (Shader::PollBuilds() > 0)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+	unsigned int failed = 0;
+	for (unsigned int j = 0; j < jobs.size(); j++) {
+		if (shaders[j] && !shaders[j]->IsReady()) {
+			std::cout << "[cook] " << paths[jobs[j].File] << " permutation " << jobs[j].Key << " failed:";
+			for (const std::string& keyword : ShaderPreprocessor::GetKeywords(sources[jobs[j].File], jobs[j].Key))
+				std::cout << " " << keyword;
+			std::cout << std::endl;
+			failed++;
+		}
+		files[jobs[j].File].Permutations.push_back(std::move(jobs[j].Result));
+	}
+	if (failed > 0) {
+		std::cout << "[cook] " << failed << " permutations failed, archive not written" << std::endl;
+		return 1;
+	}
+
+	unsigned int total = 0;
+	for (const CookedFile& file : files)
+		total += (unsigned int)file.Permutations.size();
+
+	if (!ShaderArchive::Write(archivePath, files)) {
+		std::cout << "[cook] failed to write " << archivePath << std::endl;
+		return 1;
+	}
+
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	std::cout << "[cook] " << archivePath << ": " << files.size() << " files (" << reusedFiles << " unchanged), "
+		<< total << " permutations (" << reusedPermutations + (unsigned int)jobs.size() - compiled << " reused, "
+		<< compiled << " compiled), " << ms << " ms on " << jobSystem.GetWorkerCount() + 1 << " threads" << std::endl;
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <string>
+
+//`opengl --cook-shaders [directory] [archive]`: preprocesses every permutation of every .shader
+//in directory on all cores, compiles the ones whose source changed to validate them, and writes
+//the ShaderArchive. Files whose inputs are unchanged since the last cook are copied over as is.
+//Needs a current GL context. Returns the process exit code.
+int CookShaders(const std::string& directory, const std::string& archivePath);
\ No newline at end of file
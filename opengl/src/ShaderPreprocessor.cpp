@@ -0,0 +1,204 @@
+#include "ShaderPreprocessor.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+	std::string GetDirectory(const std::string& path)
+	{
+		size_t slash = path.find_last_of("/\\");
+		return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+	}
+
+	//Splits a preprocessor line into words, empty if the line isn't a directive
+	std::vector<std::string> ParseDirective(const std::string& line)
+	{
+		std::vector<std::string> words;
+		size_t start = line.find_first_not_of(" \t");
+		if (start == std::string::npos || line[start] != '#')
+			return words;
+
+		std::istringstream stream(line.substr(start + 1));
+		std::string word;
+		while (stream >> word)
+			words.push_back(word);
+		return words;
+	}
+}
+
+bool ShaderPreprocessor::Load(const std::string& filepath, ShaderFile& file)
+{
+	file = ShaderFile();
+	file.Dependencies.push_back(filepath);
+
+	std::ifstream stream(filepath);
+	if (!stream) {
+		std::cout << "Failed to open shader " << filepath << std::endl;
+		return false;
+	}
+
+	enum class Stage { NONE = -1, VERTEX = 0, FRAGMENT = 1 };
+	Stage stage = Stage::NONE;
+	std::string sources[2];
+	std::vector<std::string> included;
+	int lineNumber = 0;
+
+	std::string line;
+	while (getline(stream, line)) {
+		std::vector<std::string> words = ParseDirective(line);
+		if (!words.empty() && words[0] == "shader") {
+			if (line.find("vertex") != std::string::npos)
+				stage = Stage::VERTEX;
+			else if (line.find("fragment") != std::string::npos)
+				stage = Stage::FRAGMENT;
+			//Each stage is its own compile unit
+			included.clear();
+			lineNumber = 0;
+			continue;
+		}
+		lineNumber++;
+		if (stage == Stage::NONE)
+			continue;
+		if (!ProcessLine(filepath, line, lineNumber, 0, included, file, sources[(int)stage]))
+			return false;
+	}
+
+	file.Source = { sources[0], sources[1] };
+	return true;
+}
+
+bool ShaderPreprocessor::Expand(const std::string& filepath, int depth, std::vector<std::string>& included,
+	ShaderFile& file, std::string& out)
+{
+	if (depth > MaxIncludeDepth) {
+		std::cout << "Include depth over " << MaxIncludeDepth << " at " << filepath << ", recursive include?" << std::endl;
+		return false;
+	}
+
+	std::ifstream stream(filepath);
+	if (!stream) {
+		std::cout << "Failed to open include " << filepath << std::endl;
+		return false;
+	}
+	if (std::find(file.Dependencies.begin(), file.Dependencies.end(), filepath) == file.Dependencies.end())
+		file.Dependencies.push_back(filepath);
+
+	out += "#line 1\n";
+	int lineNumber = 0;
+	std::string line;
+	while (getline(stream, line)) {
+		lineNumber++;
+		if (!ProcessLine(filepath, line, lineNumber, depth, included, file, out))
+			return false;
+	}
+	return true;
+}
+
+bool ShaderPreprocessor::ProcessLine(const std::string& filepath, const std::string& line, int lineNumber, int depth,
+	std::vector<std::string>& included, ShaderFile& file, std::string& out)
+{
+	std::vector<std::string> words = ParseDirective(line);
+
+	if (!words.empty() && words[0] == "include") {
+		size_t open = line.find('"');
+		size_t close = open == std::string::npos ? std::string::npos : line.find('"', open + 1);
+		if (close == std::string::npos) {
+			std::cout << filepath << "(" << lineNumber << "): malformed #include" << std::endl;
+			return false;
+		}
+
+		std::string path = GetDirectory(filepath) + line.substr(open + 1, close - open - 1);
+		if (std::find(included.begin(), included.end(), path) == included.end()) {
+			included.push_back(path);
+			if (!Expand(path, depth + 1, included, file, out))
+				return false;
+			//Keep compiler messages pointing at the right line of this file
+			out += "#line " + std::to_string(lineNumber + 1) + "\n";
+		}
+		return true;
+	}
+
+	if (words.size() >= 3 && words[0] == "pragma" && words[1] == "variant") {
+		std::vector<std::string> keywords(words.begin() + 2, words.end());
+		if (std::find(file.VariantSets.begin(), file.VariantSets.end(), keywords) == file.VariantSets.end())
+			file.VariantSets.push_back(keywords);
+		out += "\n";
+		return true;
+	}
+
+	out += line;
+	out += "\n";
+	return true;
+}
+
+std::string ShaderPreprocessor::InjectDefines(const std::string& source, const std::vector<std::string>& defines)
+{
+	if (defines.empty())
+		return source;
+
+	std::string block;
+	for (const std::string& define : defines)
+		block += "#define " + define + "\n";
+
+	size_t version = source.find("#version");
+	if (version == std::string::npos)
+		return block + source;
+	size_t lineEnd = source.find('\n', version);
+	if (lineEnd == std::string::npos)
+		return source + "\n" + block;
+	//Line numbers after the defines stay those of the file
+	int nextLine = (int)std::count(source.begin(), source.begin() + lineEnd, '\n') + 2;
+	block += "#line " + std::to_string(nextLine) + "\n";
+	return source.substr(0, lineEnd + 1) + block + source.substr(lineEnd + 1);
+}
+
+uint64_t ShaderPreprocessor::GetPermutationCount(const ShaderFile& file)
+{
+	uint64_t count = 1;
+	for (const std::vector<std::string>& set : file.VariantSets)
+		count *= set.size();
+	return count;
+}
+
+uint64_t ShaderPreprocessor::MakeKey(const ShaderFile& file, const std::vector<std::string>& keywords)
+{
+	for (const std::string& keyword : keywords) {
+		bool known = false;
+		for (const std::vector<std::string>& set : file.VariantSets)
+			known |= std::find(set.begin(), set.end(), keyword) != set.end();
+		if (!known)
+			std::cout << "Warning: shader keyword " << keyword << " isn't declared by any #pragma variant" << std::endl;
+	}
+
+	uint64_t key = 0, radix = 1;
+	for (const std::vector<std::string>& set : file.VariantSets) {
+		uint64_t digit = 0;
+		for (size_t i = 0; i < set.size(); i++)
+			if (std::find(keywords.begin(), keywords.end(), set[i]) != keywords.end())
+				digit = i;
+		key += digit * radix;
+		radix *= set.size();
+	}
+	return key;
+}
+
+std::vector<std::string> ShaderPreprocessor::GetKeywords(const ShaderFile& file, uint64_t key)
+{
+	std::vector<std::string> keywords;
+	for (const std::vector<std::string>& set : file.VariantSets) {
+		const std::string& keyword = set[key % set.size()];
+		key /= set.size();
+		if (keyword != "_")
+			keywords.push_back(keyword);
+	}
+	return keywords;
+}
+
+ShaderProgramSource ShaderPreprocessor::MakePermutation(const ShaderFile& file, uint64_t key, const std::vector<std::string>& defines)
+{
+	std::vector<std::string> all = GetKeywords(file, key);
+	all.insert(all.end(), defines.begin(), defines.end());
+	return { InjectDefines(file.Source.VertexSource, all), InjectDefines(file.Source.FragmentSource, all) };
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Shader.h"
+
+//A .shader file with includes resolved and variant pragmas collected
+struct ShaderFile {
+	ShaderProgramSource Source;
+	//One entry per `#pragma variant`, exactly one keyword of each set is defined.
+	//"_" stands for "none of them".
+	std::vector<std::vector<std::string>> VariantSets;
+	//The file itself and every include, in the order they were read
+	std::vector<std::string> Dependencies;
+};
+
+//Expands the .shader format:
+//  #shader vertex|fragment        starts a stage
+//  #include "file"                relative to the including file, once per stage
+//  #pragma variant _ A B          keyword set, one permutation per combination
+class ShaderPreprocessor {
+public:
+	static const int MaxIncludeDepth = 16;
+
+	//false (and a message) if the file or one of its includes can't be read
+	static bool Load(const std::string& filepath, ShaderFile& file);
+
+	//Adds `#define` lines right after #version
+	static std::string InjectDefines(const std::string& source, const std::vector<std::string>& defines);
+
+	//Permutation keys: mixed radix over the variant sets, digit i = keyword index in set i.
+	//Key 0 is the first keyword of every set.
+	static uint64_t GetPermutationCount(const ShaderFile& file);
+	static uint64_t MakeKey(const ShaderFile& file, const std::vector<std::string>& keywords);
+	static std::vector<std::string> GetKeywords(const ShaderFile& file, uint64_t key);
+	//Sources of one permutation, keywords and extra defines injected
+	static ShaderProgramSource MakePermutation(const ShaderFile& file, uint64_t key, const std::vector<std::string>& defines = {});
+
+private:
+	static bool Expand(const std::string& filepath, int depth, std::vector<std::string>& included,
+		ShaderFile& file, std::string& out);
+	static bool ProcessLine(const std::string& filepath, const std::string& line, int lineNumber, int depth,
+		std::vector<std::string>& included, ShaderFile& file, std::string& out);
+};
\ No newline at end of file
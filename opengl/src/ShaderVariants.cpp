@@ -0,0 +1,51 @@
+#include "ShaderVariants.h"
+#include "ShaderArchive.h"
+
+#include <iostream>
+
+
+ShaderVariants::ShaderVariants(const std::string& filepath, const std::vector<std::string>& defines /*= {}*/, bool async /*= false*/)
+	: m_FilePath(filepath), m_Defines(defines), m_Async(async), m_Loaded(false), m_Failed(false)
+{
+	//Cooked permutations have no extra defines, those need the real file
+	if (!m_Defines.empty() || !ShaderArchive::Get().GetVariantSets(filepath, m_File.VariantSets))
+		Load();
+}
+
+bool ShaderVariants::Load()
+{
+	m_File = ShaderFile();
+	m_Failed = !ShaderPreprocessor::Load(m_FilePath, m_File);
+	m_Loaded = true;
+	return !m_Failed;
+}
+
+Shader& ShaderVariants::Get(uint64_t key)
+{
+	if (m_Failed)
+		return Shader::GetPlaceholder();
+
+	auto it = m_Permutations.find(key);
+	if (it != m_Permutations.end())
+		return *it->second;
+
+	if (key >= GetPermutationCount()) {
+		std::cout << "Warning: permutation " << key << " of " << m_FilePath << " out of range" << std::endl;
+		return Get(0);
+	}
+
+	ShaderProgramSource source;
+	if (m_Loaded || !ShaderArchive::Get().GetPermutation(m_FilePath, key, source)) {
+		if (!m_Loaded && !Load()) {
+			std::cout << "Warning: " << m_FilePath << " failed to load, permutation " << key << " uses the placeholder" << std::endl;
+			return Shader::GetPlaceholder();
+		}
+		source = ShaderPreprocessor::MakePermutation(m_File, key, m_Defines);
+	}
+
+	std::unique_ptr<Shader> shader = std::make_unique<Shader>();
+	shader->CreateShaderFromSource(source, m_Async);
+	Shader& result = *shader;
+	m_Permutations.emplace(key, std::move(shader));
+	return result;
+}
\ No newline at end of file
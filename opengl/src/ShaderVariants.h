@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Shader.h"
+#include "ShaderPreprocessor.h"
+
+//All permutations of one .shader file. Nothing is compiled up front: a permutation is built the
+//first time it's asked for and kept under its 64-bit key, so only variants actually drawn cost anything.
+class ShaderVariants {
+private:
+	std::string m_FilePath;
+	ShaderFile m_File;
+	std::vector<std::string> m_Defines;
+	bool m_Async;
+	//Variant sets came from the ShaderArchive, the file itself is only read if a permutation is missing
+	bool m_Loaded;
+	//The file or one of its includes could not be read, every Get returns the placeholder
+	bool m_Failed;
+	std::unordered_map<uint64_t, std::unique_ptr<Shader>> m_Permutations;
+
+public:
+	//defines ("NAME" or "NAME VALUE") go into every permutation. With async, new permutations
+	//build in the background and draw with the placeholder until ready.
+	ShaderVariants(const std::string& filepath, const std::vector<std::string>& defines = {}, bool async = false);
+
+	ShaderVariants(const ShaderVariants&) = delete;
+	ShaderVariants& operator=(const ShaderVariants&) = delete;
+
+	inline uint64_t MakeKey(const std::vector<std::string>& keywords) const { return ShaderPreprocessor::MakeKey(m_File, keywords); }
+	Shader& Get(uint64_t key);
+	inline Shader& Get(const std::vector<std::string>& keywords) { return Get(MakeKey(keywords)); }
+
+	inline unsigned int GetCompiledCount() const { return (unsigned int)m_Permutations.size(); }
+	inline uint64_t GetPermutationCount() const { return ShaderPreprocessor::GetPermutationCount(m_File); }
+	inline const ShaderFile& GetFile() const { return m_File; }
+	inline bool IsValid() const { return !m_Failed; }
+
+private:
+	bool Load();
+};
\ No newline at end of file
@@ -0,0 +1,16 @@
+#pragma once
+
+//Instruction sets the compiler may emit. Same checks as glm/simd/platform.h does under
+//GLM_FORCE_INTRINSICS, without switching glm itself over to intrinsics.
+#if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+#define SIMD_AVX2 1
+#endif
+
+#if defined(__SSE4_1__) || defined(__AVX__)
+#define SIMD_SSE41 1
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD_SSE2 1
+#include <immintrin.h>
+#endif
\ No newline at end of file
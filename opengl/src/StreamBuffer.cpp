@@ -0,0 +1,123 @@
+#include "StreamBuffer.h"
+#include "Debug.h"
+#include "GLState.h"
+
+#include <chrono>
+
+StreamBuffer::StreamBuffer(unsigned int target, unsigned int frameSize, unsigned int frameCount /*= 3*/)
+	:m_Target(target), m_FrameSize(frameSize), m_FrameCount(frameCount), m_Mapped(nullptr),
+	m_Frame(0), m_Head(0), m_Flushed(0)
+{
+	if (m_FrameCount > MaxFrames)
+		m_FrameCount = MaxFrames;
+	for (GLsync& fence : m_Fences)
+		fence = nullptr;
+
+	unsigned int size = m_FrameSize * m_FrameCount;
+	GLCall(glGenBuffers(1, &m_RendererID));
+	Bind();
+
+	if (GLEW_ARB_buffer_storage) {
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		GLCall(glBufferStorage(m_Target, size, nullptr, flags));
+		GLCall(m_Mapped = (unsigned char*)glMapBufferRange(m_Target, 0, size, flags));
+	}
+	else {
+		GLCall(glBufferData(m_Target, size, nullptr, GL_STREAM_DRAW));
+		m_Staging.reset(new unsigned char[size]);
+	}
+}
+
+StreamBuffer::~StreamBuffer()
+{
+	for (GLsync fence : m_Fences) {
+		if (fence)
+			glDeleteSync(fence);
+	}
+	if (m_Mapped) {
+		Bind();
+		GLCall(glUnmapBuffer(m_Target));
+	}
+	GLState::Get().OnDeleteBuffer(m_RendererID);
+	GLCall(glDeleteBuffers(1, &m_RendererID));
+}
+
+StreamAllocation StreamBuffer::Allocate(unsigned int size, unsigned int alignment /*= 4*/)
+{
+	if (size > m_FrameSize)
+		return { nullptr, 0, 0 };
+
+	unsigned int regionEnd = (m_Frame + 1) * m_FrameSize;
+	unsigned int offset = (m_Head + alignment - 1) / alignment * alignment;
+	if (offset + size > regionEnd) {
+		m_Stats.Overflows++;
+		Flush();
+		NextRegion();
+		offset = (m_Head + alignment - 1) / alignment * alignment;
+	}
+
+	m_Head = offset + size;
+	m_Stats.Allocations++;
+	m_Stats.BytesAllocated += size;
+
+	unsigned char* base = m_Mapped ? m_Mapped : m_Staging.get();
+	return { base + offset, offset, size };
+}
+
+void StreamBuffer::Flush()
+{
+	//Coherent persistent mappings need no explicit flush
+	if (m_Mapped || m_Flushed >= m_Head)
+		return;
+
+	Bind();
+	GLCall(glBufferSubData(m_Target, m_Flushed, m_Head - m_Flushed, m_Staging.get() + m_Flushed));
+	m_Flushed = m_Head;
+}
+
+void StreamBuffer::EndFrame()
+{
+	Flush();
+	NextRegion();
+}
+
+void StreamBuffer::NextRegion()
+{
+	if (m_Fences[m_Frame])
+		glDeleteSync(m_Fences[m_Frame]);
+	m_Fences[m_Frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	m_Frame = (m_Frame + 1) % m_FrameCount;
+	m_Head = m_Frame * m_FrameSize;
+	m_Flushed = m_Head;
+
+	GLsync fence = m_Fences[m_Frame];
+	if (!fence)
+		return;
+
+	GLenum result = glClientWaitSync(fence, 0, 0);
+	if (result == GL_TIMEOUT_EXPIRED) {
+		m_Stats.FenceWaits++;
+		auto start = std::chrono::high_resolution_clock::now();
+		do {
+			result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+		} while (result == GL_TIMEOUT_EXPIRED);
+		m_Stats.FenceWaitMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	glDeleteSync(fence);
+	m_Fences[m_Frame] = nullptr;
+}
+
+void StreamBuffer::Bind() const
+{
+	if (m_Target == GL_ELEMENT_ARRAY_BUFFER)
+		GLState::Get().BindElementBuffer(m_RendererID);
+	else
+		GLCall(glBindBuffer(m_Target, m_RendererID));
+}
+
+void StreamBuffer::BindRange(unsigned int index, const StreamAllocation& allocation) const
+{
+	GLCall(glBindBufferRange(m_Target, index, m_RendererID, allocation.Offset, allocation.Size));
+}
\ No newline at end of file
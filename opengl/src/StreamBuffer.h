@@ -0,0 +1,67 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <memory>
+
+struct StreamAllocation {
+	void* Data;          //write pointer, valid until Flush
+	unsigned int Offset; //byte offset inside the GL buffer
+	unsigned int Size;
+};
+
+struct StreamBufferStats {
+	unsigned int Allocations = 0;
+	unsigned long long BytesAllocated = 0;
+	//Region was still in use by the GPU when the CPU came back to it
+	unsigned int FenceWaits = 0;
+	double FenceWaitMs = 0.0;
+	//Region ran out mid frame and the next one was taken early
+	unsigned int Overflows = 0;
+};
+
+//Ring of frame regions inside one buffer. With ARB_buffer_storage the storage is immutable and
+//mapped persistent + coherent, so allocating is pointer arithmetic; each region is guarded by
+//a fence placed at EndFrame. Without it, data is staged on the CPU and uploaded by Flush.
+class StreamBuffer {
+public:
+	static const unsigned int MaxFrames = 4;
+
+private:
+	unsigned int m_RendererID;
+	unsigned int m_Target;
+	unsigned int m_FrameSize;
+	unsigned int m_FrameCount;
+
+	unsigned char* m_Mapped;
+	std::unique_ptr<unsigned char[]> m_Staging;
+
+	unsigned int m_Frame;
+	unsigned int m_Head;    //absolute offset of the next free byte
+	unsigned int m_Flushed; //fallback: first byte not uploaded yet
+	GLsync m_Fences[MaxFrames];
+
+	StreamBufferStats m_Stats;
+
+public:
+	StreamBuffer(unsigned int target, unsigned int frameSize, unsigned int frameCount = 3);
+	~StreamBuffer();
+
+	StreamAllocation Allocate(unsigned int size, unsigned int alignment = 4);
+	//Makes written allocations visible to GL, call before drawing from them
+	void Flush();
+	//Fences the current region and moves on to the next one
+	void EndFrame();
+
+	void Bind() const;
+	//Binds an allocation to an indexed target (GL_UNIFORM_BUFFER)
+	void BindRange(unsigned int index, const StreamAllocation& allocation) const;
+
+	inline bool IsPersistent() const { return m_Mapped != nullptr; }
+	inline unsigned int GetRendererID() const { return m_RendererID; }
+	inline unsigned int GetFrameSize() const { return m_FrameSize; }
+	inline const StreamBufferStats& GetStats() const { return m_Stats; }
+	inline void ResetStats() { m_Stats = StreamBufferStats(); }
+
+private:
+	void NextRegion();
+};
\ No newline at end of file
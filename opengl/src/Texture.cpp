@@ -1,42 +1,412 @@
 #include "Texture.h"
 #include "Debug.h"
+#include "GLState.h"
+#include "JobSystem.h"
+#include "BlockCompressor.h"
+#include "TextureFile.h"
+#include "TextureLoader.h"
 #include "vendor/stb_image/stb_image.h"
 #include "GL/glew.h"
 
-Texture::Texture(const std::string& path)
-	:m_FilePath(path),m_LocalBuffer(nullptr),m_Heigh(0),m_Width(0),m_BPP(0)
+#include <algorithm>
+
+namespace {
+	bool IsCompressedFormat(unsigned int internalFormat)
+	{
+		return internalFormat != GL_RGBA8 && internalFormat != GL_SRGB8_ALPHA8;
+	}
+
+	size_t GetImageSize(unsigned int internalFormat, int width, int height)
+	{
+		switch (internalFormat) {
+			case GL_RGBA8:
+			case GL_SRGB8_ALPHA8:
+				return (size_t)width * height * 4;
+			case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+			case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+			case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+			case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+			case GL_COMPRESSED_RED_RGTC1:
+			case GL_COMPRESSED_SIGNED_RED_RGTC1:
+				return (size_t)((width + 3) / 4) * ((height + 3) / 4) * 8;
+		}
+		return (size_t)((width + 3) / 4) * ((height + 3) / 4) * 16;
+	}
+}
+
+unsigned int Texture::s_Frame = 0;
+
+Texture::Texture(const std::string& path, const TextureOptions& options)
+	:m_FilePath(path),m_LocalBuffer(nullptr),m_Heigh(0),m_Width(0),m_BPP(0),m_Status(TextureStatus::Ready),m_Options(options),m_LevelCount(1),m_Target(GL_TEXTURE_2D),m_InternalFormat(GL_RGBA8),m_Layers(1),m_TopFirst(false),m_DroppedLevels(0),m_LastBound(0),m_ContentHash(0),m_ReloadFailed(false)
 {
+	GLCall(glGenTextures(1, &m_RendererID));
+	if (TextureFile::IsContainer(path)) {
+		TextureFile file;
+		if (file.Open(path))
+			UploadFile(file);
+		else
+			Upload(nullptr);
+		GLState::Get().BindTexture(m_Target, 0);
+		return;
+	}
+
 	stbi_set_flip_vertically_on_load(1);
 	m_LocalBuffer = stbi_load(path.c_str(), &m_Width, &m_Heigh, &m_BPP, 4);
+	Upload(m_LocalBuffer);
+	GLState::Get().BindTexture(GL_TEXTURE_2D, 0);
+
+	if (m_LocalBuffer) {
+		stbi_image_free(m_LocalBuffer);
+	}
+}
 
+Texture::Texture(int width, int height, const void* data, const TextureOptions& options)
+	:m_LocalBuffer(nullptr),m_Heigh(height),m_Width(width),m_BPP(4),m_Status(TextureStatus::Ready),m_Options(options),m_LevelCount(1),m_Target(GL_TEXTURE_2D),m_InternalFormat(GL_RGBA8),m_Layers(1),m_TopFirst(false),m_DroppedLevels(0),m_LastBound(0),m_ContentHash(0),m_ReloadFailed(false)
+{
 	GLCall(glGenTextures(1, &m_RendererID));
-	GLCall(glBindTexture(GL_TEXTURE_2D, m_RendererID));
+	Upload(data);
+	GLState::Get().BindTexture(GL_TEXTURE_2D, 0);
+}
 
-	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
-	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
-	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
-	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+Texture::Texture(const CompressedImage& image, const TextureOptions& options)
+	:m_LocalBuffer(nullptr),m_Heigh(image.Height),m_Width(image.Width),m_BPP(0),m_Status(TextureStatus::Ready),m_Options(options),
+	m_LevelCount((unsigned int)image.Levels.size()),m_Target(GL_TEXTURE_2D),m_InternalFormat(GL_RGBA8),m_Layers(1),m_TopFirst(false),m_DroppedLevels(0),m_LastBound(0),m_ContentHash(0),m_ReloadFailed(false)
+{
+	m_Options.Mipmaps = m_LevelCount > 1;
+	m_Options.SRGB = image.SRGB;
+	m_TopFirst = image.TopFirst;
 
-	GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_Width, m_Heigh, 0, GL_RGBA, GL_UNSIGNED_BYTE,m_LocalBuffer));
-	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+	GLCall(glGenTextures(1, &m_RendererID));
+	GLState::Get().BindTexture(GL_TEXTURE_2D, m_RendererID);
+	ApplySampler();
 
-	if (m_LocalBuffer) {
-		stbi_image_free(m_LocalBuffer);
+	bool supported = BlockCompressor::IsSupported(image.Format, image.SRGB);
+	m_InternalFormat = supported ? BlockCompressor::GetGLFormat(image.Format, image.SRGB) : GetRGBAFormat();
+	std::vector<unsigned char> decoded;
+	for (unsigned int level = 0; level < m_LevelCount; level++) {
+		int width = std::max(1, m_Width >> level), height = std::max(1, m_Heigh >> level);
+		const std::vector<unsigned char>& blocks = image.Levels[level];
+		if (supported) {
+			GLCall(glCompressedTexImage2D(GL_TEXTURE_2D, level, BlockCompressor::GetGLFormat(image.Format, image.SRGB),
+				width, height, 0, (GLsizei)blocks.size(), blocks.data()));
+		}
+		else {
+			decoded.resize((size_t)width * height * 4);
+			BlockCompressor::Decompress(image.Format, blocks.data(), width, height, decoded.data());
+			GLCall(glTexImage2D(GL_TEXTURE_2D, level, GetRGBAFormat(), width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, decoded.data()));
+		}
 	}
+	GLState::Get().BindTexture(GL_TEXTURE_2D, 0);
+}
+
+Texture::Texture(const TextureFile& file, const TextureOptions& options)
+	:m_FilePath(file.GetPath()),m_LocalBuffer(nullptr),m_Heigh(0),m_Width(0),m_BPP(0),m_Status(TextureStatus::Ready),m_Options(options),m_LevelCount(1),m_Target(GL_TEXTURE_2D),m_InternalFormat(GL_RGBA8),m_Layers(1),m_TopFirst(false),m_DroppedLevels(0),m_LastBound(0),m_ContentHash(0),m_ReloadFailed(false)
+{
+	GLCall(glGenTextures(1, &m_RendererID));
+	UploadFile(file);
+	GLState::Get().BindTexture(m_Target, 0);
+}
+
+Texture::Texture(TextureStatus status, const std::string& path, const TextureOptions& options)
+	:m_FilePath(path),m_LocalBuffer(nullptr),m_Heigh(0),m_Width(0),m_BPP(0),m_Status(status),m_Options(options),m_LevelCount(1),m_Target(GL_TEXTURE_2D),m_InternalFormat(GL_RGBA8),m_Layers(1),m_TopFirst(false),m_DroppedLevels(0),m_LastBound(0),m_ContentHash(0),m_ReloadFailed(false)
+{
+	GLCall(glGenTextures(1, &m_RendererID));
+	GLState::Get().BindTexture(GL_TEXTURE_2D, m_RendererID);
+	ApplySampler();
+	GLState::Get().BindTexture(GL_TEXTURE_2D, 0);
 }
 
 Texture::~Texture()
 {
+	GLState::Get().OnDeleteTexture(m_RendererID);
 	GLCall(glDeleteTextures(1, &m_RendererID));
 }
 
+void Texture::Upload(const void* pixels)
+{
+	std::vector<MipLevel> mips;
+	if (m_Options.Mipmaps && pixels)
+		mips = MipGenerator(m_Options.Filter, m_Options.SRGB).Generate((const unsigned char*)pixels, m_Width, m_Heigh, JobSystem::Get());
+	m_LevelCount = 1 + (unsigned int)mips.size();
+
+	m_InternalFormat = GetRGBAFormat();
+	GLState::Get().BindTexture(GL_TEXTURE_2D, m_RendererID);
+	ApplySampler();
+	GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GetRGBAFormat(), m_Width, m_Heigh, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels));
+	for (unsigned int level = 1; level < m_LevelCount; level++) {
+		const MipLevel& mip = mips[level - 1];
+		GLCall(glTexImage2D(GL_TEXTURE_2D, level, GetRGBAFormat(), mip.Width, mip.Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, mip.Pixels.data()));
+	}
+}
+
+void Texture::AllocateStorage(const TextureFile& file)
+{
+	const TextureFileFormat& format = file.GetFormat();
+	m_Target = file.GetTarget();
+	m_TopFirst = file.IsTopFirst();
+	m_Width = file.GetWidth();
+	m_Heigh = file.GetHeight();
+	m_BPP = format.Compressed ? 0 : format.BlockBytes;
+	m_LevelCount = file.GetLevelCount();
+	m_InternalFormat = format.InternalFormat;
+	m_Layers = file.GetLayerCount() * file.GetFaceCount();
+	m_Options.Mipmaps = m_LevelCount > 1;
+	m_Options.SRGB = format.SRGB;
+
+	GLState::Get().BindTexture(m_Target, m_RendererID);
+	ApplySampler();
+
+	if (GLEW_ARB_texture_storage) {
+		if (m_Target == GL_TEXTURE_2D_ARRAY) {
+			GLCall(glTexStorage3D(m_Target, m_LevelCount, format.InternalFormat, m_Width, m_Heigh, file.GetLayerCount()));
+		}
+		else {
+			GLCall(glTexStorage2D(m_Target, m_LevelCount, format.InternalFormat, m_Width, m_Heigh));
+		}
+		return;
+	}
+
+	//Without immutable storage every level of every face is specified empty first
+	for (unsigned int level = 0; level < m_LevelCount; level++) {
+		int width = std::max(1, m_Width >> level), height = std::max(1, m_Heigh >> level);
+		GLsizei size = (GLsizei)format.GetImageSize(width, height);
+		if (m_Target == GL_TEXTURE_2D_ARRAY) {
+			GLsizei layers = (GLsizei)file.GetLayerCount();
+			if (format.Compressed) {
+				GLCall(glCompressedTexImage3D(m_Target, level, format.InternalFormat, width, height, layers, 0, size * layers, nullptr));
+			}
+			else {
+				GLCall(glTexImage3D(m_Target, level, format.InternalFormat, width, height, layers, 0, format.Format, format.Type, nullptr));
+			}
+			continue;
+		}
+		for (unsigned int face = 0; face < file.GetFaceCount(); face++) {
+			GLenum target = m_Target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : GL_TEXTURE_2D;
+			if (format.Compressed) {
+				GLCall(glCompressedTexImage2D(target, level, format.InternalFormat, width, height, 0, size, nullptr));
+			}
+			else {
+				GLCall(glTexImage2D(target, level, format.InternalFormat, width, height, 0, format.Format, format.Type, nullptr));
+			}
+		}
+	}
+}
+
+void Texture::UploadImage(const TextureFile& file, const TextureFileImage& image, const void* data)
+{
+	const TextureFileFormat& format = file.GetFormat();
+	if (m_Target == GL_TEXTURE_2D_ARRAY) {
+		if (format.Compressed) {
+			GLCall(glCompressedTexSubImage3D(m_Target, image.Level, 0, 0, image.Layer, image.Width, image.Height, 1, format.InternalFormat, (GLsizei)image.Size, data));
+		}
+		else {
+			GLCall(glTexSubImage3D(m_Target, image.Level, 0, 0, image.Layer, image.Width, image.Height, 1, format.Format, format.Type, data));
+		}
+		return;
+	}
+
+	GLenum target = m_Target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + image.Face : GL_TEXTURE_2D;
+	if (format.Compressed) {
+		GLCall(glCompressedTexSubImage2D(target, image.Level, 0, 0, image.Width, image.Height, format.InternalFormat, (GLsizei)image.Size, data));
+	}
+	else {
+		GLCall(glTexSubImage2D(target, image.Level, 0, 0, image.Width, image.Height, format.Format, format.Type, data));
+	}
+}
+
+void Texture::UploadFile(const TextureFile& file)
+{
+	AllocateStorage(file);
+	for (const TextureFileImage& image : file.GetImages())
+		UploadImage(file, image, image.Data);
+}
+
+size_t Texture::GetLevelSize(unsigned int level) const
+{
+	if (level >= m_LevelCount || m_Width == 0)
+		return 0;
+	return GetImageSize(m_InternalFormat, std::max(1, m_Width >> level), std::max(1, m_Heigh >> level)) * m_Layers;
+}
+
+size_t Texture::GetMemorySize() const
+{
+	size_t size = 0;
+	for (unsigned int level = 0; level < m_LevelCount; level++)
+		size += GetLevelSize(level);
+	return size;
+}
+
+bool Texture::DropLevels(unsigned int count)
+{
+	if (m_Status != TextureStatus::Ready || m_Target != GL_TEXTURE_2D || m_LevelCount < 2)
+		return false;
+	count = std::min(count, m_LevelCount - 1);
+	unsigned int levels = m_LevelCount - count;
+	int width = std::max(1, m_Width >> count), height = std::max(1, m_Heigh >> count);
+	bool compressed = IsCompressedFormat(m_InternalFormat);
+
+	unsigned int id;
+	GLCall(glGenTextures(1, &id));
+	GLState::Get().BindTexture(GL_TEXTURE_2D, id);
+	if (GLEW_ARB_texture_storage) {
+		GLCall(glTexStorage2D(GL_TEXTURE_2D, levels, m_InternalFormat, width, height));
+	}
+	else {
+		for (unsigned int level = 0; level < levels; level++) {
+			int w = std::max(1, width >> level), h = std::max(1, height >> level);
+			if (compressed) {
+				GLCall(glCompressedTexImage2D(GL_TEXTURE_2D, level, m_InternalFormat, w, h, 0, (GLsizei)GetImageSize(m_InternalFormat, w, h), nullptr));
+			}
+			else {
+				GLCall(glTexImage2D(GL_TEXTURE_2D, level, m_InternalFormat, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+			}
+		}
+	}
+
+	//The remaining levels move down on the GPU, or through client memory without ARB_copy_image
+	std::vector<unsigned char> pixels;
+	for (unsigned int level = 0; level < levels; level++) {
+		int w = std::max(1, width >> level), h = std::max(1, height >> level);
+		if (GLEW_ARB_copy_image) {
+			GLCall(glCopyImageSubData(m_RendererID, GL_TEXTURE_2D, level + count, 0, 0, 0, id, GL_TEXTURE_2D, level, 0, 0, 0, w, h, 1));
+			continue;
+		}
+		size_t size = GetImageSize(m_InternalFormat, w, h);
+		pixels.resize(size);
+		GLState::Get().BindTexture(GL_TEXTURE_2D, m_RendererID);
+		if (compressed) {
+			GLCall(glGetCompressedTexImage(GL_TEXTURE_2D, level + count, pixels.data()));
+		}
+		else {
+			GLCall(glGetTexImage(GL_TEXTURE_2D, level + count, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data()));
+		}
+		GLState::Get().BindTexture(GL_TEXTURE_2D, id);
+		if (compressed) {
+			GLCall(glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, w, h, m_InternalFormat, (GLsizei)size, pixels.data()));
+		}
+		else {
+			GLCall(glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data()));
+		}
+	}
+
+	GLState::Get().OnDeleteTexture(m_RendererID);
+	GLCall(glDeleteTextures(1, &m_RendererID));
+	m_RendererID = id;
+	m_Width = width;
+	m_Heigh = height;
+	m_LevelCount = levels;
+	m_DroppedLevels += count;
+
+	GLState::Get().BindTexture(GL_TEXTURE_2D, m_RendererID);
+	ApplySampler();
+	GLState::Get().BindTexture(GL_TEXTURE_2D, 0);
+	return true;
+}
+
+bool Texture::Reload()
+{
+	if (m_DroppedLevels == 0 || m_FilePath.empty() || m_ReloadFailed)
+		return false;
+	if (!m_Reload) {
+		m_Reload = TextureLoader::Get().Load(m_FilePath, m_Options);
+		return false;
+	}
+	if (m_Reload->m_Status == TextureStatus::Loading)
+		return false;
+
+	std::shared_ptr<Texture> reloaded = std::move(m_Reload);
+	if (reloaded->m_Status == TextureStatus::Failed || reloaded->m_LevelCount <= m_LevelCount) {
+		m_ReloadFailed = true;
+		return false;
+	}
+
+	//Take over the new storage, the temporary deletes the old one
+	std::swap(m_RendererID, reloaded->m_RendererID);
+	std::swap(m_Width, reloaded->m_Width);
+	std::swap(m_Heigh, reloaded->m_Heigh);
+	std::swap(m_LevelCount, reloaded->m_LevelCount);
+	std::swap(m_InternalFormat, reloaded->m_InternalFormat);
+	std::swap(m_Target, reloaded->m_Target);
+	std::swap(m_Layers, reloaded->m_Layers);
+	std::swap(m_TopFirst, reloaded->m_TopFirst);
+	m_DroppedLevels = 0;
+	return true;
+}
+
+void Texture::SetSampler(bool trilinear, float anisotropy)
+{
+	m_Options.Trilinear = trilinear;
+	m_Options.Anisotropy = anisotropy;
+	GLState::Get().BindTexture(m_Target, m_RendererID);
+	ApplySampler();
+	GLState::Get().BindTexture(m_Target, 0);
+}
+
+void Texture::ApplySampler()
+{
+	//Without the full chain a mipmapped min filter would make the texture incomplete
+	bool mipmapped = m_Options.Mipmaps && m_LevelCount > 1;
+	GLenum minFilter = !mipmapped ? GL_LINEAR : (m_Options.Trilinear ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR_MIPMAP_NEAREST);
+	GLCall(glTexParameteri(m_Target, GL_TEXTURE_MIN_FILTER, minFilter));
+	GLCall(glTexParameteri(m_Target, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+	GLCall(glTexParameteri(m_Target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+	GLCall(glTexParameteri(m_Target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+	if (m_Target == GL_TEXTURE_CUBE_MAP)
+		GLCall(glTexParameteri(m_Target, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE));
+	GLCall(glTexParameteri(m_Target, GL_TEXTURE_MAX_LEVEL, m_LevelCount - 1));
+
+	if (GLEW_EXT_texture_filter_anisotropic) {
+		float anisotropy = std::min(std::max(m_Options.Anisotropy, 1.0f), GetMaxAnisotropy());
+		GLCall(glTexParameterf(m_Target, GL_TEXTURE_MAX_ANISOTROPY_EXT, anisotropy));
+	}
+}
+
+unsigned int Texture::GetRGBAFormat() const
+{
+	return m_Options.SRGB ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+}
+
+float Texture::GetMaxAnisotropy()
+{
+	static float s_MaxAnisotropy = 0.0f;
+	if (s_MaxAnisotropy == 0.0f) {
+		s_MaxAnisotropy = 1.0f;
+		if (GLEW_EXT_texture_filter_anisotropic)
+			GLCall(glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &s_MaxAnisotropy));
+	}
+	return s_MaxAnisotropy;
+}
+
 void Texture::Bind(unsigned int slot /*= 0*/) const
 {
-	GLCall(glActiveTexture(GL_TEXTURE0 + slot));
-	GLCall(glBindTexture(GL_TEXTURE_2D, m_RendererID));
+	m_LastBound = s_Frame;
+	if (m_Status == TextureStatus::Ready)
+		GLState::Get().BindTextureUnit(slot, m_Target, m_RendererID);
+	else
+		GLState::Get().BindTextureUnit(slot, GL_TEXTURE_2D, GetPlaceholder().m_RendererID);
 }
 
 void Texture::UnBind() const
 {
-	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+	GLState::Get().BindTexture(m_Target, 0);
+}
+
+const Texture& Texture::GetPlaceholder()
+{
+	//Never deleted, it has to outlive every texture that may fall back to it
+	static const Texture* s_Placeholder = nullptr;
+	if (!s_Placeholder) {
+		unsigned int pixels[8 * 8];
+		for (int y = 0; y < 8; y++)
+			for (int x = 0; x < 8; x++)
+				pixels[y * 8 + x] = ((x ^ y) & 1) ? 0xffff00ff : 0xff202020;
+		s_Placeholder = new Texture(8, 8, pixels);
+		GLState::Get().BindTexture(GL_TEXTURE_2D, s_Placeholder->m_RendererID);
+		GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+		GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+		GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT));
+		GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT));
+		GLState::Get().BindTexture(GL_TEXTURE_2D, 0);
+	}
+	return *s_Placeholder;
 }
\ No newline at end of file
@@ -1,6 +1,27 @@
 #pragma once
 #include "Debug.h"
+#include "MipGenerator.h"
 
+#include <cstdint>
+#include <memory>
+
+enum class TextureStatus { Loading, Ready, Failed };
+
+struct CompressedImage;
+class TextureFile;
+struct TextureFileImage;
+
+struct TextureOptions {
+	//Full chain generated on the CPU by MipGenerator
+	bool Mipmaps = false;
+	MipFilter Filter = MipFilter::Box;
+	//Pixels are sRGB encoded: mips are filtered in linear light and the GL format is sRGB
+	bool SRGB = false;
+	//Blend between the two nearest mip levels instead of snapping to one
+	bool Trilinear = true;
+	//Above 1 needs EXT_texture_filter_anisotropic, clamped to the driver maximum
+	float Anisotropy = 1.0f;
+};
 
 class Texture {
 private:
@@ -8,15 +29,101 @@ private:
 	std::string m_FilePath;
 	unsigned char* m_LocalBuffer;
 	int m_Width, m_Heigh, m_BPP;
+	TextureStatus m_Status;
+	TextureOptions m_Options;
+	unsigned int m_LevelCount;
+	//GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP or GL_TEXTURE_2D_ARRAY (containers only)
+	unsigned int m_Target;
+	unsigned int m_InternalFormat;
+	//Images per level: array layers times cube faces
+	unsigned int m_Layers;
+	//Rows stored top first (DDS/KTX2 files), V runs downwards and users flip it
+	bool m_TopFirst;
+	//Top levels given up by DropLevels, Reload brings them back
+	unsigned int m_DroppedLevels;
+	mutable unsigned int m_LastBound;
+	//Fnv1a64 of the file bytes, set by TextureLoader once decoded, 0 if unknown
+	uint64_t m_ContentHash;
+	//Full chain loading through TextureLoader while the dropped one stays bound
+	std::shared_ptr<Texture> m_Reload;
+	//The file failed to load or no longer has more levels, Reload gives up on it
+	bool m_ReloadFailed;
+
+	static unsigned int s_Frame;
+
+	friend class TextureLoader;
 public:
-	Texture(const std::string& path);
+	Texture(const std::string& path, const TextureOptions& options = TextureOptions());
+	//Texture from raw RGBA8 pixels
+	Texture(int width, int height, const void* data, const TextureOptions& options = TextureOptions());
+	//Block compressed levels through glCompressedTexImage2D, decoded to RGBA8 when the GL lacks the format.
+	//Mipmaps and SRGB of options come from the image.
+	Texture(const CompressedImage& image, const TextureOptions& options = TextureOptions());
+	//Every image of an open DDS/KTX2 file, uploaded straight from its mapping.
+	//Mipmaps and SRGB of options come from the file.
+	Texture(const TextureFile& file, const TextureOptions& options = TextureOptions());
 	~Texture();
 
+	//Changes filtering of an existing texture, trilinear only matters with mipmaps
+	void SetSampler(bool trilinear, float anisotropy);
+
 	void Bind(unsigned int slot = 0) const;
 	void UnBind() const;
 
 	inline int GetWidth() const { return m_Width; }
 	inline int GetHeigh() const { return m_Heigh; }
+	inline unsigned int GetRendererID() const { return m_RendererID; }
+	inline const std::string& GetFilePath() const { return m_FilePath; }
+	inline TextureStatus GetStatus() const { return m_Status; }
+	inline bool IsReady() const { return m_Status == TextureStatus::Ready; }
+	inline const TextureOptions& GetOptions() const { return m_Options; }
+	inline unsigned int GetLevelCount() const { return m_LevelCount; }
+	inline unsigned int GetTarget() const { return m_Target; }
+	inline bool IsTopFirst() const { return m_TopFirst; }
+	inline unsigned int GetInternalFormat() const { return m_InternalFormat; }
+	inline unsigned int GetDroppedLevels() const { return m_DroppedLevels; }
+	//Value of GetFrame() at the last Bind
+	inline unsigned int GetLastBound() const { return m_LastBound; }
+	inline uint64_t GetContentHash() const { return m_ContentHash; }
+
+	//GPU bytes of one resident level, all layers and faces included
+	size_t GetLevelSize(unsigned int level) const;
+	//GPU bytes of every resident level
+	size_t GetMemorySize() const;
+
+	//Gives up the top count levels of a mipmapped 2D texture by moving the rest into smaller
+	//storage, at least one level is always kept. Returns false when nothing was dropped.
+	bool DropLevels(unsigned int count);
+	//Brings back dropped levels by loading the file again through TextureLoader, only for textures
+	//created from a path. The first call starts the load, later calls return true once the full
+	//chain has been swapped in; until then the dropped chain stays bound.
+	bool Reload();
+	inline bool IsReloading() const { return m_Reload != nullptr; }
+	inline bool HasReloadFailed() const { return m_ReloadFailed; }
+
+	//Frame counter stamped by Bind, TextureManager advances it once per frame
+	static inline unsigned int GetFrame() { return s_Frame; }
+	static inline void NextFrame() { s_Frame++; }
+
+	//Largest anisotropy the driver accepts, 1 without the extension
+	static float GetMaxAnisotropy();
+
+	//Checkerboard bound in place of textures that are still loading or failed to load
+	static const Texture& GetPlaceholder();
+
+private:
+	//Named texture without storage, filled in by TextureLoader
+	Texture(TextureStatus status, const std::string& path, const TextureOptions& options);
+	//Level 0 from pixels plus the chain of m_Options, leaves the texture bound
+	void Upload(const void* pixels);
+	//Takes size, format and target from the file and allocates every level, leaves the texture bound
+	void AllocateStorage(const TextureFile& file);
+	//AllocateStorage plus every image from the mapping, leaves the texture bound
+	void UploadFile(const TextureFile& file);
+	//One image of the file, data is either its mapping or an offset into the bound unpack buffer
+	void UploadImage(const TextureFile& file, const TextureFileImage& image, const void* data);
+	void ApplySampler();
+	unsigned int GetRGBAFormat() const;
 };
 
 
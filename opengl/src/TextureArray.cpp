@@ -0,0 +1,103 @@
+#include "TextureArray.h"
+#include "Debug.h"
+#include "GLState.h"
+#include "JobSystem.h"
+#include "MipGenerator.h"
+#include "vendor/stb_image/stb_image.h"
+#include "GL/glew.h"
+
+#include <algorithm>
+#include <iostream>
+
+TextureArray::TextureArray(int width, int height, unsigned int capacity, const TextureOptions& options)
+	:m_Width(width), m_Height(height), m_Capacity(capacity), m_LayerCount(0), m_LevelCount(1), m_Options(options)
+{
+	if (m_Options.Mipmaps)
+		m_LevelCount = MipGenerator::GetLevelCount(width, height);
+	GLenum format = m_Options.SRGB ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+
+	GLCall(glGenTextures(1, &m_RendererID));
+	GLState::Get().BindTexture(GL_TEXTURE_2D_ARRAY, m_RendererID);
+	if (GLEW_ARB_texture_storage) {
+		GLCall(glTexStorage3D(GL_TEXTURE_2D_ARRAY, m_LevelCount, format, m_Width, m_Height, m_Capacity));
+	}
+	else {
+		for (unsigned int level = 0; level < m_LevelCount; level++) {
+			int levelWidth = std::max(1, m_Width >> level), levelHeight = std::max(1, m_Height >> level);
+			GLCall(glTexImage3D(GL_TEXTURE_2D_ARRAY, level, format, levelWidth, levelHeight, m_Capacity, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+		}
+	}
+
+	bool mipmapped = m_LevelCount > 1;
+	GLenum minFilter = !mipmapped ? GL_LINEAR : (m_Options.Trilinear ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR_MIPMAP_NEAREST);
+	GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, minFilter));
+	GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+	GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+	GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+	GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, m_LevelCount - 1));
+	if (GLEW_EXT_texture_filter_anisotropic) {
+		float anisotropy = std::min(std::max(m_Options.Anisotropy, 1.0f), Texture::GetMaxAnisotropy());
+		GLCall(glTexParameterf(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_ANISOTROPY_EXT, anisotropy));
+	}
+	GLState::Get().BindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+TextureArray::~TextureArray()
+{
+	GLState::Get().OnDeleteTexture(m_RendererID);
+	GLCall(glDeleteTextures(1, &m_RendererID));
+}
+
+int TextureArray::AddLayer(const void* pixels)
+{
+	if (m_LayerCount == m_Capacity)
+		return -1;
+	SetLayer(m_LayerCount, pixels);
+	return (int)m_LayerCount++;
+}
+
+int TextureArray::AddLayer(const std::string& path)
+{
+	int width, height, channels;
+	stbi_set_flip_vertically_on_load(1);
+	unsigned char* pixels = stbi_load(path.c_str(), &width, &height, &channels, 4);
+	if (!pixels) {
+		std::cout << "[TextureArray] failed to load " << path << ": " << stbi_failure_reason() << std::endl;
+		return -1;
+	}
+
+	int layer = -1;
+	if (width == m_Width && height == m_Height)
+		layer = AddLayer(pixels);
+	else
+		std::cout << "[TextureArray] " << path << " is " << width << "x" << height << ", layers are " << m_Width << "x" << m_Height << std::endl;
+	stbi_image_free(pixels);
+	return layer;
+}
+
+void TextureArray::SetLayer(unsigned int layer, const void* pixels)
+{
+	if (layer >= m_Capacity)
+		return;
+	std::vector<MipLevel> mips;
+	if (m_LevelCount > 1)
+		mips = MipGenerator(m_Options.Filter, m_Options.SRGB).Generate((const unsigned char*)pixels, m_Width, m_Height, JobSystem::Get());
+
+	GLState::Get().BindTexture(GL_TEXTURE_2D_ARRAY, m_RendererID);
+	GLCall(glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, m_Width, m_Height, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels));
+	for (unsigned int level = 1; level < m_LevelCount; level++) {
+		const MipLevel& mip = mips[level - 1];
+		GLCall(glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, mip.Width, mip.Height, 1, GL_RGBA, GL_UNSIGNED_BYTE, mip.Pixels.data()));
+	}
+	GLState::Get().BindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void TextureArray::Bind(unsigned int slot /*= 0*/) const
+{
+	GLState::Get().BindTextureUnit(slot, GL_TEXTURE_2D_ARRAY, m_RendererID);
+}
+
+void TextureArray::UnBind() const
+{
+	GLState::Get().BindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
\ No newline at end of file
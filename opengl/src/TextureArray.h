@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+
+#include "Texture.h"
+
+//Same-size RGBA8 images as the layers of one GL_TEXTURE_2D_ARRAY, with immutable storage where
+//ARB_texture_storage exists. A whole sprite or material set binds to a single unit and shaders
+//pick the image by layer, so batches never split over texture slots.
+class TextureArray {
+private:
+	unsigned int m_RendererID;
+	int m_Width, m_Height;
+	unsigned int m_Capacity;
+	unsigned int m_LayerCount;
+	unsigned int m_LevelCount;
+	TextureOptions m_Options;
+
+public:
+	//Storage for capacity layers is allocated up front, options as for Texture
+	TextureArray(int width, int height, unsigned int capacity, const TextureOptions& options = TextureOptions());
+	~TextureArray();
+
+	TextureArray(const TextureArray&) = delete;
+	TextureArray& operator=(const TextureArray&) = delete;
+
+	//Copies RGBA8 pixels (rows bottom first) into the next free layer and returns it,
+	//-1 when the array is full
+	int AddLayer(const void* pixels);
+	//Loads the image into the next free layer, -1 when it fails or its size does not match
+	int AddLayer(const std::string& path);
+	//Replaces the pixels and mips of one layer
+	void SetLayer(unsigned int layer, const void* pixels);
+
+	void Bind(unsigned int slot = 0) const;
+	void UnBind() const;
+
+	inline int GetWidth() const { return m_Width; }
+	inline int GetHeight() const { return m_Height; }
+	inline unsigned int GetRendererID() const { return m_RendererID; }
+	inline unsigned int GetCapacity() const { return m_Capacity; }
+	inline unsigned int GetLayerCount() const { return m_LayerCount; }
+	inline unsigned int GetLevelCount() const { return m_LevelCount; }
+};
\ No newline at end of file
@@ -0,0 +1,399 @@
+#include "TextureAtlas.h"
+#include "MappedFile.h"
+#include "FileList.h"
+#include "vendor/stb_image/stb_image.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace {
+	const uint32_t AtlasMagic = 0x534C5441; //"ATLS"
+	const uint32_t AtlasVersion = 1;
+
+	//Layout: Header, PageRecord[PageCount], SpriteRecord[SpriteCount], names, then the pixels
+	//of every page. Offsets are from the start of the file.
+	struct Header {
+		uint32_t Magic;
+		uint32_t Version;
+		uint32_t PageCount;
+		uint32_t SpriteCount;
+	};
+
+	struct PageRecord {
+		uint32_t Width, Height;
+		uint32_t PixelOffset;
+	};
+
+	struct SpriteRecord {
+		uint32_t NameOffset, NameSize;
+		uint32_t Page;
+		int32_t X, Y, Width, Height;
+	};
+
+	inline int AlignUp(int value, int alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	inline int NextPowerOfTwo(int value)
+	{
+		int result = 1;
+		while (result < value)
+			result <<= 1;
+		return result;
+	}
+}
+
+SkylinePacker::SkylinePacker(int width, int height)
+	:m_Width(width), m_Height(height)
+{
+	Reset();
+}
+
+void SkylinePacker::Reset()
+{
+	m_Skyline.clear();
+	m_Skyline.push_back({ 0, 0, m_Width });
+	m_MaxY = 0;
+	m_UsedArea = 0;
+}
+
+bool SkylinePacker::Fits(size_t index, int width, int height, int& y) const
+{
+	int x = m_Skyline[index].X;
+	if (x + width > m_Width)
+		return false;
+
+	y = m_Skyline[index].Y;
+	int remaining = width;
+	while (remaining > 0) {
+		y = std::max(y, m_Skyline[index].Y);
+		if (y + height > m_Height)
+			return false;
+		remaining -= m_Skyline[index].Width;
+		index++;
+	}
+	return true;
+}
+
+bool SkylinePacker::Insert(int width, int height, int& x, int& y)
+{
+	int bestBottom = INT_MAX, bestWidth = INT_MAX;
+	size_t bestIndex = m_Skyline.size();
+	for (size_t i = 0; i < m_Skyline.size(); i++) {
+		int top;
+		if (!Fits(i, width, height, top))
+			continue;
+		//Lowest bottom edge, ties go to the narrower node so wide gaps stay free
+		int bottom = top + height;
+		if (bottom < bestBottom || (bottom == bestBottom && m_Skyline[i].Width < bestWidth)) {
+			bestBottom = bottom;
+			bestWidth = m_Skyline[i].Width;
+			bestIndex = i;
+			y = top;
+		}
+	}
+	if (bestIndex == m_Skyline.size())
+		return false;
+
+	x = m_Skyline[bestIndex].X;
+	AddLevel(bestIndex, x, y, width, height);
+	m_MaxY = std::max(m_MaxY, y + height);
+	m_UsedArea += (unsigned long long)width * height;
+	return true;
+}
+
+void SkylinePacker::AddLevel(size_t index, int x, int y, int width, int height)
+{
+	m_Skyline.insert(m_Skyline.begin() + index, { x, y + height, width });
+
+	//Cut away whatever the new node covers
+	for (size_t i = index + 1; i < m_Skyline.size(); i++) {
+		Node& previous = m_Skyline[i - 1];
+		Node& node = m_Skyline[i];
+		int overlap = previous.X + previous.Width - node.X;
+		if (overlap <= 0)
+			break;
+		node.X += overlap;
+		node.Width -= overlap;
+		if (node.Width > 0)
+			break;
+		m_Skyline.erase(m_Skyline.begin() + i);
+		i--;
+	}
+
+	for (size_t i = 0; i + 1 < m_Skyline.size(); i++) {
+		if (m_Skyline[i].Y == m_Skyline[i + 1].Y) {
+			m_Skyline[i].Width += m_Skyline[i + 1].Width;
+			m_Skyline.erase(m_Skyline.begin() + i + 1);
+			i--;
+		}
+	}
+}
+
+TextureAtlas::TextureAtlas(int pageSize /*= 2048*/, int padding /*= 4*/)
+	:m_PageSize(pageSize), m_Padding(padding)
+{
+}
+
+int TextureAtlas::AddFile(const std::string& path)
+{
+	int width, height, channels;
+	stbi_set_flip_vertically_on_load_thread(1);
+	unsigned char* pixels = stbi_load(path.c_str(), &width, &height, &channels, 4);
+	if (!pixels) {
+		std::cout << "[TextureAtlas] failed to load " << path << ": " << stbi_failure_reason() << std::endl;
+		return -1;
+	}
+	int sprite = AddImage(path, width, height, pixels);
+	stbi_image_free(pixels);
+	return sprite;
+}
+
+int TextureAtlas::AddImage(const std::string& name, int width, int height, const void* pixels)
+{
+	Image image;
+	image.Name = name;
+	image.Width = width;
+	image.Height = height;
+	image.Pixels.assign((const unsigned char*)pixels, (const unsigned char*)pixels + (size_t)width * height * 4);
+	m_Images.push_back(std::move(image));
+	return (int)m_Images.size() - 1;
+}
+
+bool TextureAtlas::Build(bool upload /*= true*/)
+{
+	m_Regions.assign(m_Images.size(), AtlasRegion());
+	m_Names.clear();
+	m_Pages.clear();
+	m_Textures.clear();
+	m_Stats = AtlasStats();
+
+	//Tallest first keeps the skyline flat
+	std::vector<unsigned int> order(m_Images.size());
+	for (unsigned int i = 0; i < order.size(); i++)
+		order[i] = i;
+	std::sort(order.begin(), order.end(), [this](unsigned int a, unsigned int b) {
+		if (m_Images[a].Height != m_Images[b].Height)
+			return m_Images[a].Height > m_Images[b].Height;
+		return m_Images[a].Width > m_Images[b].Width;
+	});
+
+	std::vector<SkylinePacker> packers;
+	std::vector<int> cellX(m_Images.size()), cellY(m_Images.size());
+	for (unsigned int index : order) {
+		const Image& image = m_Images[index];
+		int width = AlignUp(image.Width + 2 * m_Padding, 4);
+		int height = AlignUp(image.Height + 2 * m_Padding, 4);
+		if (width > m_PageSize || height > m_PageSize) {
+			std::cout << "[TextureAtlas] " << image.Name << " (" << image.Width << "x" << image.Height
+				<< ") does not fit a " << m_PageSize << " page" << std::endl;
+			return false;
+		}
+
+		unsigned int page = 0;
+		while (page < packers.size() && !packers[page].Insert(width, height, cellX[index], cellY[index]))
+			page++;
+		if (page == packers.size()) {
+			packers.emplace_back(m_PageSize, m_PageSize);
+			packers.back().Insert(width, height, cellX[index], cellY[index]);
+		}
+		m_Regions[index].Page = page;
+	}
+
+	//Pages are cut down to the packed height, still a power of two
+	for (const SkylinePacker& packer : packers) {
+		Page page;
+		page.Width = m_PageSize;
+		page.Height = std::min(m_PageSize, NextPowerOfTwo(packer.GetMaxY()));
+		page.Pixels.assign((size_t)page.Width * page.Height * 4, 0);
+		m_Pages.push_back(std::move(page));
+	}
+
+	for (unsigned int i = 0; i < m_Images.size(); i++) {
+		const Image& image = m_Images[i];
+		AtlasRegion& region = m_Regions[i];
+		Page& page = m_Pages[region.Page];
+		Blit(page, image, cellX[i], cellY[i]);
+
+		region.X = cellX[i] + m_Padding;
+		region.Y = cellY[i] + m_Padding;
+		region.Width = image.Width;
+		region.Height = image.Height;
+		region.UVMin = glm::vec2((float)region.X / page.Width, (float)region.Y / page.Height);
+		region.UVMax = glm::vec2((float)(region.X + region.Width) / page.Width, (float)(region.Y + region.Height) / page.Height);
+		m_Names[image.Name] = i;
+		m_Stats.SpritePixels += (unsigned long long)image.Width * image.Height;
+	}
+
+	m_Stats.Sprites = (unsigned int)m_Regions.size();
+	m_Stats.Pages = (unsigned int)m_Pages.size();
+	for (const Page& page : m_Pages)
+		m_Stats.PagePixels += (unsigned long long)page.Width * page.Height;
+
+	if (upload)
+		Upload();
+	return true;
+}
+
+void TextureAtlas::Blit(Page& page, const Image& image, int x, int y) const
+{
+	//The whole cell is filled, the gutter repeats the nearest edge pixel
+	int width = AlignUp(image.Width + 2 * m_Padding, 4);
+	int height = AlignUp(image.Height + 2 * m_Padding, 4);
+	for (int row = 0; row < height; row++) {
+		int sourceY = std::min(std::max(row - m_Padding, 0), image.Height - 1);
+		const unsigned char* source = &image.Pixels[(size_t)sourceY * image.Width * 4];
+		unsigned char* destination = &page.Pixels[((size_t)(y + row) * page.Width + x) * 4];
+
+		for (int column = 0; column < m_Padding; column++)
+			memcpy(destination + column * 4, source, 4);
+		memcpy(destination + m_Padding * 4, source, (size_t)image.Width * 4);
+		for (int column = m_Padding + image.Width; column < width; column++)
+			memcpy(destination + column * 4, source + (image.Width - 1) * 4, 4);
+	}
+}
+
+void TextureAtlas::Upload()
+{
+	m_Textures.clear();
+	for (Page& page : m_Pages) {
+		m_Textures.push_back(std::make_unique<Texture>(page.Width, page.Height, page.Pixels.data()));
+		std::vector<unsigned char>().swap(page.Pixels);
+	}
+}
+
+int TextureAtlas::Find(const std::string& name) const
+{
+	auto it = m_Names.find(name);
+	return it != m_Names.end() ? (int)it->second : -1;
+}
+
+bool TextureAtlas::Save(const std::string& path) const
+{
+	for (const Page& page : m_Pages)
+		if (page.Pixels.empty())
+			return false; //already uploaded, build with upload = false to save
+
+	Header header = { AtlasMagic, AtlasVersion, (uint32_t)m_Pages.size(), (uint32_t)m_Regions.size() };
+	std::vector<PageRecord> pages;
+	std::vector<SpriteRecord> sprites;
+	std::string names;
+
+	uint32_t nameBase = (uint32_t)(sizeof(Header) + m_Pages.size() * sizeof(PageRecord) + m_Regions.size() * sizeof(SpriteRecord));
+	for (unsigned int i = 0; i < m_Regions.size(); i++) {
+		const AtlasRegion& region = m_Regions[i];
+		SpriteRecord record = { nameBase + (uint32_t)names.size(), (uint32_t)m_Images[i].Name.size(),
+			region.Page, region.X, region.Y, region.Width, region.Height };
+		names += m_Images[i].Name;
+		sprites.push_back(record);
+	}
+
+	uint32_t pixelOffset = (uint32_t)AlignUp(nameBase + (int)names.size(), 16);
+	names.resize(pixelOffset - nameBase, '\0');
+	for (const Page& page : m_Pages) {
+		pages.push_back({ (uint32_t)page.Width, (uint32_t)page.Height, pixelOffset });
+		pixelOffset += (uint32_t)page.Pixels.size();
+	}
+
+	std::string temporary = path + ".tmp";
+	{
+		std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+		if (!stream)
+			return false;
+		stream.write((const char*)&header, sizeof(header));
+		stream.write((const char*)pages.data(), pages.size() * sizeof(PageRecord));
+		stream.write((const char*)sprites.data(), sprites.size() * sizeof(SpriteRecord));
+		stream.write(names.data(), names.size());
+		for (const Page& page : m_Pages)
+			stream.write((const char*)page.Pixels.data(), page.Pixels.size());
+		if (!stream)
+			return false;
+	}
+	std::remove(path.c_str());
+	return std::rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+bool TextureAtlas::Load(const std::string& path)
+{
+	MappedFile file;
+	if (!file.Open(path) || file.GetSize() < sizeof(Header))
+		return false;
+
+	const unsigned char* data = file.GetData();
+	Header header;
+	memcpy(&header, data, sizeof(header));
+	size_t recordsEnd = sizeof(Header) + (size_t)header.PageCount * sizeof(PageRecord) + (size_t)header.SpriteCount * sizeof(SpriteRecord);
+	if (header.Magic != AtlasMagic || header.Version != AtlasVersion || recordsEnd > file.GetSize()) {
+		std::cout << "[TextureAtlas] " << path << " is not a cooked atlas" << std::endl;
+		return false;
+	}
+
+	const PageRecord* pages = (const PageRecord*)(data + sizeof(Header));
+	const SpriteRecord* sprites = (const SpriteRecord*)(pages + header.PageCount);
+	for (uint32_t i = 0; i < header.PageCount; i++) {
+		if ((size_t)pages[i].PixelOffset + (size_t)pages[i].Width * pages[i].Height * 4 > file.GetSize())
+			return false;
+	}
+	for (uint32_t i = 0; i < header.SpriteCount; i++) {
+		if ((size_t)sprites[i].NameOffset + sprites[i].NameSize > file.GetSize() || sprites[i].Page >= header.PageCount)
+			return false;
+	}
+
+	m_Images.clear();
+	m_Regions.clear();
+	m_Names.clear();
+	m_Pages.clear();
+	m_Textures.clear();
+	m_Stats = AtlasStats();
+
+	for (uint32_t i = 0; i < header.PageCount; i++) {
+		//Uploaded straight from the mapping
+		m_Pages.push_back({ (int)pages[i].Width, (int)pages[i].Height, {} });
+		m_Textures.push_back(std::make_unique<Texture>(pages[i].Width, pages[i].Height, data + pages[i].PixelOffset));
+		m_Stats.PagePixels += (unsigned long long)pages[i].Width * pages[i].Height;
+	}
+
+	for (uint32_t i = 0; i < header.SpriteCount; i++) {
+		const SpriteRecord& record = sprites[i];
+		const Page& page = m_Pages[record.Page];
+		AtlasRegion region;
+		region.Page = record.Page;
+		region.X = record.X;
+		region.Y = record.Y;
+		region.Width = record.Width;
+		region.Height = record.Height;
+		region.UVMin = glm::vec2((float)region.X / page.Width, (float)region.Y / page.Height);
+		region.UVMax = glm::vec2((float)(region.X + region.Width) / page.Width, (float)(region.Y + region.Height) / page.Height);
+		m_Regions.push_back(region);
+		m_Names[std::string((const char*)data + record.NameOffset, record.NameSize)] = i;
+		m_Stats.SpritePixels += (unsigned long long)region.Width * region.Height;
+	}
+
+	m_Stats.Sprites = header.SpriteCount;
+	m_Stats.Pages = header.PageCount;
+	return true;
+}
+
+int CookAtlas(const std::string& directory, const std::string& atlasPath)
+{
+	std::vector<std::string> paths = ListFiles(directory, ".png");
+	TextureAtlas atlas;
+	for (const std::string& path : paths)
+		if (atlas.AddFile(path) < 0)
+			return 1;
+
+	if (!atlas.Build(false) || !atlas.Save(atlasPath)) {
+		std::cout << "[cook] failed to write " << atlasPath << std::endl;
+		return 1;
+	}
+
+	const AtlasStats& stats = atlas.GetStats();
+	std::cout << "[cook] " << stats.Sprites << " sprites from " << directory << " on " << stats.Pages << " pages, "
+		<< stats.Efficiency() << "% of the page area used, written to " << atlasPath << std::endl;
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Texture.h"
+
+#include "glm/glm.hpp"
+
+//Bottom-left skyline: the packed area is described by its top outline, each rectangle goes
+//where it ends up lowest. Fast and tight for sprites sorted by height.
+class SkylinePacker {
+private:
+	struct Node {
+		int X, Y, Width;
+	};
+
+	int m_Width, m_Height;
+	std::vector<Node> m_Skyline;
+	int m_MaxY;
+	unsigned long long m_UsedArea;
+
+public:
+	SkylinePacker(int width, int height);
+
+	//false if it doesn't fit anywhere
+	bool Insert(int width, int height, int& x, int& y);
+	void Reset();
+
+	//Highest point of the skyline, a page can be cut down to this
+	inline int GetMaxY() const { return m_MaxY; }
+	inline unsigned long long GetUsedArea() const { return m_UsedArea; }
+
+private:
+	//Lowest y a rectangle starting at node index can sit at, false if it runs off the page
+	bool Fits(size_t index, int width, int height, int& y) const;
+	void AddLevel(size_t index, int x, int y, int width, int height);
+};
+
+struct AtlasRegion {
+	unsigned int Page;
+	int X, Y, Width, Height; //pixels inside the page, gutter not included
+	glm::vec2 UVMin, UVMax;
+};
+
+struct AtlasStats {
+	unsigned int Sprites = 0;
+	unsigned int Pages = 0;
+	unsigned long long SpritePixels = 0;
+	unsigned long long PagePixels = 0;
+
+	//Share of the page area that holds sprite pixels, gutters and free space are the rest
+	inline float Efficiency() const { return PagePixels ? 100.0f * SpritePixels / PagePixels : 0.0f; }
+};
+
+//Packs many small images into a few large pages so sprites can share one texture binding.
+//Every sprite gets a gutter of its own edge pixels and starts on a 4 pixel boundary: with the
+//default padding of 4, mip levels 1 and 2 sample only the sprite's own colors and 4x4 blocks
+//of a compressed page never mix two sprites.
+//Runtime: AddFile/AddImage, then Build. Offline: Build(false) and Save, later Load.
+class TextureAtlas {
+private:
+	struct Image {
+		std::string Name;
+		int Width, Height;
+		std::vector<unsigned char> Pixels;
+	};
+
+	struct Page {
+		int Width, Height;
+		std::vector<unsigned char> Pixels; //dropped once uploaded
+	};
+
+	int m_PageSize;
+	int m_Padding;
+	std::vector<Image> m_Images;
+	std::vector<AtlasRegion> m_Regions;
+	std::unordered_map<std::string, unsigned int> m_Names;
+	std::vector<Page> m_Pages;
+	std::vector<std::unique_ptr<Texture>> m_Textures;
+	AtlasStats m_Stats;
+
+public:
+	TextureAtlas(int pageSize = 2048, int padding = 4);
+
+	//Sprite index, -1 if the file can't be decoded. Files are flipped like Texture does.
+	int AddFile(const std::string& path);
+	//Tightly packed RGBA8 rows, bottom row first
+	int AddImage(const std::string& name, int width, int height, const void* pixels);
+
+	//Packs every sprite added so far, false if one is larger than a page.
+	//With upload the pages become textures and the CPU copies are released.
+	bool Build(bool upload = true);
+
+	//Cooked atlas: page pixels and sprite rectangles, Load maps it and uploads the pages
+	bool Save(const std::string& path) const;
+	bool Load(const std::string& path);
+
+	//-1 if there is no sprite of that name
+	int Find(const std::string& name) const;
+	inline const AtlasRegion& GetRegion(unsigned int sprite) const { return m_Regions[sprite]; }
+	inline unsigned int GetSpriteCount() const { return (unsigned int)m_Regions.size(); }
+	inline const Texture& GetPage(unsigned int page) const { return *m_Textures[page]; }
+	inline unsigned int GetPageCount() const { return (unsigned int)m_Pages.size(); }
+	inline const AtlasStats& GetStats() const { return m_Stats; }
+
+private:
+	void Blit(Page& page, const Image& image, int x, int y) const;
+	void Upload();
+};
+
+//`opengl --cook-atlas <directory> <atlas>`: packs every .png in directory into a cooked atlas,
+//sprites are named by their path. Needs no GL context. Returns the process exit code.
+int CookAtlas(const std::string& directory, const std::string& atlasPath);
\ No newline at end of file
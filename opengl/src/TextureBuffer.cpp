@@ -0,0 +1,32 @@
+#include "TextureBuffer.h"
+#include "Debug.h"
+#include "GLState.h"
+
+TextureBuffer::TextureBuffer(const void* data, unsigned int size, unsigned int format /*= GL_RGBA32F*/)
+{
+	GLCall(glGenBuffers(1, &m_BufferID));
+	GLCall(glBindBuffer(GL_TEXTURE_BUFFER, m_BufferID));
+	GLCall(glBufferData(GL_TEXTURE_BUFFER, size, data, GL_STATIC_DRAW));
+
+	GLCall(glGenTextures(1, &m_RendererID));
+	GLState::Get().BindTexture(GL_TEXTURE_BUFFER, m_RendererID);
+	GLCall(glTexBuffer(GL_TEXTURE_BUFFER, format, m_BufferID));
+}
+
+TextureBuffer::~TextureBuffer()
+{
+	GLState::Get().OnDeleteTexture(m_RendererID);
+	GLCall(glDeleteTextures(1, &m_RendererID));
+	GLCall(glDeleteBuffers(1, &m_BufferID));
+}
+
+void TextureBuffer::Bind(unsigned int slot /*= 0*/) const
+{
+	GLState::Get().BindTextureUnit(slot, GL_TEXTURE_BUFFER, m_RendererID);
+}
+
+void TextureBuffer::SetData(const void* data, unsigned int size, unsigned int offset /*= 0*/)
+{
+	GLCall(glBindBuffer(GL_TEXTURE_BUFFER, m_BufferID));
+	GLCall(glBufferSubData(GL_TEXTURE_BUFFER, offset, size, data));
+}
\ No newline at end of file
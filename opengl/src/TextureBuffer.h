@@ -0,0 +1,17 @@
+#pragma once
+
+#include <GL/glew.h>
+
+//Buffer readable from shaders through a samplerBuffer with texelFetch
+class TextureBuffer {
+private:
+	unsigned int m_BufferID;
+	unsigned int m_RendererID;
+
+public:
+	TextureBuffer(const void* data, unsigned int size, unsigned int format = GL_RGBA32F);
+	~TextureBuffer();
+
+	void Bind(unsigned int slot = 0) const;
+	void SetData(const void* data, unsigned int size, unsigned int offset = 0);
+};
\ No newline at end of file
@@ -0,0 +1,491 @@
+#include "TextureFile.h"
+#include "JobSystem.h"
+#include "MipGenerator.h"
+#include "vendor/stb_image/stb_image.h"
+
+#include <GL/glew.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace {
+	const uint32_t DDSMagic = 0x20534444; //"DDS "
+	const uint32_t FourCCDX10 = 0x30315844; //"DX10"
+
+	struct DDSPixelFormat {
+		uint32_t Size;
+		uint32_t Flags;
+		uint32_t FourCC;
+		uint32_t RGBBitCount;
+		uint32_t RBitMask, GBitMask, BBitMask, ABitMask;
+	};
+
+	struct DDSHeader {
+		uint32_t Size;
+		uint32_t Flags;
+		uint32_t Height;
+		uint32_t Width;
+		uint32_t PitchOrLinearSize;
+		uint32_t Depth;
+		uint32_t MipMapCount;
+		uint32_t Reserved1[11];
+		DDSPixelFormat PixelFormat;
+		uint32_t Caps, Caps2, Caps3, Caps4;
+		uint32_t Reserved2;
+	};
+
+	struct DDSHeaderDX10 {
+		uint32_t DXGIFormat;
+		uint32_t ResourceDimension;
+		uint32_t MiscFlag;
+		uint32_t ArraySize;
+		uint32_t MiscFlags2;
+	};
+
+	enum : uint32_t {
+		DDSD_CAPS = 0x1, DDSD_HEIGHT = 0x2, DDSD_WIDTH = 0x4, DDSD_PIXELFORMAT = 0x1000,
+		DDSD_MIPMAPCOUNT = 0x20000, DDSD_LINEARSIZE = 0x80000,
+		DDPF_FOURCC = 0x4, DDPF_RGB = 0x40,
+		DDSCAPS_COMPLEX = 0x8, DDSCAPS_TEXTURE = 0x1000, DDSCAPS_MIPMAP = 0x400000,
+		DDSCAPS2_CUBEMAP = 0x200, DDSCAPS2_CUBEMAP_ALLFACES = 0xFC00,
+		D3D10_RESOURCE_DIMENSION_TEXTURE2D = 3,
+		D3D10_RESOURCE_MISC_TEXTURECUBE = 0x4
+	};
+
+	const unsigned char KTX2Identifier[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+	struct KTX2Header {
+		unsigned char Identifier[12];
+		uint32_t VkFormat;
+		uint32_t TypeSize;
+		uint32_t PixelWidth, PixelHeight, PixelDepth;
+		uint32_t LayerCount, FaceCount, LevelCount;
+		uint32_t SupercompressionScheme;
+		uint32_t DfdByteOffset, DfdByteLength;
+		uint32_t KvdByteOffset, KvdByteLength;
+		uint64_t SgdByteOffset, SgdByteLength;
+	};
+
+	struct KTX2Level {
+		uint64_t ByteOffset;
+		uint64_t ByteLength;
+		uint64_t UncompressedByteLength;
+	};
+
+	constexpr uint32_t FourCC(char a, char b, char c, char d)
+	{
+		return (uint32_t)a | ((uint32_t)b << 8) | ((uint32_t)c << 16) | ((uint32_t)d << 24);
+	}
+
+	bool IsSRGBFormat(unsigned int internalFormat)
+	{
+		switch (internalFormat) {
+			case GL_SRGB8_ALPHA8:
+			case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+			case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+			case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT:
+			case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+			case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+				return true;
+		}
+		return false;
+	}
+
+	TextureFileFormat Compressed(unsigned int internalFormat, unsigned int blockBytes)
+	{
+		TextureFileFormat format;
+		format.InternalFormat = internalFormat;
+		format.SRGB = IsSRGBFormat(internalFormat);
+		format.Compressed = true;
+		format.BlockBytes = blockBytes;
+		return format;
+	}
+
+	TextureFileFormat Uncompressed(unsigned int internalFormat, unsigned int pixelFormat)
+	{
+		TextureFileFormat format;
+		format.InternalFormat = internalFormat;
+		format.SRGB = IsSRGBFormat(internalFormat);
+		format.Format = pixelFormat;
+		format.Type = GL_UNSIGNED_BYTE;
+		format.BlockBytes = 4;
+		return format;
+	}
+
+	bool FormatFromDXGI(uint32_t dxgi, TextureFileFormat& format)
+	{
+		switch (dxgi) {
+			case 28: format = Uncompressed(GL_RGBA8, GL_RGBA); return true;
+			case 29: format = Uncompressed(GL_SRGB8_ALPHA8, GL_RGBA); return true;
+			case 87: format = Uncompressed(GL_RGBA8, GL_BGRA); return true;
+			case 91: format = Uncompressed(GL_SRGB8_ALPHA8, GL_BGRA); return true;
+			case 71: format = Compressed(GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, 8); return true;
+			case 72: format = Compressed(GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT, 8); return true;
+			case 74: format = Compressed(GL_COMPRESSED_RGBA_S3TC_DXT3_EXT, 16); return true;
+			case 75: format = Compressed(GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT, 16); return true;
+			case 77: format = Compressed(GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, 16); return true;
+			case 78: format = Compressed(GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT, 16); return true;
+			case 80: format = Compressed(GL_COMPRESSED_RED_RGTC1, 8); return true;
+			case 81: format = Compressed(GL_COMPRESSED_SIGNED_RED_RGTC1, 8); return true;
+			case 83: format = Compressed(GL_COMPRESSED_RG_RGTC2, 16); return true;
+			case 84: format = Compressed(GL_COMPRESSED_SIGNED_RG_RGTC2, 16); return true;
+			case 95: format = Compressed(GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT, 16); return true;
+			case 96: format = Compressed(GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT, 16); return true;
+			case 98: format = Compressed(GL_COMPRESSED_RGBA_BPTC_UNORM, 16); return true;
+			case 99: format = Compressed(GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM, 16); return true;
+		}
+		return false;
+	}
+
+	bool FormatFromVulkan(uint32_t vkFormat, TextureFileFormat& format)
+	{
+		switch (vkFormat) {
+			case 37: format = Uncompressed(GL_RGBA8, GL_RGBA); return true;
+			case 43: format = Uncompressed(GL_SRGB8_ALPHA8, GL_RGBA); return true;
+			case 44: format = Uncompressed(GL_RGBA8, GL_BGRA); return true;
+			case 50: format = Uncompressed(GL_SRGB8_ALPHA8, GL_BGRA); return true;
+			case 131: format = Compressed(GL_COMPRESSED_RGB_S3TC_DXT1_EXT, 8); return true;
+			case 132: format = Compressed(GL_COMPRESSED_SRGB_S3TC_DXT1_EXT, 8); return true;
+			case 133: format = Compressed(GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, 8); return true;
+			case 134: format = Compressed(GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT, 8); return true;
+			case 135: format = Compressed(GL_COMPRESSED_RGBA_S3TC_DXT3_EXT, 16); return true;
+			case 136: format = Compressed(GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT, 16); return true;
+			case 137: format = Compressed(GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, 16); return true;
+			case 138: format = Compressed(GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT, 16); return true;
+			case 139: format = Compressed(GL_COMPRESSED_RED_RGTC1, 8); return true;
+			case 140: format = Compressed(GL_COMPRESSED_SIGNED_RED_RGTC1, 8); return true;
+			case 141: format = Compressed(GL_COMPRESSED_RG_RGTC2, 16); return true;
+			case 142: format = Compressed(GL_COMPRESSED_SIGNED_RG_RGTC2, 16); return true;
+			case 143: format = Compressed(GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT, 16); return true;
+			case 144: format = Compressed(GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT, 16); return true;
+			case 145: format = Compressed(GL_COMPRESSED_RGBA_BPTC_UNORM, 16); return true;
+			case 146: format = Compressed(GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM, 16); return true;
+		}
+		return false;
+	}
+
+	inline bool EndsWith(const std::string& text, const char* suffix)
+	{
+		size_t length = strlen(suffix);
+		if (text.size() < length)
+			return false;
+		for (size_t i = 0; i < length; i++)
+			if (tolower((unsigned char)text[text.size() - length + i]) != suffix[i])
+				return false;
+		return true;
+	}
+
+	uint32_t GetDXGIFormat(BlockFormat format, bool srgb)
+	{
+		switch (format) {
+			case BlockFormat::BC1: return srgb ? 72 : 71;
+			case BlockFormat::BC3: return srgb ? 78 : 77;
+			case BlockFormat::BC4: return 80;
+			case BlockFormat::BC5: return 83;
+			case BlockFormat::BC7: return srgb ? 99 : 98;
+		}
+		return 0;
+	}
+}
+
+size_t TextureFileFormat::GetImageSize(int width, int height) const
+{
+	if (Compressed)
+		return (size_t)((width + 3) / 4) * ((height + 3) / 4) * BlockBytes;
+	return (size_t)width * height * BlockBytes;
+}
+
+TextureFile::TextureFile()
+	:m_Width(0), m_Height(0), m_Levels(0), m_Layers(0), m_Faces(0), m_TopFirst(true)
+{
+}
+
+bool TextureFile::IsContainer(const std::string& path)
+{
+	return EndsWith(path, ".dds") || EndsWith(path, ".ktx2");
+}
+
+bool TextureFile::Open(const std::string& path)
+{
+	Close();
+	if (!m_File.Open(path))
+		return false;
+
+	bool parsed = EndsWith(path, ".ktx2") ? ParseKTX2(m_File.GetData(), m_File.GetSize()) : ParseDDS(m_File.GetData(), m_File.GetSize());
+	if (!parsed) {
+		std::cout << "[TextureFile] " << path << " is not a supported DDS or KTX2 file" << std::endl;
+		Close();
+		return false;
+	}
+	m_Path = path;
+	return true;
+}
+
+void TextureFile::Close()
+{
+	m_File.Close();
+	m_Path.clear();
+	m_Images.clear();
+	m_Width = m_Height = 0;
+	m_Levels = m_Layers = m_Faces = 0;
+	m_TopFirst = true;
+}
+
+unsigned int TextureFile::GetTarget() const
+{
+	if (m_Faces == 6)
+		return GL_TEXTURE_CUBE_MAP;
+	return m_Layers > 1 ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D;
+}
+
+bool TextureFile::SetLayout(uint32_t width, uint32_t height, uint32_t levels, uint32_t layers, uint32_t faces)
+{
+	if (width == 0 || height == 0 || width > MaxDimension || height > MaxDimension)
+		return false;
+	if (layers == 0 || layers > MaxLayers || (faces != 1 && faces != 6))
+		return false;
+	//Cube arrays need GL 4.0, not worth a path of their own here
+	if (faces == 6 && layers > 1)
+		return false;
+
+	uint32_t fullChain = 1;
+	while ((std::max(width, height) >> fullChain) > 0)
+		fullChain++;
+	m_Width = (int)width;
+	m_Height = (int)height;
+	m_Levels = std::min(std::max(1u, levels), fullChain);
+	m_Layers = layers;
+	m_Faces = faces;
+	//At most 16 * 2048 * 6 images after the checks above, no overflow in size_t
+	m_Images.resize((size_t)m_Levels * m_Layers * m_Faces);
+	return true;
+}
+
+bool TextureFile::AddImage(unsigned int level, unsigned int layer, unsigned int face, size_t offset)
+{
+	if (level >= m_Levels || layer >= m_Layers || face >= m_Faces)
+		return false;
+	int width = std::max(1, m_Width >> level), height = std::max(1, m_Height >> level);
+	size_t size = m_Format.GetImageSize(width, height);
+	if (offset > m_File.GetSize() || size > m_File.GetSize() - offset)
+		return false;
+
+	TextureFileImage& image = m_Images[((size_t)level * m_Layers + layer) * m_Faces + face];
+	image.Level = level;
+	image.Layer = layer;
+	image.Face = face;
+	image.Width = width;
+	image.Height = height;
+	image.Size = size;
+	image.Data = m_File.GetData() + offset;
+	return true;
+}
+
+bool TextureFile::ParseDDS(const unsigned char* data, size_t size)
+{
+	uint32_t magic;
+	DDSHeader header;
+	if (size < sizeof(magic) + sizeof(header))
+		return false;
+	memcpy(&magic, data, sizeof(magic));
+	memcpy(&header, data + sizeof(magic), sizeof(header));
+	if (magic != DDSMagic || header.Size != sizeof(DDSHeader))
+		return false;
+
+	//DDS has no orientation field, it is always top row first
+	m_TopFirst = true;
+	size_t offset = sizeof(magic) + sizeof(header);
+	uint32_t layers = 1;
+	uint32_t faces = (header.Caps2 & DDSCAPS2_CUBEMAP) ? 6 : 1;
+	if (faces == 6 && (header.Caps2 & DDSCAPS2_CUBEMAP_ALLFACES) != DDSCAPS2_CUBEMAP_ALLFACES)
+		return false;
+
+	const DDSPixelFormat& pixelFormat = header.PixelFormat;
+	if (pixelFormat.Flags & DDPF_FOURCC) {
+		switch (pixelFormat.FourCC) {
+			case FourCC('D', 'X', '1', '0'): {
+				DDSHeaderDX10 dx10;
+				if (size < offset + sizeof(dx10))
+					return false;
+				memcpy(&dx10, data + offset, sizeof(dx10));
+				offset += sizeof(dx10);
+				if (dx10.ResourceDimension != D3D10_RESOURCE_DIMENSION_TEXTURE2D || !FormatFromDXGI(dx10.DXGIFormat, m_Format))
+					return false;
+				layers = dx10.ArraySize;
+				if (dx10.MiscFlag & D3D10_RESOURCE_MISC_TEXTURECUBE)
+					faces = 6;
+				break;
+			}
+			case FourCC('D', 'X', 'T', '1'): m_Format = Compressed(GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, 8); break;
+			case FourCC('D', 'X', 'T', '3'): m_Format = Compressed(GL_COMPRESSED_RGBA_S3TC_DXT3_EXT, 16); break;
+			case FourCC('D', 'X', 'T', '5'): m_Format = Compressed(GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, 16); break;
+			case FourCC('A', 'T', 'I', '1'):
+			case FourCC('B', 'C', '4', 'U'): m_Format = Compressed(GL_COMPRESSED_RED_RGTC1, 8); break;
+			case FourCC('A', 'T', 'I', '2'):
+			case FourCC('B', 'C', '5', 'U'): m_Format = Compressed(GL_COMPRESSED_RG_RGTC2, 16); break;
+			default: return false;
+		}
+	}
+	else if ((pixelFormat.Flags & DDPF_RGB) && pixelFormat.RGBBitCount == 32) {
+		if (pixelFormat.RBitMask == 0x000000ff && pixelFormat.BBitMask == 0x00ff0000)
+			m_Format = Uncompressed(GL_RGBA8, GL_RGBA);
+		else if (pixelFormat.RBitMask == 0x00ff0000 && pixelFormat.BBitMask == 0x000000ff)
+			m_Format = Uncompressed(GL_RGBA8, GL_BGRA);
+		else
+			return false;
+	}
+	else {
+		return false;
+	}
+
+	if (!SetLayout(header.Width, header.Height, header.MipMapCount, layers, faces))
+		return false;
+	//Every layer starts after the whole declared chain of the one before, a clamped count would misplace them
+	if (m_Layers * m_Faces > 1 && std::max(1u, header.MipMapCount) != m_Levels)
+		return false;
+
+	//DDS stores every layer (or face) with its whole mip chain before the next one
+	for (unsigned int layer = 0; layer < m_Layers; layer++) {
+		for (unsigned int face = 0; face < m_Faces; face++) {
+			for (unsigned int level = 0; level < m_Levels; level++) {
+				if (!AddImage(level, layer, face, offset))
+					return false;
+				offset += GetImage(level, layer, face).Size;
+			}
+		}
+	}
+	return true;
+}
+
+bool TextureFile::ParseKTX2(const unsigned char* data, size_t size)
+{
+	KTX2Header header;
+	if (size < sizeof(header))
+		return false;
+	memcpy(&header, data, sizeof(header));
+	if (memcmp(header.Identifier, KTX2Identifier, sizeof(KTX2Identifier)) != 0)
+		return false;
+	if (header.SupercompressionScheme != 0 || header.PixelDepth > 1 || !FormatFromVulkan(header.VkFormat, m_Format))
+		return false;
+
+	if (!SetLayout(header.PixelWidth, header.PixelHeight, header.LevelCount, std::max(1u, header.LayerCount), header.FaceCount))
+		return false;
+	if (size < sizeof(header) + m_Levels * sizeof(KTX2Level))
+		return false;
+
+	//Key/value entries: uint32 length, "key\0value", padded to 4 bytes. Only the second letter
+	//of KTXorientation matters here, 'u' for bottom row first; without the key it is "rd".
+	m_TopFirst = true;
+	if (header.KvdByteOffset <= size && header.KvdByteLength <= size - header.KvdByteOffset) {
+		size_t offset = header.KvdByteOffset, end = (size_t)header.KvdByteOffset + header.KvdByteLength;
+		while (end - offset >= sizeof(uint32_t)) {
+			uint32_t length;
+			memcpy(&length, data + offset, sizeof(length));
+			offset += sizeof(length);
+			if (length > end - offset)
+				break;
+			const char* entry = (const char*)data + offset;
+			const char key[] = "KTXorientation";
+			if (length >= sizeof(key) + 2 && memcmp(entry, key, sizeof(key)) == 0)
+				m_TopFirst = entry[sizeof(key) + 1] != 'u';
+			offset += std::min<size_t>((length + 3) & ~3u, end - offset);
+		}
+	}
+
+	//KTX2 stores level by level, layers then faces inside a level, tightly packed
+	for (unsigned int level = 0; level < m_Levels; level++) {
+		KTX2Level index;
+		memcpy(&index, data + sizeof(header) + level * sizeof(KTX2Level), sizeof(index));
+		size_t imageSize = m_Format.GetImageSize(std::max(1, m_Width >> level), std::max(1, m_Height >> level));
+		if (index.ByteOffset > size || index.ByteLength > size - index.ByteOffset || index.ByteLength < imageSize * m_Layers * m_Faces)
+			return false;
+		for (unsigned int layer = 0; layer < m_Layers; layer++)
+			for (unsigned int face = 0; face < m_Faces; face++)
+				if (!AddImage(level, layer, face, (size_t)index.ByteOffset + (layer * m_Faces + face) * imageSize))
+					return false;
+	}
+	return true;
+}
+
+bool WriteDDS(const std::string& path, const CompressedImage& image)
+{
+	if (!image.TopFirst) {
+		std::cout << "[TextureFile] " << path << ": DDS stores the top row first, compress unflipped pixels" << std::endl;
+		return false;
+	}
+
+	DDSHeader header = {};
+	header.Size = sizeof(DDSHeader);
+	header.Flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE;
+	header.Height = image.Height;
+	header.Width = image.Width;
+	header.PitchOrLinearSize = (uint32_t)image.Levels[0].size();
+	header.MipMapCount = (uint32_t)image.Levels.size();
+	header.PixelFormat.Size = sizeof(DDSPixelFormat);
+	header.PixelFormat.Flags = DDPF_FOURCC;
+	header.PixelFormat.FourCC = FourCCDX10;
+	header.Caps = DDSCAPS_TEXTURE | (image.Levels.size() > 1 ? DDSCAPS_COMPLEX | DDSCAPS_MIPMAP : 0);
+
+	DDSHeaderDX10 dx10 = {};
+	dx10.DXGIFormat = GetDXGIFormat(image.Format, image.SRGB);
+	dx10.ResourceDimension = D3D10_RESOURCE_DIMENSION_TEXTURE2D;
+	dx10.ArraySize = 1;
+
+	std::string temporary = path + ".tmp";
+	{
+		std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+		if (!stream)
+			return false;
+		stream.write((const char*)&DDSMagic, sizeof(DDSMagic));
+		stream.write((const char*)&header, sizeof(header));
+		stream.write((const char*)&dx10, sizeof(dx10));
+		for (const auto& level : image.Levels)
+			stream.write((const char*)level.data(), level.size());
+		if (!stream)
+			return false;
+	}
+	std::remove(path.c_str());
+	return std::rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+int CompressTextureFile(const std::string& input, const std::string& output, const std::string& format, bool srgb)
+{
+	static const char* names[] = { "bc1", "bc3", "bc4", "bc5", "bc7" };
+	int index = 0;
+	while (index < 5 && format != names[index])
+		index++;
+	if (index == 5) {
+		std::cout << "[compress] unknown format " << format << ", use bc1, bc3, bc4, bc5 or bc7" << std::endl;
+		return 1;
+	}
+	BlockFormat blockFormat = (BlockFormat)index;
+
+	//Unflipped, DDS files store the top row first
+	int width, height, channels;
+	stbi_set_flip_vertically_on_load(0);
+	unsigned char* pixels = stbi_load(input.c_str(), &width, &height, &channels, 4);
+	if (!pixels) {
+		std::cout << "[compress] failed to load " << input << ": " << stbi_failure_reason() << std::endl;
+		return 1;
+	}
+
+	JobSystem& jobs = JobSystem::Get();
+	std::vector<MipLevel> mips = MipGenerator(MipFilter::Kaiser, srgb).Generate(pixels, width, height, jobs);
+	CompressionStats stats;
+	CompressedImage image = BlockCompressor(blockFormat, srgb).Compress(pixels, width, height, jobs, &mips, &stats);
+	image.TopFirst = true;
+	stbi_image_free(pixels);
+
+	if (!WriteDDS(output, image)) {
+		std::cout << "[compress] failed to write " << output << std::endl;
+		return 1;
+	}
+	std::cout << "[compress] " << input << " " << width << "x" << height << " -> " << output << " " << BlockCompressor::GetName(blockFormat)
+		<< ", " << image.Levels.size() << " levels in " << stats.EncodeMs << " ms (" << stats.MPixelsPerSecond(width, height) << " MPixels/s), PSNR "
+		<< stats.PSNR << " dB, " << stats.UncompressedBytes / 1024 << " KB -> " << stats.CompressedBytes / 1024 << " KB" << std::endl;
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "BlockCompressor.h"
+#include "MappedFile.h"
+
+//GL description of the texel format stored in a container
+struct TextureFileFormat {
+	unsigned int InternalFormat = 0;
+	unsigned int Format = 0, Type = 0; //uncompressed only
+	bool Compressed = false;
+	bool SRGB = false;
+	//Bytes per 4x4 block when compressed, per texel otherwise
+	unsigned int BlockBytes = 0;
+
+	size_t GetImageSize(int width, int height) const;
+};
+
+//One level of one face of one layer, pointing into the mapping
+struct TextureFileImage {
+	unsigned int Level, Layer, Face;
+	int Width, Height;
+	const unsigned char* Data;
+	size_t Size;
+};
+
+//DDS (legacy FourCC or DX10 header) or KTX2 file mapped into memory. Nothing is decoded or
+//copied: every image is a pointer into the mapping, ready for glCompressedTexSubImage*.
+//Handles mip chains, cube maps and arrays; KTX2 supercompression is not supported.
+//Images are uploaded in file order. DDS files store the top row first, KTX2 files say so with
+//KTXorientation ("rd", the default, or "ru"); textures made from a top-first file flip V.
+class TextureFile {
+private:
+	MappedFile m_File;
+	std::string m_Path;
+	TextureFileFormat m_Format;
+	int m_Width, m_Height;
+	unsigned int m_Levels, m_Layers, m_Faces;
+	bool m_TopFirst;
+	std::vector<TextureFileImage> m_Images; //level major, then layer, then face
+
+public:
+	//Larger headers are rejected as corrupt rather than trusted
+	static const uint32_t MaxDimension = 32768;
+	static const uint32_t MaxLayers = 2048;
+
+	TextureFile();
+
+	//false if the file is missing, not a container, or uses a format GL can't take
+	bool Open(const std::string& path);
+	void Close();
+	inline bool IsOpen() const { return m_File.IsOpen(); }
+	inline const std::string& GetPath() const { return m_Path; }
+	//The whole mapped file
+	inline const unsigned char* GetFileData() const { return m_File.GetData(); }
+	inline size_t GetFileSize() const { return m_File.GetSize(); }
+
+	inline const TextureFileFormat& GetFormat() const { return m_Format; }
+	inline int GetWidth() const { return m_Width; }
+	inline int GetHeight() const { return m_Height; }
+	inline unsigned int GetLevelCount() const { return m_Levels; }
+	inline unsigned int GetLayerCount() const { return m_Layers; }
+	inline unsigned int GetFaceCount() const { return m_Faces; }
+	inline bool IsCubeMap() const { return m_Faces == 6; }
+	inline bool IsTopFirst() const { return m_TopFirst; }
+	inline const std::vector<TextureFileImage>& GetImages() const { return m_Images; }
+	inline const TextureFileImage& GetImage(unsigned int level, unsigned int layer = 0, unsigned int face = 0) const { return m_Images[((size_t)level * m_Layers + layer) * m_Faces + face]; }
+	//GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP or GL_TEXTURE_2D_ARRAY
+	unsigned int GetTarget() const;
+
+	//By extension: .dds or .ktx2
+	static bool IsContainer(const std::string& path);
+
+private:
+	bool ParseDDS(const unsigned char* data, size_t size);
+	bool ParseKTX2(const unsigned char* data, size_t size);
+	//Validates the header values and sizes m_Images. levels is clamped to the full chain.
+	bool SetLayout(uint32_t width, uint32_t height, uint32_t levels, uint32_t layers, uint32_t faces);
+	//Fills m_Images from one offset per (level, layer, face) as the container lays them out
+	bool AddImage(unsigned int level, unsigned int layer, unsigned int face, size_t offset);
+};
+
+//Standard DDS with the DX10 header. The image has to be TopFirst, others are refused since
+//block rows can't be reordered without decoding.
+bool WriteDDS(const std::string& path, const CompressedImage& image);
+
+//`opengl --compress-texture <image> <dds> [bc1|bc3|bc4|bc5|bc7] [srgb]`: decodes the image,
+//builds Kaiser mips, block compresses every level and writes a DDS. Prints encode time, PSNR
+//and size. Needs no GL context. Returns the process exit code.
+int CompressTextureFile(const std::string& input, const std::string& output, const std::string& format, bool srgb);
\ No newline at end of file
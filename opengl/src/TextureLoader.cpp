@@ -0,0 +1,252 @@
+#include "TextureLoader.h"
+#include "Debug.h"
+#include "GLState.h"
+#include "JobSystem.h"
+#include "MappedFile.h"
+#include "Hash.h"
+#include "vendor/stb_image/stb_image.h"
+
+#include <GL/glew.h>
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstring>
+
+namespace {
+	using Clock = std::chrono::high_resolution_clock;
+
+	double ElapsedMs(Clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+}
+
+//Holding the job system here makes sure it is created first and destroyed last
+TextureLoader::TextureLoader()
+	:m_Jobs(JobSystem::Get()), m_FrameBudget(DefaultFrameBudget), m_PixelBuffer(0), m_PixelBufferSize(0),
+	m_Decoding(0), m_DecodeMs(0.0)
+{
+}
+
+TextureLoader::~TextureLoader()
+{
+	//Decode jobs point back at us. The pixel buffer is left to the context, it is gone by now.
+	m_Jobs.Wait();
+	for (const auto& request : m_Decoded)
+		stbi_image_free(request->Pixels);
+	for (const auto& request : m_Uploads)
+		stbi_image_free(request->Pixels);
+}
+
+TextureLoader& TextureLoader::Get()
+{
+	static TextureLoader s_Loader;
+	return s_Loader;
+}
+
+std::shared_ptr<Texture> TextureLoader::Load(const std::string& path, const TextureOptions& options)
+{
+	std::shared_ptr<Texture> texture(new Texture(TextureStatus::Loading, path, options));
+	Texture::GetPlaceholder();
+
+	auto request = std::make_shared<Request>();
+	request->Target = texture;
+	request->Path = path;
+	request->Options = options;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Decoding++;
+	}
+	m_Jobs.Submit([this, request]() { Decode(request); });
+	m_Stats.Requested++;
+	return texture;
+}
+
+void TextureLoader::Decode(std::shared_ptr<Request> request)
+{
+	auto start = Clock::now();
+	//Nobody is waiting for it anymore, Update counts it as cancelled
+	if (!request->Target.expired() && TextureFile::IsContainer(request->Path)) {
+		request->File.reset(new TextureFile());
+		if (request->File->Open(request->Path))
+			request->Content = Fnv1a64(request->File->GetFileData(), request->File->GetFileSize());
+		else
+			request->File.reset();
+	}
+	else if (!request->Target.expired()) {
+		//Mapped once for both the hash and the decoder
+		int channels;
+		stbi_set_flip_vertically_on_load_thread(1);
+		MappedFile file;
+		if (file.Open(request->Path) && file.GetSize() <= INT_MAX) {
+			request->Content = Fnv1a64(file.GetData(), file.GetSize());
+			request->Pixels = stbi_load_from_memory(file.GetData(), (int)file.GetSize(), &request->Width, &request->Height, &channels, 4);
+		}
+		else {
+			request->Pixels = stbi_load(request->Path.c_str(), &request->Width, &request->Height, &channels, 4);
+		}
+		if (request->Pixels && request->Options.Mipmaps) {
+			MipGenerator generator(request->Options.Filter, request->Options.SRGB);
+			request->Mips = generator.Generate(request->Pixels, request->Width, request->Height, m_Jobs);
+		}
+	}
+	double ms = ElapsedMs(start);
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Decoded.push_back(std::move(request));
+	m_Decoding--;
+	m_DecodeMs += ms;
+}
+
+unsigned int TextureLoader::Update()
+{
+	auto start = Clock::now();
+	unsigned int decoding;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		for (auto& request : m_Decoded)
+			m_Uploads.push_back(std::move(request));
+		m_Decoded.clear();
+		decoding = m_Decoding;
+		m_Stats.DecodeMs += m_DecodeMs;
+		m_DecodeMs = 0.0;
+	}
+	if (m_Uploads.empty())
+		return decoding;
+
+	unsigned int uploaded = 0;
+	while (!m_Uploads.empty() && uploaded < m_FrameBudget) {
+		Request& request = *m_Uploads.front();
+		std::shared_ptr<Texture> texture = request.Target.lock();
+		if (!texture) {
+			Finish(request, nullptr, TextureStatus::Failed);
+			m_Stats.Cancelled++;
+			continue;
+		}
+		texture->m_ContentHash = request.Content;
+		if (!request.Pixels && !request.File) {
+			if (!TextureFile::IsContainer(request.Path))
+				std::cout << "[TextureLoader] failed to load " << request.Path << ": " << stbi_failure_reason() << std::endl;
+			Finish(request, texture.get(), TextureStatus::Failed);
+			m_Stats.Failed++;
+			continue;
+		}
+
+		if (request.File) {
+			const std::vector<TextureFileImage>& images = request.File->GetImages();
+			if (request.Level == 0)
+				texture->AllocateStorage(*request.File);
+			const TextureFileImage& image = images[request.Level];
+			UploadImage(*texture, request, image);
+			uploaded += (unsigned int)image.Size;
+			if (++request.Level == images.size()) {
+				GLState::Get().BindTexture(texture->m_Target, 0);
+				Finish(request, texture.get(), TextureStatus::Ready);
+				m_Stats.Completed++;
+			}
+			continue;
+		}
+
+		if (request.Level == 0 && request.Row == 0) {
+			//Storage for every level up front, then the sampler can see the whole chain
+			texture->m_Width = request.Width;
+			texture->m_Heigh = request.Height;
+			texture->m_BPP = 4;
+			texture->m_LevelCount = 1 + (unsigned int)request.Mips.size();
+			texture->m_InternalFormat = texture->GetRGBAFormat();
+			GLState::Get().BindTexture(GL_TEXTURE_2D, texture->m_RendererID);
+			for (unsigned int level = 0; level < texture->m_LevelCount; level++) {
+				int width = level ? request.Mips[level - 1].Width : request.Width;
+				int height = level ? request.Mips[level - 1].Height : request.Height;
+				GLCall(glTexImage2D(GL_TEXTURE_2D, level, texture->GetRGBAFormat(), width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+			}
+			texture->ApplySampler();
+		}
+
+		int width = request.Level ? request.Mips[request.Level - 1].Width : request.Width;
+		int height = request.Level ? request.Mips[request.Level - 1].Height : request.Height;
+		const unsigned char* pixels = request.Level ? request.Mips[request.Level - 1].Pixels.data() : request.Pixels;
+		unsigned int rowSize = width * 4;
+
+		int rows = std::max(1, (int)((m_FrameBudget - uploaded) / rowSize));
+		rows = std::min(rows, height - request.Row);
+		UploadRows(*texture, request, width, pixels, rows);
+		request.Row += rows;
+		uploaded += rows * rowSize;
+
+		if (request.Row == height) {
+			request.Row = 0;
+			if (++request.Level == texture->m_LevelCount) {
+				Finish(request, texture.get(), TextureStatus::Ready);
+				m_Stats.Completed++;
+			}
+		}
+	}
+	GLState::Get().BindTexture(GL_TEXTURE_2D, 0);
+
+	m_Stats.BytesUploaded += uploaded;
+	m_Stats.UploadMs += ElapsedMs(start);
+	return decoding + (unsigned int)m_Uploads.size();
+}
+
+unsigned int TextureLoader::GetPendingCount()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_Decoding + (unsigned int)(m_Decoded.size() + m_Uploads.size());
+}
+
+void TextureLoader::UploadRows(const Texture& texture, const Request& request, int width, const unsigned char* pixels, int rows)
+{
+	unsigned int rowSize = width * 4;
+	unsigned int size = rows * rowSize;
+
+	pixels += (size_t)request.Row * rowSize;
+	if (FillPixelBuffer(pixels, size))
+		pixels = nullptr; //offset into the bound buffer
+	GLState::Get().BindTexture(GL_TEXTURE_2D, texture.m_RendererID);
+	GLCall(glTexSubImage2D(GL_TEXTURE_2D, request.Level, 0, request.Row, width, rows, GL_RGBA, GL_UNSIGNED_BYTE, pixels));
+	GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+	m_Stats.Uploads++;
+}
+
+void TextureLoader::UploadImage(Texture& texture, const Request& request, const TextureFileImage& image)
+{
+	//The copy reads the mapping directly, the file never goes through a heap buffer
+	const void* data = image.Data;
+	if (FillPixelBuffer(image.Data, (unsigned int)image.Size))
+		data = nullptr;
+	GLState::Get().BindTexture(texture.m_Target, texture.m_RendererID);
+	texture.UploadImage(*request.File, image, data);
+	GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+	m_Stats.Uploads++;
+}
+
+bool TextureLoader::FillPixelBuffer(const unsigned char* data, unsigned int size)
+{
+	GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_PixelBuffer));
+	if (!m_PixelBuffer) {
+		GLCall(glGenBuffers(1, &m_PixelBuffer));
+		GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_PixelBuffer));
+	}
+	//Orphaning hands the previous chunk to the driver, so the map never waits for the GPU
+	//to finish reading it. Same size every time so the driver can recycle the storage.
+	m_PixelBufferSize = std::max(std::max(m_PixelBufferSize, m_FrameBudget), size);
+	GLCall(glBufferData(GL_PIXEL_UNPACK_BUFFER, m_PixelBufferSize, nullptr, GL_STREAM_DRAW));
+	void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	if (!mapped) {
+		//Map failed, upload straight from client memory
+		GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+		return false;
+	}
+	memcpy(mapped, data, size);
+	GLCall(glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER));
+	return true;
+}
+
+void TextureLoader::Finish(Request& request, Texture* texture, TextureStatus status)
+{
+	if (texture)
+		texture->m_Status = status;
+	stbi_image_free(request.Pixels);
+	m_Uploads.pop_front();
+}
\ No newline at end of file
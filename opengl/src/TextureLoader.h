@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Texture.h"
+#include "TextureFile.h"
+
+class JobSystem;
+
+struct TextureLoaderStats {
+	unsigned int Requested = 0;
+	unsigned int Completed = 0;
+	unsigned int Failed = 0;
+	//Handle was released before the texture finished loading
+	unsigned int Cancelled = 0;
+	//glTexSubImage2D calls, one per chunk of rows or per container image
+	unsigned int Uploads = 0;
+	unsigned long long BytesUploaded = 0;
+	double DecodeMs = 0.0; //summed over the workers
+	double UploadMs = 0.0; //GL thread time spent in Update
+};
+
+//Loads image files without stalling the GL thread. Files are decoded on the job system,
+//then Update copies them through a pixel unpack buffer a few rows at a time, never more than
+//the frame budget per call. Handles bind Texture::GetPlaceholder() until their last row is in.
+//DDS/KTX2 containers are only mapped by the worker and go up one whole image at a time.
+//The worker also hashes the file, Texture::GetContentHash has it once the upload starts.
+class TextureLoader {
+private:
+	struct Request {
+		std::weak_ptr<Texture> Target;
+		std::string Path;
+		TextureOptions Options;
+		unsigned char* Pixels = nullptr;
+		int Width = 0, Height = 0;
+		std::vector<MipLevel> Mips;
+		//Set instead of Pixels for containers
+		std::unique_ptr<TextureFile> File;
+		//Fnv1a64 of the file bytes, hashed by the worker that read them
+		uint64_t Content = 0;
+		//Next row to upload, levels go one after another. Index into the images for containers.
+		unsigned int Level = 0;
+		int Row = 0;
+	};
+
+	JobSystem& m_Jobs;
+	unsigned int m_FrameBudget;
+	unsigned int m_PixelBuffer;
+	unsigned int m_PixelBufferSize;
+
+	//Decoded by the workers, waiting for the GL thread
+	std::mutex m_Mutex;
+	std::deque<std::shared_ptr<Request>> m_Decoded;
+	unsigned int m_Decoding;
+	double m_DecodeMs;
+
+	//Owned by the GL thread, uploaded front to back
+	std::deque<std::shared_ptr<Request>> m_Uploads;
+
+	TextureLoaderStats m_Stats;
+
+public:
+	static const unsigned int DefaultFrameBudget = 4 * 1024 * 1024;
+
+	TextureLoader();
+	~TextureLoader();
+
+	TextureLoader(const TextureLoader&) = delete;
+	TextureLoader& operator=(const TextureLoader&) = delete;
+
+	static TextureLoader& Get();
+
+	//Returns at once with a texture that has a name but no storage yet. GL thread only.
+	//Mipmaps are generated on the worker that decoded the file.
+	std::shared_ptr<Texture> Load(const std::string& path, const TextureOptions& options = TextureOptions());
+
+	//Uploads decoded textures until the frame budget is used up, call once per frame on the
+	//GL thread. Returns the number of textures still decoding or uploading.
+	unsigned int Update();
+	//Textures still decoding or uploading
+	unsigned int GetPendingCount();
+
+	//Bytes copied to GL per Update, at least one row is always uploaded
+	inline void SetFrameBudget(unsigned int bytes) { m_FrameBudget = bytes; }
+	inline unsigned int GetFrameBudget() const { return m_FrameBudget; }
+
+	inline const TextureLoaderStats& GetStats() const { return m_Stats; }
+	inline void ResetStats() { m_Stats = TextureLoaderStats(); }
+
+private:
+	void Decode(std::shared_ptr<Request> request);
+	//Copies rows into the pixel unpack buffer and from there into the texture
+	void UploadRows(const Texture& texture, const Request& request, int width, const unsigned char* pixels, int rows);
+	//Same through the pixel unpack buffer for one image of a container
+	void UploadImage(Texture& texture, const Request& request, const TextureFileImage& image);
+	//Fills the orphaned pixel unpack buffer, returns false with nothing bound when it cannot be mapped
+	bool FillPixelBuffer(const unsigned char* data, unsigned int size);
+	void Finish(Request& request, Texture* texture, TextureStatus status);
+};
\ No newline at end of file
@@ -0,0 +1,211 @@
+#include "TextureManager.h"
+#include "TextureLoader.h"
+#include "Hash.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace {
+	//Everything that changes the texture created from a file
+	std::string GetOptionsKey(const TextureOptions& options)
+	{
+		return std::to_string(options.Mipmaps) + std::to_string((int)options.Filter) + std::to_string(options.SRGB)
+			+ std::to_string(options.Trilinear) + std::to_string(options.Anisotropy);
+	}
+
+	//Same spelling for every way of naming a file relative to the working directory
+	std::string NormalizePath(const std::string& path)
+	{
+		std::vector<std::string> parts;
+		size_t start = 0;
+		bool absolute = !path.empty() && (path[0] == '/' || path[0] == '\\');
+		while (start <= path.size()) {
+			size_t end = path.find_first_of("/\\", start);
+			if (end == std::string::npos)
+				end = path.size();
+			std::string part = path.substr(start, end - start);
+			if (part == ".." && !parts.empty() && parts.back() != "..")
+				parts.pop_back();
+			else if (!part.empty() && part != ".")
+				parts.push_back(part);
+			start = end + 1;
+		}
+
+		std::string normalized = absolute ? "/" : "";
+		for (size_t i = 0; i < parts.size(); i++)
+			normalized += (i ? "/" : "") + parts[i];
+#ifdef _WIN32
+		//Case-insensitive file system
+		std::transform(normalized.begin(), normalized.end(), normalized.begin(), ::tolower);
+#endif
+		return normalized;
+	}
+}
+
+TextureManager::TextureManager()
+	:m_Budget(DefaultBudget), m_MaxReloadsPerFrame(1)
+{
+}
+
+TextureManager& TextureManager::Get()
+{
+	static TextureManager s_Manager;
+	return s_Manager;
+}
+
+TextureHandle TextureManager::Load(const std::string& path, const TextureOptions& options)
+{
+	m_Stats.Requests++;
+	std::string optionsKey = GetOptionsKey(options);
+	std::string key = NormalizePath(path) + "|" + optionsKey;
+	auto found = m_Paths.find(key);
+	if (found != m_Paths.end()) {
+		if (TextureHandle texture = m_Entries[found->second].Handle.lock()) {
+			m_Stats.PathHits++;
+			return texture;
+		}
+		RemoveEntry(found->second);
+	}
+
+	//Nothing is read here, the content hash comes with the decoded file
+	TextureHandle texture = TextureLoader::Get().Load(path, options);
+	m_Paths[key] = AddEntry(texture, key, optionsKey);
+	return texture;
+}
+
+void TextureManager::Update()
+{
+	unsigned int frame = Texture::GetFrame();
+	Texture::NextFrame();
+
+	std::vector<TextureHandle> textures;
+	size_t resident = 0;
+	for (size_t i = 0; i < m_Entries.size(); i++) {
+		if (m_Entries[i].Key.empty())
+			continue;
+		TextureHandle texture = m_Entries[i].Handle.lock();
+		if (!texture) {
+			RemoveEntry(i);
+			continue;
+		}
+		if (!m_Entries[i].Content && texture->GetContentHash())
+			MergeContent(i, texture->GetContentHash());
+		resident += texture->GetMemorySize();
+		textures.push_back(std::move(texture));
+	}
+
+	//Evicted textures that were drawn this frame get their full chain back if it fits. The
+	//reloaded size is estimated from the resident one, every dropped level is 4x the next.
+	//Reloads go through TextureLoader, finished ones are swapped in here.
+	unsigned int reloads = 0;
+	for (const TextureHandle& texture : textures) {
+		if (!texture->GetDroppedLevels() || texture->HasReloadFailed())
+			continue;
+		size_t size = texture->GetMemorySize();
+		if (texture->IsReloading()) {
+			if (texture->Reload()) {
+				resident = resident - size + texture->GetMemorySize();
+				m_Stats.Reloads++;
+			}
+			else if (texture->HasReloadFailed()) {
+				m_Stats.FailedReloads++;
+			}
+			continue;
+		}
+
+		if (reloads == m_MaxReloadsPerFrame || texture->GetLastBound() != frame)
+			continue;
+		size_t full = size << (2 * std::min(texture->GetDroppedLevels(), 15u));
+		if (resident - size + full > m_Budget)
+			continue;
+		texture->Reload();
+		reloads++;
+	}
+
+	//Over budget: the least recently bound lose their top level first, one level per pass
+	//so the cost is spread before anything drops twice
+	if (resident > m_Budget) {
+		std::sort(textures.begin(), textures.end(), [](const TextureHandle& a, const TextureHandle& b) {
+			return a->GetLastBound() < b->GetLastBound();
+		});
+		bool dropped = true;
+		while (resident > m_Budget && dropped) {
+			dropped = false;
+			for (const TextureHandle& texture : textures) {
+				if (resident <= m_Budget)
+					break;
+				size_t size = texture->GetMemorySize();
+				if (!texture->DropLevels(1))
+					continue;
+				size_t freed = size - texture->GetMemorySize();
+				resident -= freed;
+				dropped = true;
+				m_Stats.DroppedLevels++;
+				m_Stats.DroppedBytes += freed;
+			}
+		}
+	}
+
+	m_Stats.Textures = (unsigned int)textures.size();
+	m_Stats.ResidentBytes = resident;
+	m_Stats.Budget = m_Budget;
+	m_Stats.Evicted = 0;
+	for (const TextureHandle& texture : textures)
+		if (texture->GetDroppedLevels())
+			m_Stats.Evicted++;
+}
+
+size_t TextureManager::AddEntry(const TextureHandle& texture, const std::string& key, const std::string& options)
+{
+	size_t index = m_Entries.size();
+	if (!m_FreeEntries.empty()) {
+		index = m_FreeEntries.back();
+		m_FreeEntries.pop_back();
+	}
+	else {
+		m_Entries.emplace_back();
+	}
+	Entry& entry = m_Entries[index];
+	entry.Handle = texture;
+	entry.Key = key;
+	entry.Options = options;
+	entry.Content = 0;
+	return index;
+}
+
+void TextureManager::RemoveEntry(size_t index)
+{
+	//Path aliases found through the content hash point here too
+	for (auto it = m_Paths.begin(); it != m_Paths.end();) {
+		if (it->second == index)
+			it = m_Paths.erase(it);
+		else
+			++it;
+	}
+	Entry& entry = m_Entries[index];
+	auto content = m_Contents.find(entry.Content);
+	if (content != m_Contents.end() && content->second == index)
+		m_Contents.erase(content);
+	entry = Entry();
+	m_FreeEntries.push_back(index);
+}
+
+void TextureManager::MergeContent(size_t index, uint64_t hash)
+{
+	Entry& entry = m_Entries[index];
+	entry.Content = Fnv1a64(entry.Options, hash);
+
+	auto same = m_Contents.find(entry.Content);
+	if (same != m_Contents.end() && same->second != index) {
+		if (m_Entries[same->second].Handle.lock()) {
+			//Same bytes under another name, a copy or a different spelling of the path
+			for (auto& path : m_Paths)
+				if (path.second == index)
+					path.second = same->second;
+			m_Stats.ContentHits++;
+			return;
+		}
+		RemoveEntry(same->second);
+	}
+	m_Contents[entry.Content] = index;
+}
\ No newline at end of file
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Texture.h"
+
+//Shared ownership of a managed texture, the texture is deleted with its last handle
+using TextureHandle = std::shared_ptr<Texture>;
+
+struct TextureManagerStats {
+	unsigned int Textures = 0;
+	unsigned int Requests = 0;
+	//Requests answered with a texture that was already loaded
+	unsigned int PathHits = 0;
+	unsigned int ContentHits = 0;
+	size_t ResidentBytes = 0;
+	size_t Budget = 0;
+	//Textures currently running without their top levels
+	unsigned int Evicted = 0;
+	//Totals since the manager was created
+	unsigned int DroppedLevels = 0;
+	unsigned long long DroppedBytes = 0;
+	unsigned int Reloads = 0;
+	//Reloads given up because the file failed to load or lost levels
+	unsigned int FailedReloads = 0;
+};
+
+//Owns every texture loaded from a file. Requests for a path share the same texture, paths are
+//compared after normalizing separators, "." and "..". The file bytes are hashed by the loader's
+//worker; when they match a texture that is already loaded, Update points the path at that one,
+//so later requests share it while the duplicate lives on for the handles given out. Update keeps the resident bytes under the
+//budget by dropping the top mip of the least recently bound textures, and reloads the full
+//chain of an evicted texture once it is bound again and fits. GL thread only.
+class TextureManager {
+private:
+	struct Entry {
+		std::weak_ptr<Texture> Handle;
+		//Empty for free entries
+		std::string Key;
+		std::string Options;
+		//0 until the loader hashed the file
+		uint64_t Content = 0;
+	};
+
+	//Path and options to entry, file contents and options to entry
+	std::unordered_map<std::string, size_t> m_Paths;
+	std::unordered_map<uint64_t, size_t> m_Contents;
+	std::vector<Entry> m_Entries;
+	std::vector<size_t> m_FreeEntries;
+
+	size_t m_Budget;
+	unsigned int m_MaxReloadsPerFrame;
+	TextureManagerStats m_Stats;
+
+public:
+	static const size_t DefaultBudget = 512 * 1024 * 1024;
+
+	TextureManager();
+
+	TextureManager(const TextureManager&) = delete;
+	TextureManager& operator=(const TextureManager&) = delete;
+
+	static TextureManager& Get();
+
+	//Shared texture for the file, loaded through TextureLoader the first time it is asked for
+	TextureHandle Load(const std::string& path, const TextureOptions& options = TextureOptions());
+
+	//Enforces the budget, call once per frame on the GL thread after drawing
+	void Update();
+
+	inline void SetBudget(size_t bytes) { m_Budget = bytes; }
+	inline size_t GetBudget() const { return m_Budget; }
+	//Reloads started per frame, each one decodes on a worker and uploads within the loader's budget
+	inline void SetMaxReloadsPerFrame(unsigned int count) { m_MaxReloadsPerFrame = count; }
+
+	inline const TextureManagerStats& GetStats() const { return m_Stats; }
+
+private:
+	size_t AddEntry(const TextureHandle& texture, const std::string& key, const std::string& options);
+	void RemoveEntry(size_t index);
+	//Registers the content hash of a loaded entry, or moves its paths to a texture with the same one
+	void MergeContent(size_t index, uint64_t hash);
+};
\ No newline at end of file
@@ -0,0 +1,4 @@
+#pragma once
+
+//CPU time consumed so far by the calling thread, in milliseconds
+double ThreadCpuTimeMs();
\ No newline at end of file
@@ -0,0 +1,142 @@
+#include "Debug.h"
+#include "UniformBuffer.h"
+#include "GLState.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+UniformBufferStats UniformBuffer::s_Stats;
+
+const UniformBlockMember* UniformBlockLayout::FindMember(const char* name) const
+{
+    for (const UniformBlockMember& member : Members)
+        if (member.Name == name)
+            return &member;
+    return nullptr;
+}
+
+UniformBuffer::UniformBuffer(unsigned int size)
+    : m_Stride(size), m_Count(1)
+{
+    Init(size);
+}
+
+UniformBuffer::UniformBuffer(const UniformBlockLayout& layout, unsigned int count /*= 1*/)
+    : m_Count(count), m_Members(layout.Members)
+{
+    int alignment = 256;
+    GLCall(glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment));
+    m_Stride = count > 1 ? (layout.Size + alignment - 1) / alignment * alignment : layout.Size;
+    Init(m_Stride * count);
+}
+
+void UniformBuffer::Init(unsigned int size)
+{
+    m_Data.assign(size, 0);
+    m_DirtyBegin = size;
+    m_DirtyEnd = 0;
+
+    GLCall(glGenBuffers(1, &m_RendererID));
+    GLCall(glBindBuffer(GL_UNIFORM_BUFFER, m_RendererID));
+    GLCall(glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW));
+}
+
+UniformBuffer::~UniformBuffer()
+{
+    GLState::Get().OnDeleteBuffer(m_RendererID);
+    GLCall(glDeleteBuffers(1, &m_RendererID));
+}
+
+void UniformBuffer::Set(unsigned int offset, int value, unsigned int instance /*= 0*/)
+{
+    Write(instance * m_Stride + offset, &value, sizeof(int));
+}
+
+void UniformBuffer::Set(unsigned int offset, float value, unsigned int instance /*= 0*/)
+{
+    Write(instance * m_Stride + offset, &value, sizeof(float));
+}
+
+void UniformBuffer::Set(unsigned int offset, const glm::vec2& value, unsigned int instance /*= 0*/)
+{
+    Write(instance * m_Stride + offset, &value[0], sizeof(glm::vec2));
+}
+
+void UniformBuffer::Set(unsigned int offset, const glm::vec3& value, unsigned int instance /*= 0*/)
+{
+    Write(instance * m_Stride + offset, &value[0], sizeof(glm::vec3));
+}
+
+void UniformBuffer::Set(unsigned int offset, const glm::vec4& value, unsigned int instance /*= 0*/)
+{
+    Write(instance * m_Stride + offset, &value[0], sizeof(glm::vec4));
+}
+
+void UniformBuffer::Set(unsigned int offset, const glm::mat3& value, unsigned int instance /*= 0*/)
+{
+    //std140 rounds every column up to 16 bytes
+    for (int column = 0; column < 3; column++)
+        Write(instance * m_Stride + offset + column * 16, &value[column][0], sizeof(glm::vec3));
+}
+
+void UniformBuffer::Set(unsigned int offset, const glm::mat4& value, unsigned int instance /*= 0*/)
+{
+    Write(instance * m_Stride + offset, &value[0][0], sizeof(glm::mat4));
+}
+
+void UniformBuffer::SetData(const void* data, unsigned int size, unsigned int offset /*= 0*/)
+{
+    Write(offset, data, size);
+}
+
+void UniformBuffer::Write(unsigned int offset, const void* data, unsigned int size)
+{
+    ASSERT(offset + size <= m_Data.size());
+    std::memcpy(m_Data.data() + offset, data, size);
+    m_DirtyBegin = std::min(m_DirtyBegin, offset);
+    m_DirtyEnd = std::max(m_DirtyEnd, offset + size);
+}
+
+bool UniformBuffer::Upload()
+{
+    if (m_DirtyBegin >= m_DirtyEnd)
+        return false;
+
+    GLCall(glBindBuffer(GL_UNIFORM_BUFFER, m_RendererID));
+    GLCall(glBufferSubData(GL_UNIFORM_BUFFER, m_DirtyBegin, m_DirtyEnd - m_DirtyBegin, m_Data.data() + m_DirtyBegin));
+    s_Stats.Uploads++;
+    s_Stats.BytesUploaded += m_DirtyEnd - m_DirtyBegin;
+    m_DirtyBegin = (unsigned int)m_Data.size();
+    m_DirtyEnd = 0;
+    return true;
+}
+
+void UniformBuffer::Bind(UniformBinding binding) const
+{
+    GLCall(glBindBufferBase(GL_UNIFORM_BUFFER, (unsigned int)binding, m_RendererID));
+}
+
+void UniformBuffer::BindRange(UniformBinding binding, unsigned int instance) const
+{
+    GLCall(glBindBufferRange(GL_UNIFORM_BUFFER, (unsigned int)binding, m_RendererID, instance * m_Stride, m_Stride));
+}
+
+int UniformBuffer::GetStandardBinding(const std::string& blockName)
+{
+    if (blockName == "FrameData")
+        return (int)UniformBinding::Frame;
+    if (blockName == "MaterialData")
+        return (int)UniformBinding::Material;
+    return -1;
+}
+
+int UniformBuffer::GetMemberOffset(const char* member) const
+{
+    for (const UniformBlockMember& m : m_Members)
+        if (m.Name == member)
+            return m.Offset;
+
+    std::cout << "Warning: uniform block member " << member << " doesn't exist!" << std::endl;
+    return -1;
+}
\ No newline at end of file
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+//Binding points shared by every program. Blocks named like this are bound at link time,
+//so one buffer bound here feeds all shaders without touching each program.
+enum class UniformBinding : unsigned int {
+	Frame = 0,    //"FrameData": camera and time, written once per frame
+	Material = 1, //"MaterialData": one range per material
+	Count
+};
+
+//Block member as reported by GL after linking
+struct UniformBlockMember {
+	std::string Name; //array members without the trailing [0]
+	unsigned int Type;
+	int Offset;
+	int ArrayStride;
+	int MatrixStride;
+};
+
+struct UniformBlockLayout {
+	std::string Name;
+	unsigned int Index;
+	unsigned int Size;
+	std::vector<UniformBlockMember> Members;
+
+	const UniformBlockMember* FindMember(const char* name) const;
+};
+
+//Buffer traffic since the last ResetStats, over all uniform buffers
+struct UniformBufferStats {
+	unsigned int Uploads = 0; //glBufferSubData calls
+	unsigned long long BytesUploaded = 0;
+};
+
+//Uniform buffer with a CPU copy laid out std140. Setters only write the copy and widen the
+//dirty range, Upload sends that range with one glBufferSubData.
+//With a layout and count > 1 it holds count instances of the block, each starting at a
+//GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT boundary so it can be bound alone with BindRange.
+class UniformBuffer {
+private:
+	unsigned int m_RendererID;
+	unsigned int m_Stride;
+	unsigned int m_Count;
+	std::vector<unsigned char> m_Data;
+	std::vector<UniformBlockMember> m_Members;
+	unsigned int m_DirtyBegin;
+	unsigned int m_DirtyEnd;
+
+	static UniformBufferStats s_Stats;
+
+public:
+	UniformBuffer(unsigned int size);
+	UniformBuffer(const UniformBlockLayout& layout, unsigned int count = 1);
+	~UniformBuffer();
+
+	UniformBuffer(const UniformBuffer&) = delete;
+	UniformBuffer& operator=(const UniformBuffer&) = delete;
+
+	//std140 writers by byte offset inside an instance
+	void Set(unsigned int offset, int value, unsigned int instance = 0);
+	void Set(unsigned int offset, float value, unsigned int instance = 0);
+	void Set(unsigned int offset, const glm::vec2& value, unsigned int instance = 0);
+	void Set(unsigned int offset, const glm::vec3& value, unsigned int instance = 0);
+	void Set(unsigned int offset, const glm::vec4& value, unsigned int instance = 0);
+	//Columns padded to vec4
+	void Set(unsigned int offset, const glm::mat3& value, unsigned int instance = 0);
+	void Set(unsigned int offset, const glm::mat4& value, unsigned int instance = 0);
+
+	//By member name, needs the layout constructor. Unknown names are ignored with a warning.
+	template<typename T>
+	void Set(const char* member, const T& value, unsigned int instance = 0)
+	{
+		int offset = GetMemberOffset(member);
+		if (offset >= 0)
+			Set((unsigned int)offset, value, instance);
+	}
+
+	//Raw bytes, for structs already laid out std140
+	void SetData(const void* data, unsigned int size, unsigned int offset = 0);
+
+	//Sends the dirty range, returns false when there was nothing to send
+	bool Upload();
+
+	void Bind(UniformBinding binding) const;
+	void BindRange(UniformBinding binding, unsigned int instance) const;
+
+	inline unsigned int GetRendererID() const { return m_RendererID; }
+	inline unsigned int GetStride() const { return m_Stride; }
+	inline unsigned int GetCount() const { return m_Count; }
+
+	//Binding for a block name, -1 if the name is not one of the shared blocks
+	static int GetStandardBinding(const std::string& blockName);
+
+	static inline const UniformBufferStats& GetStats() { return s_Stats; }
+	static inline void ResetStats() { s_Stats = UniformBufferStats(); }
+
+private:
+	void Init(unsigned int size);
+	int GetMemberOffset(const char* member) const;
+	void Write(unsigned int offset, const void* data, unsigned int size);
+};
\ No newline at end of file
@@ -1,15 +1,18 @@
 #include "VertexArray.h"
 #include "VertexBufferLayout.h"
 #include "Debug.h"
+#include "GLState.h"
 
 VertexArray::VertexArray()
+	:m_AttribCount(0)
 {
 	GLCall(glGenVertexArrays(1, &m_RendererID));
-	GLCall(glBindVertexArray(m_RendererID));
+	GLState::Get().BindVertexArray(m_RendererID);
 }
 
 VertexArray::~VertexArray()
 {
+	GLState::Get().OnDeleteVertexArray(m_RendererID);
 	GLCall(glDeleteVertexArrays(1, &m_RendererID));
 }
 
@@ -17,28 +20,43 @@ void VertexArray::AddBuffer(VertexBuffer& vbo, VertexBufferLayout& layout)
 {
 	Bind();
 	vbo.Bind();
+	AddLayout(layout);
+}
+
+void VertexArray::AddBuffer(StreamBuffer& buffer, VertexBufferLayout& layout)
+{
+	Bind();
+	buffer.Bind();
+	AddLayout(layout);
+}
+
+void VertexArray::AddLayout(VertexBufferLayout& layout)
+{
 	const auto& elements = layout.GetElements();
 	unsigned int offset = 0;
 
 	for (unsigned int i = 0; i < elements.size(); i++) {
 		const auto& element = elements[i];
+		unsigned int index = m_AttribCount + i;
 
-		GLCall(glEnableVertexAttribArray(i));
-		GLCall(glVertexAttribPointer(i, element.count, element.type,
-			element.nomaliazed, layout.GetStride(),(const void*)offset));
+		GLCall(glEnableVertexAttribArray(index));
+		GLCall(glVertexAttribPointer(index, element.count, element.type,
+			element.nomaliazed, layout.GetStride(),(const void*)(size_t)offset));
+		if (element.divisor)
+			GLCall(glVertexAttribDivisor(index, element.divisor));
 
 		offset += element.count * VertexBufferElement::GetSizeOfType(element.type);
 	}
-
+	m_AttribCount += (unsigned int)elements.size();
 }
 
 void VertexArray::Bind() const
 {
-	GLCall(glBindVertexArray(m_RendererID));
+	GLState::Get().BindVertexArray(m_RendererID);
 }
 
 void VertexArray::UnBind() const
 {
-	GLCall(glBindVertexArray(0));
+	GLState::Get().BindVertexArray(0);
 }
 
@@ -2,16 +2,26 @@
 
 #include "VertexBuffer.h"
 #include "VertexBufferLayout.h"
+#include "StreamBuffer.h"
 
 class VertexArray {
 private:
 	unsigned int m_RendererID;
+	//Next free attribute location, so several buffers can be added one after another
+	unsigned int m_AttribCount;
 public:
 	VertexArray();
 	~VertexArray();
 
 	void AddBuffer(VertexBuffer& vbo,VertexBufferLayout& layout);
+	//Attributes start at offset 0, draws pick their allocation with a base vertex
+	void AddBuffer(StreamBuffer& buffer, VertexBufferLayout& layout);
 	void Bind() const;
 	void UnBind() const;
 
+	inline unsigned int GetRendererID() const { return m_RendererID; }
+
+private:
+	void AddLayout(VertexBufferLayout& layout);
+
 };
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "Debug.h"
 #include "VertexBuffer.h"
+#include "GLState.h"
 
 
 VertexBuffer::VertexBuffer(const void* data, unsigned int size)
@@ -9,8 +10,16 @@ VertexBuffer::VertexBuffer(const void* data, unsigned int size)
     GLCall(glBufferData(GL_ARRAY_BUFFER, size,data, GL_STATIC_DRAW));
 }
 
+VertexBuffer::VertexBuffer(unsigned int size)
+{
+    GLCall(glGenBuffers(1, &m_RendererID));
+    GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_RendererID));
+    GLCall(glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_DYNAMIC_DRAW));
+}
+
 VertexBuffer::~VertexBuffer()
 {
+    GLState::Get().OnDeleteBuffer(m_RendererID);
     GLCall(glDeleteBuffers(1,&m_RendererID))
 }
 
@@ -23,3 +32,9 @@ void VertexBuffer::UnBind()
 {
     GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
 }
+
+void VertexBuffer::SetData(const void* data, unsigned int size, unsigned int offset /*= 0*/)
+{
+    GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_RendererID));
+    GLCall(glBufferSubData(GL_ARRAY_BUFFER, offset, size, data));
+}
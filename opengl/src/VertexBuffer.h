@@ -7,8 +7,12 @@ private:
 
 public:
 	VertexBuffer(const void* data, unsigned int size);
+	//Dynamic buffer, filled later with SetData
+	VertexBuffer(unsigned int size);
 	~VertexBuffer();
 
 	void Bind();
 	void UnBind();
+
+	void SetData(const void* data, unsigned int size, unsigned int offset = 0);
 };
\ No newline at end of file
@@ -7,13 +7,15 @@ struct VertexBufferElement {
 	unsigned int count;
 	unsigned int type;
 	unsigned char nomaliazed;
+	//0 = per vertex, N = advance once every N instances
+	unsigned int divisor;
 
 	static unsigned int GetSizeOfType(unsigned int type) {
 		switch (type)
 		{		
 			case GL_FLOAT:return 4;
 			case GL_UNSIGNED_BYTE:return 1;
-			case GL_UNSIGNED_INT:return 1;
+			case GL_UNSIGNED_INT:return 4;
 
 			default:
 				return 0;
@@ -30,28 +32,31 @@ public:
 	VertexBufferLayout() : m_Stride(0) {};
 	
 	template<typename T>
-	void Push(unsigned int count) {
+	void Push(unsigned int count, unsigned int divisor = 0) {
 		//static_assert(false);
 	}
 
-	template<>
-	void Push<float>(unsigned int count) {
-		m_Elements.push_back({ count,GL_FLOAT,GL_FALSE });
-		m_Stride += count * sizeof(GL_FLOAT);
-	}
+	inline const std::vector<VertexBufferElement>& GetElements() const { return m_Elements; }
+	inline unsigned int GetStride() const { return m_Stride; }
 
-	template<>
-	void Push<unsigned int>(unsigned int count) {
-		m_Elements.push_back({ count,GL_UNSIGNED_INT,GL_FALSE });
-		m_Stride += count * sizeof(GL_UNSIGNED_INT);
+private:
+	void PushElement(unsigned int count, unsigned int type, unsigned char normalized, unsigned int divisor) {
+		m_Elements.push_back({ count,type,normalized,divisor });
+		m_Stride += count * VertexBufferElement::GetSizeOfType(type);
 	}
+};
 
-	template<>
-	void Push<unsigned char>(unsigned int count) {
-		m_Elements.push_back({ count,GL_UNSIGNED_BYTE,GL_TRUE });
-		m_Stride += count * sizeof(GL_UNSIGNED_BYTE) ;
-	}
+template<>
+inline void VertexBufferLayout::Push<float>(unsigned int count, unsigned int divisor) {
+	PushElement(count, GL_FLOAT, GL_FALSE, divisor);
+}
 
-	inline const std::vector<VertexBufferElement> GetElements() const { return m_Elements; }
-	inline unsigned int GetStride() const { return m_Stride; }
-};
\ No newline at end of file
+template<>
+inline void VertexBufferLayout::Push<unsigned int>(unsigned int count, unsigned int divisor) {
+	PushElement(count, GL_UNSIGNED_INT, GL_FALSE, divisor);
+}
+
+template<>
+inline void VertexBufferLayout::Push<unsigned char>(unsigned int count, unsigned int divisor) {
+	PushElement(count, GL_UNSIGNED_BYTE, GL_TRUE, divisor);
+}
\ No newline at end of file
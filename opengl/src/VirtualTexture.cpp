@@ -0,0 +1,486 @@
+#include "VirtualTexture.h"
+#include "Debug.h"
+#include "GLState.h"
+#include "JobSystem.h"
+#include "MipGenerator.h"
+#include "Shader.h"
+#include "vendor/stb_image/stb_image.h"
+
+#include <GL/glew.h>
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+
+namespace {
+	using Clock = std::chrono::high_resolution_clock;
+
+	const uint32_t VirtualMagic = 0x58455456; //"VTEX"
+	const uint32_t VirtualVersion = 1;
+
+	double ElapsedMs(Clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	inline bool IsPowerOfTwo(unsigned int value)
+	{
+		return value && !(value & (value - 1));
+	}
+
+	inline unsigned int Log2(unsigned int value)
+	{
+		unsigned int log = 0;
+		while (value >>= 1)
+			log++;
+		return log;
+	}
+
+	//Page table texel: atlas tile in rg, level of the tile in b
+	inline uint32_t PackEntry(unsigned int x, unsigned int y, unsigned int level)
+	{
+		return x | (y << 8) | (level << 16) | 0xff000000u;
+	}
+}
+
+VirtualFeedback::VirtualFeedback(int width, int height, int scale)
+	:m_Width(std::max(1, width / scale)), m_Height(std::max(1, height / scale)), m_Scale(scale), m_Frame(0)
+{
+	GLCall(glGenTextures(1, &m_ColorBuffer));
+	GLState::Get().BindTexture(GL_TEXTURE_2D, m_ColorBuffer);
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+	GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_Width, m_Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+	GLState::Get().BindTexture(GL_TEXTURE_2D, 0);
+
+	GLCall(glGenRenderbuffers(1, &m_DepthBuffer));
+	GLCall(glBindRenderbuffer(GL_RENDERBUFFER, m_DepthBuffer));
+	GLCall(glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, m_Width, m_Height));
+	GLCall(glBindRenderbuffer(GL_RENDERBUFFER, 0));
+
+	GLCall(glGenFramebuffers(1, &m_Framebuffer));
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, m_Framebuffer));
+	GLCall(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_ColorBuffer, 0));
+	GLCall(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_DepthBuffer));
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "[VirtualFeedback] framebuffer incomplete: 0x" << std::hex << status << std::dec << std::endl;
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+
+	GLCall(glGenBuffers(2, m_PixelBuffers));
+	for (unsigned int buffer : m_PixelBuffers) {
+		GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer));
+		GLCall(glBufferData(GL_PIXEL_PACK_BUFFER, (size_t)m_Width * m_Height * 4, nullptr, GL_STREAM_READ));
+	}
+	GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+}
+
+VirtualFeedback::~VirtualFeedback()
+{
+	GLCall(glDeleteBuffers(2, m_PixelBuffers));
+	GLCall(glDeleteFramebuffers(1, &m_Framebuffer));
+	GLCall(glDeleteRenderbuffers(1, &m_DepthBuffer));
+	GLState::Get().OnDeleteTexture(m_ColorBuffer);
+	GLCall(glDeleteTextures(1, &m_ColorBuffer));
+}
+
+void VirtualFeedback::Begin()
+{
+	GLCall(glGetIntegerv(GL_VIEWPORT, m_Viewport));
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, m_Framebuffer));
+	GLCall(glViewport(0, 0, m_Width, m_Height));
+
+	//Alpha 0 marks pixels nothing was drawn to
+	float clearColor[4];
+	GLCall(glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor));
+	GLCall(glClearColor(0.0f, 0.0f, 0.0f, 0.0f));
+	GLCall(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+	GLCall(glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]));
+}
+
+void VirtualFeedback::End()
+{
+	GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, m_PixelBuffers[m_Frame % 2]));
+	GLCall(glReadPixels(0, 0, m_Width, m_Height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+	GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+	GLCall(glViewport(m_Viewport[0], m_Viewport[1], m_Viewport[2], m_Viewport[3]));
+	m_Frame++;
+}
+
+void VirtualFeedback::Collect(std::vector<uint32_t>& tiles)
+{
+	tiles.clear();
+	if (m_Frame < 2)
+		return;
+
+	//The buffer End filled one frame ago, the one before the latest
+	GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, m_PixelBuffers[m_Frame % 2]));
+	size_t size = (size_t)m_Width * m_Height * 4;
+	const unsigned char* pixels = (const unsigned char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+	if (pixels) {
+		for (size_t i = 0; i < size; i += 4) {
+			if (pixels[i + 3] == 255)
+				tiles.push_back(VirtualTexture::MakeKey(pixels[i + 2], pixels[i], pixels[i + 1]));
+		}
+		GLCall(glUnmapBuffer(GL_PIXEL_PACK_BUFFER));
+	}
+	GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+
+	//The level is in the top bits, descending puts the coarsest tiles first
+	std::sort(tiles.begin(), tiles.end(), std::greater<uint32_t>());
+	tiles.erase(std::unique(tiles.begin(), tiles.end()), tiles.end());
+}
+
+float VirtualFeedback::GetLodBias() const
+{
+	return -std::log2((float)m_Scale);
+}
+
+VirtualTexture::VirtualTexture(const std::string& path, unsigned int atlasTiles)
+	:m_Jobs(JobSystem::Get()), m_Header(), m_Tiles(0), m_AtlasTiles(atlasTiles), m_Atlas(0), m_PageTable(0), m_PageTableDirty(true),
+	m_InFlight(0), m_Frame(0), m_MaxUploadsPerFrame(16), m_MaxPendingLoads(64)
+{
+	if (!Open(path)) {
+		std::cout << "[VirtualTexture] " << path << " is not a cooked virtual texture" << std::endl;
+		return;
+	}
+
+	unsigned int padded = m_Header.TileSize + 2 * m_Header.Border;
+	GLCall(glGenTextures(1, &m_Atlas));
+	GLState::Get().BindTexture(GL_TEXTURE_2D, m_Atlas);
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0));
+	GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, padded * m_AtlasTiles, padded * m_AtlasTiles, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+
+	//Sampled with an explicit level, each level one texel per tile
+	GLCall(glGenTextures(1, &m_PageTable));
+	GLState::Get().BindTexture(GL_TEXTURE_2D, m_PageTable);
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, m_Header.Levels - 1));
+	m_PageEntries.resize(m_Header.Levels);
+	for (unsigned int level = 0; level < m_Header.Levels; level++) {
+		unsigned int tiles = std::max(1u, m_Tiles >> level);
+		m_PageEntries[level].resize(tiles * tiles);
+		GLCall(glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, tiles, tiles, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+	}
+	m_Slots.resize(m_AtlasTiles * m_AtlasTiles);
+
+	//The coarsest tile is read right away and never evicted, every lookup can fall back to it
+	LoadedTile root;
+	root.Key = MakeKey(m_Header.Levels - 1, 0, 0);
+	const unsigned char* data = GetTileData(root.Key);
+	root.Pixels.assign(data, data + GetTileBytes());
+	UploadTile(root);
+	m_Slots[m_Resident[root.Key]].LastUsed = UINT_MAX;
+	RebuildPageTable();
+	GLState::Get().BindTexture(GL_TEXTURE_2D, 0);
+}
+
+VirtualTexture::~VirtualTexture()
+{
+	//Load jobs point back at us. Only ours are waited for, the queue may hold jobs that wait on this thread
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_InFlightCV.wait(lock, [this]() { return m_InFlight == 0; });
+	}
+	if (m_Atlas) {
+		GLState::Get().OnDeleteTexture(m_Atlas);
+		GLState::Get().OnDeleteTexture(m_PageTable);
+		GLCall(glDeleteTextures(1, &m_Atlas));
+		GLCall(glDeleteTextures(1, &m_PageTable));
+	}
+}
+
+bool VirtualTexture::Open(const std::string& path)
+{
+	if (!m_File.Open(path) || m_File.GetSize() < sizeof(Header) || m_AtlasTiles < 2)
+		return false;
+	memcpy(&m_Header, m_File.GetData(), sizeof(Header));
+	const Header& header = m_Header;
+	if (header.Magic != VirtualMagic || header.Version != VirtualVersion)
+		return false;
+	if (!IsPowerOfTwo(header.Size) || !IsPowerOfTwo(header.TileSize) || header.TileSize > header.Size || header.Border > header.TileSize)
+		return false;
+	m_Tiles = header.Size / header.TileSize;
+	//8 bit tile coordinates in the feedback and the page table
+	if (m_Tiles > 256 || header.Levels != Log2(m_Tiles) + 1)
+		return false;
+
+	size_t tiles = 0;
+	for (unsigned int level = 0; level < header.Levels; level++) {
+		m_LevelOffsets.push_back(tiles);
+		size_t side = std::max(1u, m_Tiles >> level);
+		tiles += side * side;
+	}
+	return m_File.GetSize() >= sizeof(Header) + tiles * GetTileBytes();
+}
+
+size_t VirtualTexture::GetTileBytes() const
+{
+	size_t padded = m_Header.TileSize + 2 * m_Header.Border;
+	return padded * padded * 4;
+}
+
+const unsigned char* VirtualTexture::GetTileData(uint32_t key) const
+{
+	unsigned int level = key >> 24, y = (key >> 12) & 0xfff, x = key & 0xfff;
+	size_t index = m_LevelOffsets[level] + (size_t)y * std::max(1u, m_Tiles >> level) + x;
+	return m_File.GetData() + sizeof(Header) + index * GetTileBytes();
+}
+
+void VirtualTexture::Load(uint32_t key)
+{
+	m_Pending.insert(key);
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_InFlight++;
+	}
+	m_Jobs.Submit([this, key]() {
+		//Touching the mapping here takes the page faults off the GL thread
+		LoadedTile tile;
+		tile.Key = key;
+		const unsigned char* data = GetTileData(key);
+		tile.Pixels.assign(data, data + GetTileBytes());
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Loaded.push_back(std::move(tile));
+		//Under the lock, the destructor may free the condition variable as soon as it sees zero
+		m_InFlight--;
+		m_InFlightCV.notify_all();
+	});
+}
+
+void VirtualTexture::Update(const std::vector<uint32_t>& tiles)
+{
+	if (!IsOpen())
+		return;
+	m_Frame++;
+	m_Stats.Requested = m_Stats.Hits = m_Stats.Uploads = m_Stats.Evictions = 0;
+
+	//Every requested tile needs its ancestors as fallbacks, they are cheap and shared
+	m_Requested.clear();
+	for (uint32_t key : tiles) {
+		unsigned int level = key >> 24, y = (key >> 12) & 0xfff, x = key & 0xfff;
+		unsigned int side = std::max(1u, m_Tiles >> level);
+		if (level >= m_Header.Levels || x >= side || y >= side)
+			continue;
+		m_Stats.Requested++;
+		if (m_Resident.count(key))
+			m_Stats.Hits++;
+		for (unsigned int parent = level; parent < m_Header.Levels; parent++) {
+			unsigned int shift = parent - level;
+			if (!m_Requested.insert(MakeKey(parent, x >> shift, y >> shift)).second)
+				break;
+		}
+	}
+
+	std::vector<uint32_t> missing;
+	for (uint32_t key : m_Requested) {
+		auto resident = m_Resident.find(key);
+		if (resident != m_Resident.end()) {
+			if (m_Slots[resident->second].LastUsed != UINT_MAX)
+				m_Slots[resident->second].LastUsed = m_Frame;
+		}
+		else if (!m_Pending.count(key)) {
+			missing.push_back(key);
+		}
+	}
+	//Coarse first, so the fallbacks of a newly seen area come in before its detail
+	std::sort(missing.begin(), missing.end(), std::greater<uint32_t>());
+	for (uint32_t key : missing) {
+		if (m_Pending.size() >= m_MaxPendingLoads)
+			break;
+		Load(key);
+	}
+
+	auto start = Clock::now();
+	std::vector<LoadedTile> loaded;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		loaded.swap(m_Loaded);
+	}
+	size_t next = 0;
+	for (; next < loaded.size() && m_Stats.Uploads < m_MaxUploadsPerFrame; next++) {
+		const LoadedTile& tile = loaded[next];
+		m_Pending.erase(tile.Key);
+		//Tiles that scrolled out while they were read would only push out ones still in view
+		if (!m_Requested.count(tile.Key) || m_Resident.count(tile.Key))
+			continue;
+		UploadTile(tile);
+	}
+	if (next < loaded.size()) {
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Loaded.insert(m_Loaded.begin(), std::make_move_iterator(loaded.begin() + next), std::make_move_iterator(loaded.end()));
+	}
+	if (m_PageTableDirty)
+		RebuildPageTable();
+	GLState::Get().BindTexture(GL_TEXTURE_2D, 0);
+	if (m_Stats.Uploads)
+		m_Stats.UploadMs += ElapsedMs(start);
+
+	m_Stats.Resident = (unsigned int)m_Resident.size();
+	m_Stats.Pending = (unsigned int)m_Pending.size();
+	m_Stats.TotalRequested += m_Stats.Requested;
+	m_Stats.TotalHits += m_Stats.Hits;
+}
+
+bool VirtualTexture::AllocateSlot(unsigned int& slot)
+{
+	unsigned int oldest = UINT_MAX;
+	for (unsigned int i = 0; i < m_Slots.size(); i++) {
+		if (!m_Slots[i].Used) {
+			slot = i;
+			return true;
+		}
+		if (m_Slots[i].LastUsed < m_Frame && m_Slots[i].LastUsed < oldest) {
+			oldest = m_Slots[i].LastUsed;
+			slot = i;
+		}
+	}
+	return oldest != UINT_MAX;
+}
+
+bool VirtualTexture::UploadTile(const LoadedTile& tile)
+{
+	unsigned int slot;
+	if (!AllocateSlot(slot))
+		return false;
+	Slot& entry = m_Slots[slot];
+	if (entry.Used) {
+		m_Resident.erase(entry.Key);
+		m_Stats.Evictions++;
+	}
+	entry.Key = tile.Key;
+	entry.Used = true;
+	entry.LastUsed = m_Frame;
+	m_Resident[tile.Key] = slot;
+
+	int padded = m_Header.TileSize + 2 * m_Header.Border;
+	GLState::Get().BindTexture(GL_TEXTURE_2D, m_Atlas);
+	GLCall(glTexSubImage2D(GL_TEXTURE_2D, 0, (slot % m_AtlasTiles) * padded, (slot / m_AtlasTiles) * padded, padded, padded,
+		GL_RGBA, GL_UNSIGNED_BYTE, tile.Pixels.data()));
+	m_Stats.Uploads++;
+	m_Stats.TotalUploads++;
+	m_Stats.BytesUploaded += tile.Pixels.size();
+	m_PageTableDirty = true;
+	return true;
+}
+
+void VirtualTexture::RebuildPageTable()
+{
+	std::vector<std::vector<uint32_t>> residentByLevel(m_Header.Levels);
+	for (const auto& resident : m_Resident)
+		residentByLevel[resident.first >> 24].push_back(resident.first);
+
+	//Coarse to fine: a tile inherits its parent's entry unless it is resident itself
+	GLState::Get().BindTexture(GL_TEXTURE_2D, m_PageTable);
+	for (int level = (int)m_Header.Levels - 1; level >= 0; level--) {
+		unsigned int side = std::max(1u, m_Tiles >> level);
+		std::vector<uint32_t>& entries = m_PageEntries[level];
+		if (level == (int)m_Header.Levels - 1) {
+			std::fill(entries.begin(), entries.end(), 0u);
+		}
+		else {
+			const std::vector<uint32_t>& parents = m_PageEntries[level + 1];
+			unsigned int parentSide = std::max(1u, m_Tiles >> (level + 1));
+			for (unsigned int y = 0; y < side; y++)
+				for (unsigned int x = 0; x < side; x++)
+					entries[y * side + x] = parents[(y / 2) * parentSide + x / 2];
+		}
+		for (uint32_t key : residentByLevel[level]) {
+			unsigned int slot = m_Resident[key];
+			entries[((key >> 12) & 0xfff) * side + (key & 0xfff)] = PackEntry(slot % m_AtlasTiles, slot / m_AtlasTiles, level);
+		}
+		GLCall(glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, side, side, GL_RGBA, GL_UNSIGNED_BYTE, entries.data()));
+	}
+	m_PageTableDirty = false;
+}
+
+void VirtualTexture::Bind(Shader& shader, unsigned int atlasSlot, unsigned int pageTableSlot, float lodBias) const
+{
+	GLState::Get().BindTextureUnit(atlasSlot, GL_TEXTURE_2D, m_Atlas);
+	GLState::Get().BindTextureUnit(pageTableSlot, GL_TEXTURE_2D, m_PageTable);
+
+	float padded = (float)(m_Header.TileSize + 2 * m_Header.Border);
+	shader.Bind();
+	shader.SetUniform1i("u_TileAtlas", atlasSlot);
+	shader.SetUniform1i("u_PageTable", pageTableSlot);
+	shader.SetUniform4f("u_VirtualInfo", (float)m_Header.Size, (float)m_Tiles, (float)(m_Header.Levels - 1), lodBias);
+	shader.SetUniform4f("u_AtlasInfo", (float)m_Header.TileSize, (float)m_Header.Border, padded, padded * m_AtlasTiles);
+}
+
+bool CookVirtualTexture(const unsigned char* pixels, int size, const std::string& output, int tileSize, int border)
+{
+	if (tileSize < MinVirtualTileSize || tileSize > MaxVirtualTileSize)
+		return false;
+	if (!IsPowerOfTwo(size) || !IsPowerOfTwo(tileSize) || tileSize > size || size / tileSize > 256 || border < 0 || border > tileSize)
+		return false;
+	std::ofstream file(output, std::ios::binary);
+	if (!file)
+		return false;
+
+	std::vector<MipLevel> mips = MipGenerator().Generate(pixels, size, size, JobSystem::Get());
+	uint32_t header[6] = { VirtualMagic, VirtualVersion, (uint32_t)size, (uint32_t)tileSize, (uint32_t)border, Log2(size / tileSize) + 1 };
+	file.write((const char*)header, sizeof(header));
+
+	//Borders repeat the neighbouring tiles so bilinear filtering never reads another tile of the atlas
+	int padded = tileSize + 2 * border;
+	std::vector<unsigned char> tile((size_t)padded * padded * 4);
+	for (uint32_t level = 0; level < header[5]; level++) {
+		const unsigned char* data = level ? mips[level - 1].Pixels.data() : pixels;
+		int levelSize = size >> level;
+		int tiles = levelSize / tileSize;
+		for (int ty = 0; ty < tiles; ty++) {
+			for (int tx = 0; tx < tiles; tx++) {
+				for (int y = 0; y < padded; y++) {
+					int sy = std::min(std::max(ty * tileSize + y - border, 0), levelSize - 1);
+					for (int x = 0; x < padded; x++) {
+						int sx = std::min(std::max(tx * tileSize + x - border, 0), levelSize - 1);
+						memcpy(&tile[((size_t)y * padded + x) * 4], &data[((size_t)sy * levelSize + sx) * 4], 4);
+					}
+				}
+				file.write((const char*)tile.data(), tile.size());
+			}
+		}
+	}
+	return file.good();
+}
+
+int CookVirtualTextureFile(const std::string& input, const std::string& output, int tileSize)
+{
+	if (tileSize < MinVirtualTileSize || tileSize > MaxVirtualTileSize || !IsPowerOfTwo(tileSize)) {
+		std::cout << "[virtual] tile size must be a power of two from " << MinVirtualTileSize << " to " << MaxVirtualTileSize << std::endl;
+		return 1;
+	}
+
+	int width, height, channels;
+	stbi_set_flip_vertically_on_load(1);
+	unsigned char* pixels = stbi_load(input.c_str(), &width, &height, &channels, 4);
+	if (!pixels) {
+		std::cout << "[virtual] failed to load " << input << ": " << stbi_failure_reason() << std::endl;
+		return 1;
+	}
+
+	auto start = Clock::now();
+	bool cooked = width == height && CookVirtualTexture(pixels, width, output, tileSize);
+	stbi_image_free(pixels);
+	if (!cooked) {
+		std::cout << "[virtual] " << input << " must be square, a power of two and at most 256 tiles of " << tileSize << " wide" << std::endl;
+		return 1;
+	}
+	std::cout << "[virtual] " << input << " " << width << "x" << height << " -> " << output << ", " << Log2(width / tileSize) + 1
+		<< " levels of " << tileSize << " texel tiles in " << ElapsedMs(start) << " ms" << std::endl;
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "MappedFile.h"
+
+class JobSystem;
+class Shader;
+
+struct VirtualTextureStats {
+	//Last Update: distinct tiles the feedback asked for and how many were already resident
+	unsigned int Requested = 0;
+	unsigned int Hits = 0;
+	unsigned int Uploads = 0;
+	unsigned int Evictions = 0;
+	//Tiles in the atlas and tiles still being read by the workers
+	unsigned int Resident = 0;
+	unsigned int Pending = 0;
+	//Totals since the texture was opened
+	unsigned long long TotalRequested = 0;
+	unsigned long long TotalHits = 0;
+	unsigned long long TotalUploads = 0;
+	unsigned long long BytesUploaded = 0;
+	double UploadMs = 0.0;
+
+	inline float HitRate() const { return TotalRequested ? 100.0f * TotalHits / TotalRequested : 100.0f; }
+	inline double UploadMBPerSecond() const { return UploadMs > 0.0 ? BytesUploaded / (1024.0 * 1024.0) / (UploadMs / 1000.0) : 0.0; }
+};
+
+//Renders the scene once more at a fraction of the screen resolution with the FEEDBACK variant,
+//every pixel writing the tile it would sample. The read back goes through two pixel pack buffers,
+//so Collect returns what was drawn one frame earlier and never waits for the GPU.
+//Tile coordinates are stored in 8 bits: at most 256 tiles per side.
+class VirtualFeedback {
+private:
+	unsigned int m_Framebuffer;
+	unsigned int m_ColorBuffer;
+	unsigned int m_DepthBuffer;
+	unsigned int m_PixelBuffers[2];
+	int m_Width, m_Height;
+	int m_Scale;
+	unsigned int m_Frame;
+	int m_Viewport[4];
+
+public:
+	//Screen size, the buffer is scale times smaller on each side
+	VirtualFeedback(int width, int height, int scale = 8);
+	~VirtualFeedback();
+
+	VirtualFeedback(const VirtualFeedback&) = delete;
+	VirtualFeedback& operator=(const VirtualFeedback&) = delete;
+
+	//Binds and clears the feedback buffer, draw with the FEEDBACK variant in between
+	void Begin();
+	//Starts the read back and restores the default framebuffer
+	void End();
+	//Distinct tile keys from the previous End, coarsest level first. Empty for the first frame.
+	void Collect(std::vector<uint32_t>& tiles);
+
+	//Keeps the level choice of the small buffer the same as on screen
+	float GetLodBias() const;
+	inline int GetWidth() const { return m_Width; }
+	inline int GetHeight() const { return m_Height; }
+};
+
+//Sparse texture for images far larger than what can stay resident. The image is cooked into a
+//square, tiled mip pyramid on disk (CookVirtualTexture). At run time only the tiles the feedback
+//asks for are read, on the job system straight from the mapped file, and copied into a fixed atlas
+//of physical tiles on the GL thread. A page table texture with one texel per tile and one level
+//per mip points every tile at the finest resident tile covering it, so sampling falls back to a
+//coarser level until the real one arrives. Plain GL 3.3: no sparse textures, no bindless.
+class VirtualTexture {
+public:
+	static const unsigned int DefaultAtlasTiles = 16;
+
+private:
+	struct Header {
+		uint32_t Magic;
+		uint32_t Version;
+		uint32_t Size;
+		uint32_t TileSize;
+		uint32_t Border;
+		uint32_t Levels;
+	};
+
+	struct LoadedTile {
+		uint32_t Key;
+		std::vector<unsigned char> Pixels;
+	};
+
+	struct Slot {
+		uint32_t Key = 0;
+		bool Used = false;
+		unsigned int LastUsed = 0;
+	};
+
+	JobSystem& m_Jobs;
+	MappedFile m_File;
+	Header m_Header;
+	unsigned int m_Tiles; //per side on level 0
+	std::vector<size_t> m_LevelOffsets; //first tile of each level
+
+	unsigned int m_AtlasTiles; //per side
+	unsigned int m_Atlas;
+	unsigned int m_PageTable;
+	std::vector<Slot> m_Slots;
+	std::unordered_map<uint32_t, unsigned int> m_Resident;
+	std::unordered_set<uint32_t> m_Requested;
+	std::vector<std::vector<uint32_t>> m_PageEntries;
+	bool m_PageTableDirty;
+
+	//Read by the workers, waiting for the GL thread
+	std::mutex m_Mutex;
+	std::vector<LoadedTile> m_Loaded;
+	std::unordered_set<uint32_t> m_Pending;
+	//Load jobs of this texture still queued or running, the destructor waits on them
+	unsigned int m_InFlight;
+	std::condition_variable m_InFlightCV;
+
+	unsigned int m_Frame;
+	unsigned int m_MaxUploadsPerFrame;
+	unsigned int m_MaxPendingLoads;
+	VirtualTextureStats m_Stats;
+
+public:
+	//atlasTiles per side of the physical atlas, the coarsest tile always keeps one of them
+	VirtualTexture(const std::string& path, unsigned int atlasTiles = DefaultAtlasTiles);
+	~VirtualTexture();
+
+	VirtualTexture(const VirtualTexture&) = delete;
+	VirtualTexture& operator=(const VirtualTexture&) = delete;
+
+	inline bool IsOpen() const { return m_Atlas != 0; }
+
+	//Requests the tiles of the feedback, uploads finished tiles into the atlas and refreshes the
+	//page table. GL thread, once per frame after VirtualFeedback::Collect.
+	void Update(const std::vector<uint32_t>& tiles);
+
+	//Atlas and page table on two texture units, plus the uniforms of include/VirtualTexture.glsl
+	void Bind(Shader& shader, unsigned int atlasSlot = 0, unsigned int pageTableSlot = 1, float lodBias = 0.0f) const;
+
+	inline unsigned int GetSize() const { return m_Header.Size; }
+	inline unsigned int GetTileSize() const { return m_Header.TileSize; }
+	inline unsigned int GetLevelCount() const { return m_Header.Levels; }
+	inline void SetMaxUploadsPerFrame(unsigned int count) { m_MaxUploadsPerFrame = count; }
+	inline const VirtualTextureStats& GetStats() const { return m_Stats; }
+
+	static inline uint32_t MakeKey(unsigned int level, unsigned int x, unsigned int y) { return (level << 24) | (y << 12) | x; }
+
+private:
+	bool Open(const std::string& path);
+	size_t GetTileBytes() const;
+	const unsigned char* GetTileData(uint32_t key) const;
+	void Load(uint32_t key);
+	//Slot for a new tile: a free one, else the least recently used tile not needed this frame
+	bool AllocateSlot(unsigned int& slot);
+	bool UploadTile(const LoadedTile& tile);
+	void RebuildPageTable();
+};
+
+//Tile sizes the cooker takes, powers of two. 16 atlas tiles of the largest still fit a 16K texture.
+const int MinVirtualTileSize = 16;
+const int MaxVirtualTileSize = 512;
+
+//Cuts a square, power of two RGBA8 image (rows bottom first) into tiles with a border of
+//neighbouring texels on each side, for every level of its mip chain
+bool CookVirtualTexture(const unsigned char* pixels, int size, const std::string& output, int tileSize = 128, int border = 4);
+//Command line front end, returns the process exit code
+int CookVirtualTextureFile(const std::string& input, const std::string& output, int tileSize = 128);
\ No newline at end of file